@@ -5,6 +5,7 @@ import (
 	"log"
 	"os"
 	"redis-go/lib/redis"
+	"redis-go/lib/redis/core"
 )
 
 func main() {
@@ -18,6 +19,7 @@ func main() {
 	// go run main.go -raof -waof
 	redis.ReadAOF = flag.Bool("raof", false, "是否使用aof进行初始化")
 	redis.WriteAOF = flag.Bool("waof", false, "是否启动aof协程进行不断持久化")
+	flag.IntVar(&core.SetMaxIntsetEntries, "set-max-intset-entries", core.SetMaxIntsetEntries, "整数集合的最大元素个数，超过时转换为哈希表")
 	flag.Parse()
 
 	redis.Start()
@@ -7,11 +7,8 @@ type RedisDb struct {
 }
 
 func (r *RedisDb) SetKey(key string, val *Object) {
-	if r.LookupKey(key) == nil {
-		r.DbAdd(key, val)
-	} else {
-		r.DbOverwrite(key, val)
-	}
+	// 过期的key直接被覆盖即可，无需先查找再决定插入或更新
+	r.Dict.DictInsertOrUpdate(key, val)
 }
 
 func (r *RedisDb) DbAdd(key string, val *Object) {
@@ -69,12 +66,7 @@ func (r *RedisDb) LookupKeyDel(key string) *Object {
 }
 
 func (r *RedisDb) SetExpire(key string, expire int64) {
-	kde := r.Expires.DictFind(key)
-	if kde == nil {
-		r.Expires.DictAdd(key, expire)
-	} else {
-		r.Expires.DictUpdate(key, expire)
-	}
+	r.Expires.DictInsertOrUpdate(key, expire)
 }
 
 func (r *RedisDb) GetExpire(key string) (time int64, ok bool) {
@@ -87,9 +79,28 @@ func (r *RedisDb) GetExpire(key string) (time int64, ok bool) {
 }
 
 func (r *RedisDb) GetAllKeys() []string {
+	// 按批扫描，每批一次cgo调用，而非每个key回调一次Go
 	keys := make([]string, 0, r.Dict.DictLen())
-	r.Dict.ForEach(func(key string, _item interface{}) {
-		keys = append(keys, key)
-	})
-	return keys
+	var cursor uint64
+	for {
+		next, batch, _ := r.Dict.DictScan(cursor, 1024)
+		keys = append(keys, batch...)
+		if next == 0 {
+			return keys
+		}
+		cursor = next
+	}
+}
+
+// ScanKeys 从cursor开始增量遍历约count个key，返回下一次的游标，游标为0时遍历结束
+// 用于SCAN等分批遍历，每次只占用事件循环很短的时间
+func (r *RedisDb) ScanKeys(cursor uint64, count int) (next uint64, keys []string) {
+	next, keys, _ = r.Dict.DictScan(cursor, count)
+	return
+}
+
+// IncrementallyRehash 利用空闲时间推进字典的渐进式rehash，每个字典至多占用ms毫秒
+func (r *RedisDb) IncrementallyRehash(ms int) {
+	r.Dict.DictRehashMilliseconds(ms)
+	r.Expires.DictRehashMilliseconds(ms)
 }
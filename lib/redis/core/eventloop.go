@@ -1,13 +1,15 @@
 package core
 
 import (
+	"time"
+
 	"github.com/panjf2000/gnet/v2"
 )
 
 type EventLoop struct {
 	Traffic func(c gnet.Conn) (action gnet.Action)
 	Open    func(c gnet.Conn) (out []byte, action gnet.Action)
-	//tick    func() (delay time.Duration, action gnet.Action)
+	Tick    func() (delay time.Duration, action gnet.Action)
 
 	*gnet.BuiltinEventEngine
 }
@@ -22,7 +24,7 @@ func (e *EventLoop) OnTraffic(c gnet.Conn) gnet.Action {
 	return e.Traffic(c)
 }
 
-//// Tick 定时触发
-//func (e *EventLoop) Tick() (delay time.Duration, action gnet.Action) {
-//	return e.tick()
-//}
+// OnTick 定时触发
+func (e *EventLoop) OnTick() (delay time.Duration, action gnet.Action) {
+	return e.Tick()
+}
@@ -1,4 +1,5 @@
 #include "hash_table.h"
+#include "swiss_table.h"
 #include <string>
 
 using namespace std;
@@ -10,58 +11,217 @@ extern "C" {
 #define OK 0
 #define Err 1
 
+// 批量操作时每组的key数：先计算整组的哈希并预取，再依次探测，
+// 使各key的内存访问相互重叠
+const int batch_group = 16;
+
+// 哈希字典，对外隐藏底层哈希表引擎的差异
 class hash_dict {
-    int dict_add(string key);
+public:
+    virtual ~hash_dict() {}
+
+    virtual int dict_add(string_view key, int val) = 0;
+    virtual int dict_find_or_add(string_view key, int val) = 0;
+    virtual int dict_remove(string_view key) = 0;
+    virtual int dict_find(string_view key) = 0;
+    virtual void dict_find_many(const char* buf, const int* lens, int n,
+                                int* vals) = 0;
+    virtual int dict_add_many(const char* buf, const int* lens, int n,
+                              const int* vals, int* status) = 0;
+    virtual int dict_remove_many(const char* buf, const int* lens, int n,
+                                 int* vals) = 0;
+    virtual int dict_len() = 0;
+    virtual void dict_foreach(uintptr_t callback_h) = 0;
+    virtual uint64_t dict_scan(uint64_t cursor, int count,
+                               DictScanResult* res) = 0;
+    virtual int dict_random(size_t n, bool distinct, int* vals) = 0;
+    virtual int dict_rehash_milliseconds(int ms) = 0;
+    virtual slab_stats dict_alloc_stats() = 0;
+};
 
-    hash_table map;
+// 以具体哈希表引擎(hash_table/swiss_table)实现的哈希字典
+template <class Table> class hash_dict_impl : public hash_dict {
+    Table map;
+
+    // 按组遍历buf中的key，对每个key调用op(i, key, hash)
+    template <class Op>
+    void for_each_key(const char* buf, const int* lens, int n, Op op);
 
 public:
-    int dict_add(string key, int val);
-    int dict_remove(string key);
-    int dict_find(string key);
-    int dict_len();
-    void dict_foreach(uintptr_t callback_h);
-    int dict_randomval(const size_t n = 1);
+    int dict_add(string_view key, int val) override;
+    int dict_find_or_add(string_view key, int val) override;
+    int dict_remove(string_view key) override;
+    int dict_find(string_view key) override;
+    void dict_find_many(const char* buf, const int* lens, int n,
+                        int* vals) override;
+    int dict_add_many(const char* buf, const int* lens, int n,
+                      const int* vals, int* status) override;
+    int dict_remove_many(const char* buf, const int* lens, int n,
+                         int* vals) override;
+    int dict_len() override;
+    void dict_foreach(uintptr_t callback_h) override;
+    uint64_t dict_scan(uint64_t cursor, int count,
+                       DictScanResult* res) override;
+    int dict_random(size_t n, bool distinct, int* vals) override;
+    int dict_rehash_milliseconds(int ms) override;
+    slab_stats dict_alloc_stats() override { return map.alloc_stats(); }
 };
 
-int hash_dict::dict_add(string key, int val) {
+template <class Table> int hash_dict_impl<Table>::dict_add(string_view key, int val) {
     auto res = map.insert(key, val);
     return res == hashOk ? OK : Err;
 }
 
-void hash_dict::dict_foreach(uintptr_t callback_h) {
-    for (hash_table_iterator it = map.begin(); it != map.end(); ++it) {
-        goCallbackCharInt(callback_h, (char*)it.key().c_str(), it.val());
+// 已存在则返回原val，否则插入并返回-1
+template <class Table>
+int hash_dict_impl<Table>::dict_find_or_add(string_view key, int val) {
+    bool inserted;
+    int* slot = map.find_or_insert(key, val, inserted);
+    if (slot == nullptr) {
+        return -2;
     }
+    return inserted ? -1 : *slot;
 }
 
-int hash_dict::dict_remove(string key) {
+template <class Table>
+void hash_dict_impl<Table>::dict_foreach(uintptr_t callback_h) {
+    // 遍历期间暂停rehash，避免节点在两个桶数组间移动
+    map.pause_rehash();
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        string_view key = it.keyview();
+        goCallbackKeyVal(callback_h, (char*)key.data(), key.size(), it.val());
+    }
+    map.resume_rehash();
+}
+
+template <class Table>
+uint64_t hash_dict_impl<Table>::dict_scan(uint64_t cursor, int count,
+                                          DictScanResult* res) {
+    string buf;
+    vector<int> lens, vals;
+    auto collect = [&](string_view key, int val) {
+        buf.append(key);
+        lens.push_back(key.size());
+        vals.push_back(val);
+    };
+
+    // 与Redis相同，最多访问count*10个桶，避免在稀疏表上停顿过久
+    long iterations = static_cast<long>(count) * 10;
+    do {
+        cursor = map.scan(cursor, collect);
+    } while (cursor != 0 && --iterations > 0 &&
+             lens.size() < static_cast<size_t>(count));
+
+    res->n = lens.size();
+    res->buf = static_cast<char*>(malloc(buf.size() + 1));
+    res->lens = static_cast<int*>(malloc((lens.size() + 1) * sizeof(int)));
+    res->vals = static_cast<int*>(malloc((vals.size() + 1) * sizeof(int)));
+    memcpy(res->buf, buf.data(), buf.size());
+    memcpy(res->lens, lens.data(), lens.size() * sizeof(int));
+    memcpy(res->vals, vals.data(), vals.size() * sizeof(int));
+    return cursor;
+}
+
+template <class Table> int hash_dict_impl<Table>::dict_remove(string_view key) {
     return map.remove(key);
 }
 
-int hash_dict::dict_find(string key) {
-    hash_table_iterator it = map.find(key);
-    if (it == map.end()) {
+template <class Table> int hash_dict_impl<Table>::dict_find(string_view key) {
+    int val;
+    if (map.findval(key, val) != hashOk) {
         return -1;
     } else {
-        return it.val();
+        return val;
     }
 }
 
-int hash_dict::dict_len() {
-    return map.getSize();
+template <class Table>
+template <class Op>
+void hash_dict_impl<Table>::for_each_key(const char* buf, const int* lens,
+                                         int n, Op op) {
+    string_view keys[batch_group];
+    size_t hashes[batch_group];
+
+    for (int base = 0; base < n; base += batch_group) {
+        int m = min(batch_group, n - base);
+        for (int j = 0; j < m; j++) {
+            keys[j] = string_view(buf, lens[base + j]);
+            buf += lens[base + j];
+            hashes[j] = Table::hashFunction(keys[j]);
+            map.prefetch(hashes[j]);
+        }
+        for (int j = 0; j < m; j++) {
+            map.prefetch_entry(hashes[j]);
+        }
+        for (int j = 0; j < m; j++) {
+            op(base + j, keys[j], hashes[j]);
+        }
+    }
+}
+
+template <class Table>
+void hash_dict_impl<Table>::dict_find_many(const char* buf, const int* lens,
+                                           int n, int* vals) {
+    for_each_key(buf, lens, n, [&](int i, string_view key, size_t hash) {
+        if (map.findval(key, hash, vals[i]) != hashOk)
+            vals[i] = -1;
+    });
+}
+
+template <class Table>
+int hash_dict_impl<Table>::dict_add_many(const char* buf, const int* lens,
+                                         int n, const int* vals,
+                                         int* status) {
+    int added = 0;
+    for_each_key(buf, lens, n, [&](int i, string_view key, size_t hash) {
+        bool inserted;
+        int* slot = map.find_or_insert(key, hash, vals[i], inserted);
+        status[i] = slot != nullptr && inserted ? OK : Err;
+        added += status[i] == OK;
+    });
+    return added;
+}
+
+template <class Table>
+int hash_dict_impl<Table>::dict_remove_many(const char* buf, const int* lens,
+                                            int n, int* vals) {
+    int removed = 0;
+    for_each_key(buf, lens, n, [&](int i, string_view key, size_t hash) {
+        vals[i] = map.remove(key, hash);
+        removed += vals[i] >= 0;
+    });
+    return removed;
+}
+
+template <class Table> int hash_dict_impl<Table>::dict_len() {
+    return map.len();
+}
+
+template <class Table>
+int hash_dict_impl<Table>::dict_random(size_t n, bool distinct, int* vals) {
+    auto its = map.random(n, distinct);
+    for (size_t i = 0; i < its.size(); i++) {
+        vals[i] = its[i].val();
+    }
+    return its.size();
 }
 
-// 不知道怎么返回int或iter列表
-// TODO: 支持查询n个random元素
-int hash_dict::dict_randomval(const size_t n) {
-    vector<hash_table_iterator> its = map.random(n);
-    // 目前只返回一个int
-    return its[0].val();
+template <class Table>
+int hash_dict_impl<Table>::dict_rehash_milliseconds(int ms) {
+    return map.rehash_milliseconds(ms);
 }
 
 void* NewHashDict() {
-    auto hd = new hash_dict();
+    return NewHashDictWithEngine(HASH_DICT_DEFAULT_ENGINE);
+}
+
+void* NewHashDictWithEngine(int engine) {
+    hash_dict* hd;
+    if (engine == DictEngineSwiss) {
+        hd = new hash_dict_impl<swiss_table>();
+    } else {
+        hd = new hash_dict_impl<hash_table>();
+    }
     return static_cast<hash_dict*>(hd);
 }
 
@@ -70,16 +230,37 @@ int ReleaseHashDict(void* hd) {
     return OK;
 }
 
-int DictAdd(void* hd, const char* key, int val) {
-    return static_cast<hash_dict*>(hd)->dict_add(key, val);
+int DictAdd(void* hd, const char* key, size_t len, int val) {
+    return static_cast<hash_dict*>(hd)->dict_add(string_view(key, len), val);
+}
+
+int DictFindOrAdd(void* hd, const char* key, size_t len, int val) {
+    return static_cast<hash_dict*>(hd)->dict_find_or_add(string_view(key, len),
+                                                         val);
+}
+
+int DictRemove(void* hd, const char* key, size_t len) {
+    return static_cast<hash_dict*>(hd)->dict_remove(string_view(key, len));
+}
+
+int DictFind(void* hd, const char* key, size_t len) {
+    return static_cast<hash_dict*>(hd)->dict_find(string_view(key, len));
+}
+
+void DictFindMany(void* hd, const char* buf, const int* lens, int n,
+                  int* vals) {
+    static_cast<hash_dict*>(hd)->dict_find_many(buf, lens, n, vals);
 }
 
-int DictRemove(void* hd, const char* key) {
-    return static_cast<hash_dict*>(hd)->dict_remove(key);
+int DictAddMany(void* hd, const char* buf, const int* lens, int n,
+                const int* vals, int* status) {
+    return static_cast<hash_dict*>(hd)->dict_add_many(buf, lens, n, vals,
+                                                      status);
 }
 
-int DictFind(void* hd, const char* key) {
-    return static_cast<hash_dict*>(hd)->dict_find(key);
+int DictRemoveMany(void* hd, const char* buf, const int* lens, int n,
+                   int* vals) {
+    return static_cast<hash_dict*>(hd)->dict_remove_many(buf, lens, n, vals);
 }
 
 int DictLen(void* hd) {
@@ -90,6 +271,51 @@ void DictForEach(void* hd, uintptr_t callback_h) {
     return static_cast<hash_dict*>(hd)->dict_foreach(callback_h);
 }
 
-int DictRandom(void* hd, const size_t n) {
-    return static_cast<hash_dict*>(hd)->dict_randomval(n);
-}
\ No newline at end of file
+uint64_t DictScan(void* hd, uint64_t cursor, int count, DictScanResult* res) {
+    return static_cast<hash_dict*>(hd)->dict_scan(cursor, count, res);
+}
+
+void DictScanResultFree(DictScanResult* res) {
+    free(res->buf);
+    free(res->lens);
+    free(res->vals);
+    res->buf = nullptr;
+    res->lens = nullptr;
+    res->vals = nullptr;
+    res->n = 0;
+}
+
+int DictRandom(void* hd, size_t n, int distinct, int* vals) {
+    return static_cast<hash_dict*>(hd)->dict_random(n, distinct, vals);
+}
+
+int DictRehashMilliseconds(void* hd, int ms) {
+    return static_cast<hash_dict*>(hd)->dict_rehash_milliseconds(ms);
+}
+
+void DictGetAllocStats(void* hd, DictAllocStats* stats) {
+    slab_stats st = static_cast<hash_dict*>(hd)->dict_alloc_stats();
+    stats->sys_allocs = st.sys_allocs;
+    stats->reserved = st.reserved;
+    stats->used = st.used;
+    stats->objects = st.objects;
+}
+
+uint64_t DictHashKeys(int policy, uint64_t seed, const char* buf,
+                      const int* lens, int n) {
+    uint64_t result = 0;
+    for (int i = 0; i < n; i++) {
+        switch (policy) {
+        case HashPolicyStd:
+            result ^= std_hash_policy::hash(buf, lens[i], seed);
+            break;
+        case HashPolicyXXH3:
+            result ^= xxh3_policy::hash(buf, lens[i], seed);
+            break;
+        default:
+            result ^= wyhash_policy::hash(buf, lens[i], seed);
+        }
+        buf += lens[i];
+    }
+    return result;
+}
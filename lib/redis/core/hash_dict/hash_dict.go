@@ -17,10 +17,29 @@ const (
 	DictErr
 )
 
-//export goCallbackCharInt
-func goCallbackCharInt(h C.uintptr_t, p1 *C.char, p2 C.int) {
-	fn := cgo.Handle(h).Value().(func(*C.char, C.int))
-	fn(p1, p2)
+// 哈希函数
+const (
+	HashPolicyStd    = C.HashPolicyStd
+	HashPolicyWyhash = C.HashPolicyWyhash
+	HashPolicyXXH3   = C.HashPolicyXXH3
+)
+
+// 哈希表引擎
+const (
+	EngineChained = C.DictEngineChained // 链式哈希，渐进式rehash
+	EngineSwiss   = C.DictEngineSwiss   // 开放寻址Swiss table，查找更快、内存更省
+)
+
+//export goCallbackKeyVal
+func goCallbackKeyVal(h C.uintptr_t, key *C.char, len C.size_t, val C.int) {
+	fn := cgo.Handle(h).Value().(func(*C.char, C.size_t, C.int))
+	fn(key, len, val)
+}
+
+// 直接指向Go字符串的字节，不复制也无需释放
+// 字符串不含Go指针，可以在cgo调用期间传给C；C++侧只读且不保留该指针
+func keyPtr(key string) *C.char {
+	return (*C.char)(unsafe.Pointer(unsafe.StringData(key)))
 }
 
 // HashDict
@@ -34,8 +53,17 @@ type HashDict struct {
 	availablePose []int          // objs数组中的可用索引
 }
 
+// NewDict 使用默认引擎创建哈希表
 func NewDict() *HashDict {
-	ptr := C.NewHashDict()
+	return newDict(C.NewHashDict())
+}
+
+// NewDictWithEngine 使用指定引擎创建哈希表
+func NewDictWithEngine(engine int) *HashDict {
+	return newDict(C.NewHashDictWithEngine(C.int(engine)))
+}
+
+func newDict(ptr unsafe.Pointer) *HashDict {
 	dict := &HashDict{ptr: ptr}
 
 	// 注册析构函数
@@ -46,22 +74,35 @@ func NewDict() *HashDict {
 	return dict
 }
 
-func (d *HashDict) DictAdd(key string, val interface{}) int {
-	pos := len(d.objs)
+// 取一个objs中的可用索引(优先复用空余位置)，但暂不占用
+func (d *HashDict) nextPos() int {
+	if len(d.availablePose) > 0 {
+		return d.availablePose[len(d.availablePose)-1]
+	}
+	return len(d.objs)
+}
+
+// 占用nextPos返回的索引并存入val
+func (d *HashDict) takePos(pos int, val interface{}) {
 	if len(d.availablePose) > 0 {
-		// 存在空余的空间
-		pos = d.availablePose[len(d.availablePose)-1]
-		d.objs[pos] = val
 		d.availablePose = d.availablePose[:len(d.availablePose)-1]
+		d.objs[pos] = val
 	} else {
 		d.objs = append(d.objs, val)
 	}
+}
 
-	return int(C.DictAdd(d.ptr, C.CString(key), C.int(pos)))
+func (d *HashDict) DictAdd(key string, val interface{}) int {
+	pos := d.nextPos()
+	res := int(C.DictAdd(d.ptr, keyPtr(key), C.size_t(len(key)), C.int(pos)))
+	if res == DictOk {
+		d.takePos(pos, val)
+	}
+	return res
 }
 
 func (d *HashDict) DictRemove(key string) int {
-	pos := int(C.DictRemove(d.ptr, C.CString(key)))
+	pos := int(C.DictRemove(d.ptr, keyPtr(key), C.size_t(len(key))))
 	if pos >= 0 {
 		d.objs[pos] = nil
 		d.availablePose = append(d.availablePose, pos)
@@ -80,17 +121,24 @@ func (d *HashDict) DictUpdate(key string, val interface{}) int {
 	}
 }
 
+// DictInsertOrUpdate 插入或更新，只需一次cgo调用
 func (d *HashDict) DictInsertOrUpdate(key string, val interface{}) int {
-	if pos := d.dictFind(key); pos < 0 {
-		return d.DictAdd(key, val)
-	} else {
-		d.objs[pos] = val
+	pos := d.nextPos()
+	switch old := int(C.DictFindOrAdd(d.ptr, keyPtr(key), C.size_t(len(key)), C.int(pos))); {
+	case old == -1:
+		// 新插入，占用pos
+		d.takePos(pos, val)
+	case old >= 0:
+		// 已存在，pos未被使用
+		d.objs[old] = val
+	default:
+		return DictErr
 	}
 	return DictOk
 }
 
 func (d *HashDict) dictFind(key string) int {
-	return int(C.DictFind(d.ptr, C.CString(key)))
+	return int(C.DictFind(d.ptr, keyPtr(key), C.size_t(len(key))))
 }
 
 func (d *HashDict) DictFind(key string) interface{} {
@@ -103,7 +151,7 @@ func (d *HashDict) DictFind(key string) interface{} {
 
 // 找到后删除，用于GETDEL指令
 func (d *HashDict) DictFindDel(key string) interface{} {
-	pos := int(C.DictRemove(d.ptr, C.CString(key)))
+	pos := int(C.DictRemove(d.ptr, keyPtr(key), C.size_t(len(key))))
 	if pos < 0 {
 		return nil
 	} else {
@@ -111,16 +159,205 @@ func (d *HashDict) DictFindDel(key string) interface{} {
 	}
 }
 
+// DictFindMany 批量查找，只需一次cgo调用；返回值与keys一一对应，不存在为nil
+func (d *HashDict) DictFindMany(keys []string) []interface{} {
+	res := make([]interface{}, len(keys))
+	if len(keys) == 0 {
+		return res
+	}
+
+	p := packKeys(keys)
+	vals := make([]C.int, len(keys))
+	C.DictFindMany(d.ptr, p.bufPtr(), &p.lens[0], C.int(p.n), &vals[0])
+	for i, pos := range vals {
+		if pos >= 0 {
+			res[i] = d.objs[pos]
+		}
+	}
+	return res
+}
+
+// DictAddMany 批量插入，只需一次cgo调用；返回值与keys一一对应，为DictOk/DictErr(已存在)
+func (d *HashDict) DictAddMany(keys []string, vals []interface{}) []int {
+	res := make([]int, len(keys))
+	if len(keys) == 0 {
+		return res
+	}
+
+	// 预先为每个key占用一个索引，插入失败的再归还
+	poses := make([]C.int, len(keys))
+	for i := range keys {
+		pos := d.nextPos()
+		d.takePos(pos, vals[i])
+		poses[i] = C.int(pos)
+	}
+
+	p := packKeys(keys)
+	status := make([]C.int, len(keys))
+	C.DictAddMany(d.ptr, p.bufPtr(), &p.lens[0], C.int(p.n), &poses[0], &status[0])
+	for i, st := range status {
+		res[i] = int(st)
+		if st != DictOk {
+			d.objs[poses[i]] = nil
+			d.availablePose = append(d.availablePose, int(poses[i]))
+		}
+	}
+	return res
+}
+
+// DictRemoveMany 批量删除，只需一次cgo调用；返回删除的数量
+func (d *HashDict) DictRemoveMany(keys []string) int {
+	if len(keys) == 0 {
+		return 0
+	}
+
+	p := packKeys(keys)
+	vals := make([]C.int, len(keys))
+	removed := C.DictRemoveMany(d.ptr, p.bufPtr(), &p.lens[0], C.int(p.n), &vals[0])
+	for _, pos := range vals {
+		if pos >= 0 {
+			d.objs[pos] = nil
+			d.availablePose = append(d.availablePose, int(pos))
+		}
+	}
+	return int(removed)
+}
+
 func (d *HashDict) DictLen() int {
 	return int(C.DictLen(d.ptr))
 }
 
+// DictRandom 随机抽取n个值
+// distinct为true时返回min(n, len)个互不相同的元素(如SRANDMEMBER的正数count)，
+// 否则有放回地抽取n个(负数count)
+func (d *HashDict) DictRandom(n int, distinct bool) []interface{} {
+	if n <= 0 {
+		return nil
+	}
+	if distinct && n > d.DictLen() {
+		n = d.DictLen()
+	}
+	if n == 0 {
+		return nil
+	}
+
+	vals := make([]C.int, n)
+	dis := C.int(0)
+	if distinct {
+		dis = 1
+	}
+	cnt := int(C.DictRandom(d.ptr, C.size_t(n), dis, &vals[0]))
+
+	res := make([]interface{}, cnt)
+	for i := range res {
+		res[i] = d.objs[vals[i]]
+	}
+	return res
+}
+
+// DictRehashMilliseconds 在ms毫秒内推进渐进式rehash，供空闲时调用，返回迁移的步数
+func (d *HashDict) DictRehashMilliseconds(ms int) int {
+	return int(C.DictRehashMilliseconds(d.ptr, C.int(ms)))
+}
+
+// DictScan 从cursor(首次为0)开始增量遍历，返回本批的key与值及下一次的游标，游标为0时遍历结束
+// 每批约count个元素；遍历期间哈希表可以被修改或扩缩容，
+// 从开始到结束一直存在的元素保证至少返回一次，但可能重复返回
+func (d *HashDict) DictScan(cursor uint64, count int) (next uint64, keys []string, vals []interface{}) {
+	if count <= 0 {
+		count = 1
+	}
+
+	var res C.DictScanResult
+	next = uint64(C.DictScan(d.ptr, C.uint64_t(cursor), C.int(count), &res))
+	defer C.DictScanResultFree(&res)
+
+	n := int(res.n)
+	if n == 0 {
+		return
+	}
+	lens := unsafe.Slice(res.lens, n)
+	cvals := unsafe.Slice(res.vals, n)
+
+	// 整批key一次复制到Go，再切分为各个字符串
+	total := 0
+	for _, l := range lens {
+		total += int(l)
+	}
+	buf := C.GoStringN(res.buf, C.int(total))
+
+	keys = make([]string, n)
+	vals = make([]interface{}, n)
+	off := 0
+	for i := 0; i < n; i++ {
+		keys[i] = buf[off : off+int(lens[i])]
+		vals[i] = d.objs[cvals[i]]
+		off += int(lens[i])
+	}
+	return
+}
+
+// AllocStats 节点与key的内存分配统计
+type AllocStats struct {
+	SysAllocs uint64 // 累计向系统申请内存的次数
+	Reserved  uint64 // 当前向系统申请的字节数
+	Used      uint64 // 当前分配给对象的字节数
+	Objects   uint64 // 当前存活对象数
+}
+
+func (d *HashDict) AllocStats() AllocStats {
+	var st C.DictAllocStats
+	C.DictGetAllocStats(d.ptr, &st)
+	return AllocStats{
+		SysAllocs: uint64(st.sys_allocs),
+		Reserved:  uint64(st.reserved),
+		Used:      uint64(st.used),
+		Objects:   uint64(st.objects),
+	}
+}
+
 func (d *HashDict) ForEach(callback func(key string, item interface{})) {
-	cgoCallback := func(key *C.char, val C.int) {
-		callback(C.GoString(key), d.objs[int(val)])
+	cgoCallback := func(key *C.char, len C.size_t, val C.int) {
+		callback(C.GoStringN(key, C.int(len)), d.objs[int(val)])
 	}
 
 	handle := cgo.NewHandle(cgoCallback)
+	defer handle.Delete()
 
 	C.DictForEach(d.ptr, C.uintptr_t(handle))
 }
+
+// 依次排列的一批key，用于一次cgo调用处理多个key
+type packedKeys struct {
+	buf  []byte
+	lens []C.int
+	n    int
+}
+
+func packKeys(keys []string) *packedKeys {
+	size := 0
+	for _, key := range keys {
+		size += len(key)
+	}
+	p := &packedKeys{
+		buf:  make([]byte, 0, size+1),
+		lens: make([]C.int, len(keys)+1),
+		n:    len(keys),
+	}
+	for i, key := range keys {
+		p.buf = append(p.buf, key...)
+		p.lens[i] = C.int(len(key))
+	}
+	p.buf = append(p.buf, 0)
+	return p
+}
+
+func (p *packedKeys) bufPtr() *C.char {
+	return (*C.char)(unsafe.Pointer(&p.buf[0]))
+}
+
+// 以指定哈希函数计算所有key的哈希并返回其异或，用于校验与基准测试
+func (p *packedKeys) hash(policy int, seed uint64) uint64 {
+	return uint64(C.DictHashKeys(C.int(policy), C.uint64_t(seed),
+		p.bufPtr(), &p.lens[0], C.int(p.n)))
+}
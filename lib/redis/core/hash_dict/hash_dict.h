@@ -1,19 +1,91 @@
+#include <stddef.h>
 #include <stdint.h>
 
-extern void goCallbackCharInt(uintptr_t h, char* p1, int p2);
+extern void goCallbackKeyVal(uintptr_t h, char* key, size_t len, int val);
+
+// 哈希表引擎：链式哈希(渐进式rehash) / 开放寻址Swiss table
+#define DictEngineChained 0
+#define DictEngineSwiss 1
+
+// 编译期可通过 CGO_CXXFLAGS=-DHASH_DICT_DEFAULT_ENGINE=1 切换默认引擎
+#ifndef HASH_DICT_DEFAULT_ENGINE
+#define HASH_DICT_DEFAULT_ENGINE DictEngineChained
+#endif
+
+// 哈希函数(与hash_func.h一致)
+#define HashPolicyStd 0
+#define HashPolicyWyhash 1
+#define HashPolicyXXH3 2
+
+// 节点与key内存分配统计(见slab_allocator.h)
+typedef struct {
+    uint64_t sys_allocs; // 累计向系统申请内存的次数
+    uint64_t reserved;   // 当前向系统申请的字节数
+    uint64_t used;       // 当前分配给对象的字节数
+    uint64_t objects;    // 当前存活对象数
+} DictAllocStats;
+
+// DictScan的结果，内存由C++分配，需以DictScanResultFree释放
+typedef struct {
+    char* buf; // 依次排列的key
+    int* lens; // 各key的长度
+    int* vals; // 各key对应的val
+    int n;     // key的数量
+} DictScanResult;
 
 void* NewHashDict();
 
+void* NewHashDictWithEngine(int engine);
+
 int ReleaseHashDict(void* hd);
 
-int DictAdd(void* hd, const char* key, int val);
+// key以(指针, 长度)传入，可包含'\0'；C++侧不持有该指针，只在插入新key时复制
+int DictAdd(void* hd, const char* key, size_t len, int val);
+
+// 查找key，不存在则插入val，一次调用完成
+// 返回值：已存在时为原val；新插入为-1；分配失败为-2
+int DictFindOrAdd(void* hd, const char* key, size_t len, int val);
+
+int DictRemove(void* hd, const char* key, size_t len);
 
-int DictRemove(void* hd, const char* key);
+int DictFind(void* hd, const char* key, size_t len);
 
-int DictFind(void* hd, const char* key);
+// 批量操作：buf中依次排列n个key，lens[i]为第i个key的长度，一次调用处理所有key
+
+// 批量查找，vals[i]为第i个key对应的val，不存在为-1
+void DictFindMany(void* hd, const char* buf, const int* lens, int n,
+                  int* vals);
+
+// 批量插入，以vals[i]插入第i个key，status[i]为OK/Err(已存在或分配失败)
+// 返回值：插入成功的数量
+int DictAddMany(void* hd, const char* buf, const int* lens, int n,
+                const int* vals, int* status);
+
+// 批量删除，vals[i]为第i个key被删除的val，不存在为-1
+// 返回值：删除的数量
+int DictRemoveMany(void* hd, const char* buf, const int* lens, int n,
+                   int* vals);
 
 int DictLen(void* hd);
 
 void DictForEach(void* hd, uintptr_t callback_h);
 
-int DictRandom(void* hd, const size_t n);
+// 从cursor开始增量遍历，直到收集到count个key、遍历结束或访问了count*10个桶
+// 返回值：下一次的游标，为0表示遍历结束
+// 遍历期间表可以被修改：从开始到结束一直存在的key保证至少返回一次，但可能重复
+uint64_t DictScan(void* hd, uint64_t cursor, int count, DictScanResult* res);
+
+void DictScanResultFree(DictScanResult* res);
+
+// 随机抽取n个val写入vals(容量至少为n)
+// distinct非0时抽取min(n, len)个互不相同的条目，否则有放回地抽取n个
+// 返回值：写入的数量
+int DictRandom(void* hd, size_t n, int distinct, int* vals);
+
+int DictRehashMilliseconds(void* hd, int ms);
+
+void DictGetAllocStats(void* hd, DictAllocStats* stats);
+
+// 以指定哈希函数计算buf中依次排列的n个key的哈希，返回其异或，用于校验与基准测试
+uint64_t DictHashKeys(int policy, uint64_t seed, const char* buf,
+                      const int* lens, int n);
@@ -1,9 +1,32 @@
 package hash_dict
 
-import "testing"
+import (
+	"fmt"
+	"redis-go/lib/redis/core/internal/memstat"
+	"sort"
+	"strconv"
+	"strings"
+	"testing"
+	"time"
+)
+
+var engines = []struct {
+	name   string
+	engine int
+}{
+	{"chained", EngineChained},
+	{"swiss", EngineSwiss},
+}
 
 func TestHashDict(t *testing.T) {
-	dict := NewDict()
+	for _, engine := range engines {
+		t.Run(engine.name, func(t *testing.T) {
+			testDict(t, NewDictWithEngine(engine.engine))
+		})
+	}
+}
+
+func testDict(t *testing.T, dict *HashDict) {
 
 	// 测试添加功能
 	if dict.DictAdd("key1", "value1") != DictOk {
@@ -55,3 +78,557 @@ func TestHashDict(t *testing.T) {
 		t.Errorf("Expected nil, got %v", val)
 	}
 }
+
+func TestHashDictRehash(t *testing.T) {
+	for _, engine := range engines {
+		t.Run(engine.name, func(t *testing.T) {
+			testDictRehash(t, NewDictWithEngine(engine.engine))
+		})
+	}
+}
+
+func testDictRehash(t *testing.T, dict *HashDict) {
+	const n = 10000
+
+	// 奇数使用超过内联长度的长key
+	key := func(i int) string {
+		if i%2 == 1 {
+			return "a-key-longer-than-inline-limit:" + strconv.Itoa(i)
+		}
+		return strconv.Itoa(i)
+	}
+
+	// 扩容过程中穿插查询，所有已插入的键都应能找到
+	for i := 0; i < n; i++ {
+		dict.DictAdd(key(i), i)
+		if val := dict.DictFind(key(i / 2)); val != i/2 {
+			t.Fatalf("Expected %d during expansion, got %v", i/2, val)
+		}
+	}
+	if dict.DictLen() != n {
+		t.Errorf("Expected length %d, got %d", n, dict.DictLen())
+	}
+
+	// 遍历应恰好访问每个键一次
+	seen := make(map[string]bool, n)
+	dict.ForEach(func(key string, _ interface{}) {
+		if seen[key] {
+			t.Errorf("Key %s visited twice", key)
+		}
+		seen[key] = true
+	})
+	if len(seen) != n {
+		t.Errorf("Expected ForEach to visit %d keys, got %d", n, len(seen))
+	}
+
+	// 缩容过程中剩余的键仍应能找到
+	for i := 0; i < n-10; i++ {
+		if dict.DictRemove(key(i)) != DictOk {
+			t.Fatalf("Expected DictOk when removing %d", i)
+		}
+	}
+	dict.DictRehashMilliseconds(1)
+	for i := n - 10; i < n; i++ {
+		if val := dict.DictFind(key(i)); val != i {
+			t.Errorf("Expected %d after shrinking, got %v", i, val)
+		}
+	}
+	if dict.DictLen() != 10 {
+		t.Errorf("Expected length 10, got %d", dict.DictLen())
+	}
+}
+
+// 统计扩容过程中单次插入的尾延迟(p99/p99.9/max)
+func BenchmarkDictAddLatency(b *testing.B) {
+	const n = 1 << 21
+
+	keys := make([]string, n)
+	for i := range keys {
+		keys[i] = strconv.Itoa(i)
+	}
+	latencies := make([]time.Duration, n)
+
+	b.StopTimer()
+	for i := 0; i < b.N; i++ {
+		dict := NewDict()
+
+		b.StartTimer()
+		for j, key := range keys {
+			st := time.Now()
+			dict.DictAdd(key, true)
+			latencies[j] = time.Since(st)
+		}
+		b.StopTimer()
+	}
+
+	sort.Slice(latencies, func(i, j int) bool { return latencies[i] < latencies[j] })
+	b.ReportMetric(float64(latencies[n*99/100].Nanoseconds()), "p99-ns")
+	b.ReportMetric(float64(latencies[n*999/1000].Nanoseconds()), "p99.9-ns")
+	b.ReportMetric(float64(latencies[n-1].Nanoseconds()), "max-ns")
+}
+
+func TestHashDictMany(t *testing.T) {
+	const n = 1000
+	for _, engine := range engines {
+		t.Run(engine.name, func(t *testing.T) {
+			dict := NewDictWithEngine(engine.engine)
+			dict.DictAdd("k0", "old")
+
+			// k0已存在，批内重复的k1第二次插入失败
+			keys := []string{"k1", "k1"}
+			vals := []interface{}{"v1", "dup"}
+			for i := 0; i < n; i++ {
+				keys = append(keys, "k"+strconv.Itoa(i))
+				vals = append(vals, "v"+strconv.Itoa(i))
+			}
+			res := dict.DictAddMany(keys, vals)
+			for i, r := range res {
+				want := DictOk
+				if i == 1 || keys[i] == "k0" || (i > 2 && keys[i] == "k1") {
+					want = DictErr
+				}
+				if r != want {
+					t.Fatalf("DictAddMany(%s) = %d, want %d", keys[i], r, want)
+				}
+			}
+			if dict.DictLen() != n {
+				t.Fatalf("len = %d, want %d", dict.DictLen(), n)
+			}
+
+			found := dict.DictFindMany([]string{"k0", "k1", "k2", "miss", "k999"})
+			want := []interface{}{"old", "v1", "v2", nil, "v999"}
+			for i := range want {
+				if found[i] != want[i] {
+					t.Fatalf("DictFindMany[%d] = %v, want %v", i, found[i], want[i])
+				}
+			}
+
+			if removed := dict.DictRemoveMany([]string{"k0", "k1", "miss", "k1"}); removed != 2 {
+				t.Fatalf("DictRemoveMany removed %d, want 2", removed)
+			}
+			if dict.DictLen() != n-2 || dict.DictFind("k0") != nil || dict.DictFind("k2") != "v2" {
+				t.Fatal("unexpected content after DictRemoveMany")
+			}
+
+			// 失败与删除归还的索引应被复用
+			objs := len(dict.objs)
+			dict.DictAddMany([]string{"a", "b", "c"}, []interface{}{1, 2, 3})
+			if len(dict.objs) != objs {
+				t.Fatalf("objs grew from %d to %d", objs, len(dict.objs))
+			}
+			if len(dict.DictFindMany(nil)) != 0 || dict.DictRemoveMany(nil) != 0 {
+				t.Fatal("empty batch should be a no-op")
+			}
+		})
+	}
+}
+
+// key按长度传递，可以包含'\x00'，且插入时复制，不引用Go的内存
+func TestHashDictBinaryKey(t *testing.T) {
+	keys := []string{"", "\x00", "\x00\x00", "a\x00b", "a\x00c", "a", "long\x00key\x00with\x00zeros!!"}
+	for _, engine := range engines {
+		t.Run(engine.name, func(t *testing.T) {
+			dict := NewDictWithEngine(engine.engine)
+			for i, key := range keys {
+				if dict.DictAdd(key, i) != DictOk {
+					t.Fatalf("DictAdd(%q) failed", key)
+				}
+			}
+			for i, key := range keys {
+				if got := dict.DictFind(key); got != i {
+					t.Fatalf("DictFind(%q) = %v, want %d", key, got, i)
+				}
+			}
+
+			// 修改用于插入的字节，不应影响表中的key
+			buf := []byte("mutable-key-longer-than-16")
+			dict.DictAdd(string(buf), "m")
+			buf[0] = 'X'
+			if dict.DictFind("mutable-key-longer-than-16") != "m" {
+				t.Fatal("key was not copied on insert")
+			}
+
+			seen := map[string]bool{}
+			dict.ForEach(func(key string, _ interface{}) {
+				seen[key] = true
+			})
+			for _, key := range keys {
+				if !seen[key] {
+					t.Fatalf("ForEach missed %q", key)
+				}
+			}
+
+			if dict.DictRemove("a\x00b") != DictOk || dict.DictFind("a\x00c") != 4 || dict.DictFind("a") != 5 {
+				t.Fatal("removing a key with NUL affected its prefixes")
+			}
+		})
+	}
+}
+
+func TestHashDictRandom(t *testing.T) {
+	for _, engine := range engines {
+		t.Run(engine.name, func(t *testing.T) {
+			dict := NewDictWithEngine(engine.engine)
+			if len(dict.DictRandom(3, false)) != 0 || len(dict.DictRandom(3, true)) != 0 {
+				t.Fatal("random on empty dict should return nil")
+			}
+
+			const n = 1000
+			for i := 0; i < n; i++ {
+				dict.DictAdd(strconv.Itoa(i), i)
+			}
+
+			if got := dict.DictRandom(5000, false); len(got) != 5000 {
+				t.Fatalf("with replacement: got %d values, want 5000", len(got))
+			}
+			// 依次覆盖逐个抽取去重、蓄水池抽样与返回全部元素三种情况
+			for _, cnt := range []int{10, 600, n, 2 * n} {
+				got := dict.DictRandom(cnt, true)
+				want := min(cnt, n)
+				seen := map[int]bool{}
+				for _, v := range got {
+					seen[v.(int)] = true
+				}
+				if len(got) != want || len(seen) != want {
+					t.Fatalf("distinct %d: got %d values (%d unique), want %d", cnt, len(got), len(seen), want)
+				}
+			}
+
+			// 卡方检验：100个元素，每个期望被抽中2000次
+			for i := 100; i < n; i++ {
+				dict.DictRemove(strconv.Itoa(i))
+			}
+			const draws = 200000
+			counts := make([]int, 100)
+			for _, v := range dict.DictRandom(draws, false) {
+				counts[v.(int)]++
+			}
+			chi2 := 0.0
+			for _, c := range counts {
+				d := float64(c) - draws/100
+				chi2 += d * d / (draws / 100)
+			}
+			// 自由度99，显著性水平0.0001的临界值约为157
+			if chi2 > 157 {
+				t.Fatalf("samples are not uniform: chi2 = %.1f", chi2)
+			}
+		})
+	}
+}
+
+// 扫描全表，每批之间调用between，返回每个key被返回的次数
+func scanAll(dict *HashDict, count int, between func()) map[string]int {
+	seen := map[string]int{}
+	var cursor uint64
+	for {
+		next, keys, vals := dict.DictScan(cursor, count)
+		for i, key := range keys {
+			if vals[i] != key {
+				panic("DictScan returned mismatched key and value")
+			}
+			seen[key]++
+		}
+		if next == 0 {
+			return seen
+		}
+		cursor = next
+		between()
+	}
+}
+
+func TestHashDictScan(t *testing.T) {
+	for _, engine := range engines {
+		t.Run(engine.name, func(t *testing.T) {
+			dict := NewDictWithEngine(engine.engine)
+			if next, keys, _ := dict.DictScan(0, 10); next != 0 || len(keys) != 0 {
+				t.Fatal("scan on empty dict should finish immediately")
+			}
+
+			// 表不变时每个key恰好返回一次
+			const n = 10000
+			for i := 0; i < n; i++ {
+				dict.DictAdd("k"+strconv.Itoa(i), "k"+strconv.Itoa(i))
+			}
+			seen := scanAll(dict, 100, func() {})
+			if len(seen) != n {
+				t.Fatalf("static scan returned %d keys, want %d", len(seen), n)
+			}
+			for key, c := range seen {
+				if c != 1 {
+					t.Fatalf("static scan returned %s %d times", key, c)
+				}
+			}
+
+			// 扫描期间不断插入，表多次扩容(插入总量有上限，否则扫描追不上增长)
+			grow := NewDictWithEngine(engine.engine)
+			for i := 0; i < 1000; i++ {
+				grow.DictAdd("k"+strconv.Itoa(i), "k"+strconv.Itoa(i))
+			}
+			next := 1000
+			seen = scanAll(grow, 10, func() {
+				for i := 0; i < 200 && next < 50000; i++ {
+					key := "k" + strconv.Itoa(next)
+					grow.DictAdd(key, key)
+					next++
+				}
+			})
+			for i := 0; i < 1000; i++ {
+				if seen["k"+strconv.Itoa(i)] == 0 {
+					t.Fatalf("scan during growth missed k%d", i)
+				}
+			}
+
+			// 扫描期间不断删除其他key，表多次缩容
+			shrink := NewDictWithEngine(engine.engine)
+			for i := 0; i < 50000; i++ {
+				shrink.DictAdd("k"+strconv.Itoa(i), "k"+strconv.Itoa(i))
+			}
+			victim := 500
+			seen = scanAll(shrink, 10, func() {
+				for i := 0; i < 1000 && victim < 50000; i++ {
+					shrink.DictRemove("k" + strconv.Itoa(victim))
+					victim++
+				}
+			})
+			for i := 0; i < 500; i++ {
+				if seen["k"+strconv.Itoa(i)] == 0 {
+					t.Fatalf("scan during shrink missed k%d", i)
+				}
+			}
+		})
+	}
+}
+
+// 删除后的节点内存应被复用，清空前不再向系统申请
+func TestHashDictAlloc(t *testing.T) {
+	const n = 10000
+	key := func(i int) string { return fmt.Sprintf("session:%032d", i) }
+
+	for _, engine := range engines {
+		t.Run(engine.name, func(t *testing.T) {
+			dict := NewDictWithEngine(engine.engine)
+			for i := 0; i < n; i++ {
+				dict.DictAdd(key(i), i)
+			}
+			st := dict.AllocStats()
+			if st.Objects != n {
+				t.Fatalf("objects = %d, want %d", st.Objects, n)
+			}
+			if st.Used > st.Reserved {
+				t.Fatalf("used %d > reserved %d", st.Used, st.Reserved)
+			}
+
+			for i := 0; i < n; i++ {
+				dict.DictRemove(key(i))
+			}
+			if got := dict.AllocStats(); got.Objects != 0 || got.Used != 0 {
+				t.Fatalf("after remove: objects = %d, used = %d", got.Objects, got.Used)
+			}
+
+			for i := n; i < 2*n; i++ {
+				dict.DictAdd(key(i), i)
+			}
+			if got := dict.AllocStats(); got.SysAllocs != st.SysAllocs {
+				t.Fatalf("sys allocs grew from %d to %d on churn", st.SysAllocs, got.SysAllocs)
+			}
+			for i := n; i < 2*n; i++ {
+				if dict.DictFind(key(i)) != i {
+					t.Fatalf("find %s failed", key(i))
+				}
+			}
+		})
+	}
+}
+
+// XXH3结果需与xxHash官方实现一致
+func TestHashPolicy(t *testing.T) {
+	long := strings.Repeat("redis-go", 125)
+	cases := []struct {
+		key  string
+		seed uint64
+		want uint64
+	}{
+		{"", 0, 0x2d06800538d394c2},
+		{"hello", 0, 0x9555e8555c62dcfd},
+		{"hello", 42, 0xbafa072f07db7937},
+		{long[:40], 42, 0x624f771ff6d2bef8},
+		{long[:150], 42, 0x1c809b6ae776b76a},
+		{long, 0, 0x9e34c15c79daf019},
+		{long, 42, 0xb9966ba46e1dc19c},
+	}
+	for _, c := range cases {
+		if got := packKeys([]string{c.key}).hash(HashPolicyXXH3, c.seed); got != c.want {
+			t.Errorf("xxh3(len=%d, seed=%d) = %#x, want %#x", len(c.key), c.seed, got, c.want)
+		}
+	}
+
+	// 带种子的哈希函数，种子不同结果应不同
+	for _, policy := range []int{HashPolicyWyhash, HashPolicyXXH3} {
+		for _, key := range []string{"", "a", "hello", long} {
+			if packKeys([]string{key}).hash(policy, 1) == packKeys([]string{key}).hash(policy, 2) {
+				t.Errorf("policy %d: seed has no effect on key of len %d", policy, len(key))
+			}
+		}
+	}
+}
+
+// 各哈希函数在不同key长度下的耗时，每次cgo调用计算一批key以摊薄调用开销
+func BenchmarkHashFunctions(b *testing.B) {
+	const batch = 1024
+
+	policies := []struct {
+		name   string
+		policy int
+	}{
+		{"std", HashPolicyStd},
+		{"wyhash", HashPolicyWyhash},
+		{"xxh3", HashPolicyXXH3},
+	}
+	keySets := []struct {
+		name string
+		key  func(i int) string
+	}{
+		{"int", func(i int) string { return strconv.Itoa(i) }},
+		{"short", func(i int) string { return fmt.Sprintf("user:%08d", i) }},
+		{"long", func(i int) string { return fmt.Sprintf("%0256d", i) }},
+	}
+
+	for _, ks := range keySets {
+		keys := make([]string, batch)
+		for i := range keys {
+			keys[i] = ks.key(i)
+		}
+		packed := packKeys(keys)
+		for _, p := range policies {
+			b.Run(p.name+"/"+ks.name, func(b *testing.B) {
+				for i := 0; i < b.N; i++ {
+					packed.hash(p.policy, uint64(i))
+				}
+				b.ReportMetric(float64(b.Elapsed().Nanoseconds())/float64(b.N*batch), "ns/key")
+			})
+		}
+	}
+}
+
+// 查找已存在/不存在的键
+func BenchmarkDictFind(b *testing.B) {
+	const n = 1 << 20
+
+	keys := make([]string, n)
+	for i := range keys {
+		keys[i] = strconv.Itoa(i)
+	}
+
+	for _, engine := range engines {
+		dict := NewDictWithEngine(engine.engine)
+		for _, key := range keys {
+			dict.DictAdd(key, true)
+		}
+
+		b.Run(engine.name+"/hit", func(b *testing.B) {
+			for i := 0; i < b.N; i++ {
+				dict.DictFind(keys[i&(n-1)])
+			}
+		})
+		b.Run(engine.name+"/miss", func(b *testing.B) {
+			for i := 0; i < b.N; i++ {
+				dict.DictFind("miss:" + keys[i&(n-1)])
+			}
+		})
+	}
+}
+
+// 批量查找与逐个查找的对比，指标为每个key的耗时
+func BenchmarkDictFindMany(b *testing.B) {
+	const n = 1 << 20
+
+	keys := make([]string, n)
+	for i := range keys {
+		keys[i] = "key:" + strconv.Itoa(i*7919%n)
+	}
+
+	for _, engine := range engines {
+		dict := NewDictWithEngine(engine.engine)
+		for _, key := range keys {
+			dict.DictAdd(key, true)
+		}
+
+		for _, batch := range []int{16, 128} {
+			b.Run(fmt.Sprintf("%s/single/%d", engine.name, batch), func(b *testing.B) {
+				for i := 0; i < b.N; i++ {
+					base := i * batch & (n - 1)
+					for _, key := range keys[base : base+batch] {
+						dict.DictFind(key)
+					}
+				}
+				b.ReportMetric(float64(b.Elapsed().Nanoseconds())/float64(b.N*batch), "ns/key")
+			})
+			b.Run(fmt.Sprintf("%s/many/%d", engine.name, batch), func(b *testing.B) {
+				for i := 0; i < b.N; i++ {
+					base := i * batch & (n - 1)
+					dict.DictFindMany(keys[base : base+batch])
+				}
+				b.ReportMetric(float64(b.Elapsed().Nanoseconds())/float64(b.N*batch), "ns/key")
+			})
+		}
+	}
+}
+
+// 大表上的随机抽取
+func BenchmarkDictRandom(b *testing.B) {
+	const n = 1 << 20
+	for _, engine := range engines {
+		dict := NewDictWithEngine(engine.engine)
+		for i := 0; i < n; i++ {
+			dict.DictAdd(strconv.Itoa(i), i)
+		}
+		for _, cnt := range []int{1, 16} {
+			b.Run(fmt.Sprintf("%s/%d", engine.name, cnt), func(b *testing.B) {
+				for i := 0; i < b.N; i++ {
+					dict.DictRandom(cnt, true)
+				}
+			})
+		}
+	}
+}
+
+// SET路径：一半新插入、一半覆盖
+func BenchmarkDictInsertOrUpdate(b *testing.B) {
+	for _, engine := range engines {
+		b.Run(engine.name, func(b *testing.B) {
+			dict := NewDictWithEngine(engine.engine)
+			for i := 0; i < b.N; i++ {
+				dict.DictInsertOrUpdate(strconv.Itoa(i>>1), i)
+			}
+		})
+	}
+}
+
+// 会话缓存式的增删：保持live个长key，每次删除最旧的一个并插入一个新的
+// 例: go test -bench DictChurn/chained -benchtime=10000000x
+func BenchmarkDictChurn(b *testing.B) {
+	const live = 1 << 20
+	key := func(i int) string { return fmt.Sprintf("session:%032x", i) }
+
+	for _, engine := range engines {
+		b.Run(engine.name, func(b *testing.B) {
+			dict := NewDictWithEngine(engine.engine)
+			for i := 0; i < live; i++ {
+				dict.DictAdd(key(i), i)
+			}
+			before := dict.AllocStats()
+
+			b.ResetTimer()
+			for i := 0; i < b.N; i++ {
+				dict.DictRemove(key(i))
+				dict.DictAdd(key(i+live), i)
+			}
+			b.StopTimer()
+
+			after := dict.AllocStats()
+			b.ReportMetric(float64(after.SysAllocs-before.SysAllocs), "sys-allocs")
+			b.ReportMetric(float64(after.Reserved)/(1<<20), "reserved-MB")
+			b.ReportMetric(float64(memstat.RSS())/(1<<20), "rss-MB")
+		})
+	}
+}
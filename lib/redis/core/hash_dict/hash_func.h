@@ -0,0 +1,394 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string_view>
+
+using namespace std;
+
+// 哈希函数
+// 每种哈希函数为一个policy，提供 hash(data, len, seed)
+// 编译期以 HASH_DICT_HASH_POLICY 选择哈希表使用的policy:
+//   0: std::hash，不支持种子，无法抵御哈希洪水攻击，仅作对照
+//   1: wyhash(默认)，短key最快
+//   2: XXH3，长key吞吐最高
+
+#define HashPolicyStd 0
+#define HashPolicyWyhash 1
+#define HashPolicyXXH3 2
+
+#ifndef HASH_DICT_HASH_POLICY
+#define HASH_DICT_HASH_POLICY HashPolicyWyhash
+#endif
+
+namespace hash_func {
+
+static inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint64_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+// 64x64->128位乘法，返回高低位
+static inline void mul128(uint64_t& lo, uint64_t& hi) {
+    __uint128_t r = static_cast<__uint128_t>(lo) * hi;
+    lo = static_cast<uint64_t>(r);
+    hi = static_cast<uint64_t>(r >> 64);
+}
+
+// 128位乘积的高低位异或
+static inline uint64_t mul128_fold64(uint64_t a, uint64_t b) {
+    mul128(a, b);
+    return a ^ b;
+}
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+} // namespace hash_func
+
+// std::hash
+struct std_hash_policy {
+    static inline uint64_t hash(const char* data, size_t len, uint64_t seed) {
+        static std::hash<string_view> hash_fn;
+        return hash_fn(string_view(data, len));
+    }
+};
+
+// wyhash(final4)
+// https://github.com/wangyi-fudan/wyhash
+struct wyhash_policy {
+    static inline uint64_t mix(uint64_t a, uint64_t b) {
+        return hash_func::mul128_fold64(a, b);
+    }
+
+    // 1~3字节的读取：首、中、尾三个字节
+    static inline uint64_t read3(const uint8_t* p, size_t k) {
+        return (static_cast<uint64_t>(p[0]) << 16) |
+               (static_cast<uint64_t>(p[k >> 1]) << 8) | p[k - 1];
+    }
+
+    static inline uint64_t hash(const char* data, size_t len, uint64_t seed) {
+        using namespace hash_func;
+        static const uint64_t secret[4] = {
+            0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+            0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+        seed ^= mix(seed ^ secret[0], secret[1]);
+        uint64_t a, b;
+        if (len <= 16) {
+            if (len >= 4) {
+                a = (read32(p) << 32) | read32(p + ((len >> 3) << 2));
+                b = (read32(p + len - 4) << 32) |
+                    read32(p + len - 4 - ((len >> 3) << 2));
+            } else if (len > 0) {
+                a = read3(p, len);
+                b = 0;
+            } else {
+                a = b = 0;
+            }
+        } else {
+            size_t i = len;
+            if (i >= 48) {
+                uint64_t see1 = seed, see2 = seed;
+                do {
+                    seed = mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+                    see1 = mix(read64(p + 16) ^ secret[2],
+                               read64(p + 24) ^ see1);
+                    see2 = mix(read64(p + 32) ^ secret[3],
+                               read64(p + 40) ^ see2);
+                    p += 48;
+                    i -= 48;
+                } while (i >= 48);
+                seed ^= see1 ^ see2;
+            }
+            while (i > 16) {
+                seed = mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+                i -= 16;
+                p += 16;
+            }
+            a = read64(p + i - 16);
+            b = read64(p + i - 8);
+        }
+        a ^= secret[1];
+        b ^= seed;
+        mul128(a, b);
+        return mix(a ^ secret[0] ^ len, b ^ secret[1]);
+    }
+};
+
+// XXH3 64位(标量实现)，与xxHash 0.8的XXH3_64bits_withSeed结果一致
+// https://github.com/Cyan4973/xxHash
+struct xxh3_policy {
+    static const uint64_t prime32_1 = 0x9E3779B1U;
+    static const uint64_t prime32_2 = 0x85EBCA77U;
+    static const uint64_t prime32_3 = 0xC2B2AE3DU;
+    static const uint64_t prime64_1 = 0x9E3779B185EBCA87ULL;
+    static const uint64_t prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+    static const uint64_t prime64_3 = 0x165667B19E3779F9ULL;
+    static const uint64_t prime64_4 = 0x85EBCA77C2B2AE63ULL;
+    static const uint64_t prime64_5 = 0x27D4EB2F165667C5ULL;
+
+    static const size_t secret_size = 192;
+    static const size_t stripe_len = 64;
+
+    static inline const uint8_t* default_secret() {
+        alignas(64) static const uint8_t secret[secret_size] = {
+            0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81,
+            0x2c, 0xf7, 0x21, 0xad, 0x1c, 0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90,
+            0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f, 0xcb,
+            0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d,
+            0xcc, 0xff, 0x72, 0x21, 0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24,
+            0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c, 0x3c, 0x28,
+            0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b,
+            0x53, 0x2e, 0xa3, 0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e,
+            0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8, 0xa8, 0xfa, 0x76,
+            0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b,
+            0x4f, 0x1d, 0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8,
+            0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64, 0xea, 0xc5, 0xac, 0x83,
+            0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63,
+            0xeb, 0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16,
+            0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e, 0x2b, 0x16, 0xbe, 0x58, 0x7d,
+            0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+            0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb,
+            0xca, 0xbb, 0x4b, 0x40, 0x7e,
+        };
+        return secret;
+    }
+
+    static inline uint64_t xxh64_avalanche(uint64_t h) {
+        h ^= h >> 33;
+        h *= prime64_2;
+        h ^= h >> 29;
+        h *= prime64_3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    static inline uint64_t avalanche(uint64_t h) {
+        h ^= h >> 37;
+        h *= 0x165667919E3779F9ULL;
+        h ^= h >> 32;
+        return h;
+    }
+
+    static inline uint64_t rrmxmx(uint64_t h, size_t len) {
+        h ^= hash_func::rotl64(h, 49) ^ hash_func::rotl64(h, 24);
+        h *= 0x9FB21C651E98DF25ULL;
+        h ^= (h >> 35) + len;
+        h *= 0x9FB21C651E98DF25ULL;
+        return h ^ (h >> 28);
+    }
+
+    static inline uint64_t mix16(const uint8_t* in, const uint8_t* sec,
+                                 uint64_t seed) {
+        using namespace hash_func;
+        return mul128_fold64(read64(in) ^ (read64(sec) + seed),
+                             read64(in + 8) ^ (read64(sec + 8) - seed));
+    }
+
+    static inline uint64_t hash_0to16(const uint8_t* p, size_t len,
+                                      const uint8_t* sec, uint64_t seed) {
+        using namespace hash_func;
+        if (len > 8) {
+            uint64_t bitflip1 = (read64(sec + 24) ^ read64(sec + 32)) + seed;
+            uint64_t bitflip2 = (read64(sec + 40) ^ read64(sec + 48)) - seed;
+            uint64_t lo = read64(p) ^ bitflip1;
+            uint64_t hi = read64(p + len - 8) ^ bitflip2;
+            uint64_t acc =
+                len + __builtin_bswap64(lo) + hi + mul128_fold64(lo, hi);
+            return avalanche(acc);
+        }
+        if (len >= 4) {
+            seed ^= static_cast<uint64_t>(
+                        __builtin_bswap32(static_cast<uint32_t>(seed)))
+                    << 32;
+            uint64_t in1 = read32(p);
+            uint64_t in2 = read32(p + len - 4);
+            uint64_t bitflip = (read64(sec + 8) ^ read64(sec + 16)) - seed;
+            uint64_t in64 = in2 + (in1 << 32);
+            return rrmxmx(in64 ^ bitflip, len);
+        }
+        if (len > 0) {
+            uint32_t combined = (static_cast<uint32_t>(p[0]) << 16) |
+                                (static_cast<uint32_t>(p[len >> 1]) << 24) |
+                                static_cast<uint32_t>(p[len - 1]) |
+                                (static_cast<uint32_t>(len) << 8);
+            uint64_t bitflip = (read32(sec) ^ read32(sec + 4)) + seed;
+            return xxh64_avalanche(combined ^ bitflip);
+        }
+        return xxh64_avalanche(seed ^ (read64(sec + 56) ^ read64(sec + 64)));
+    }
+
+    static inline uint64_t hash_17to128(const uint8_t* p, size_t len,
+                                        const uint8_t* sec, uint64_t seed) {
+        uint64_t acc = len * prime64_1;
+        if (len > 32) {
+            if (len > 64) {
+                if (len > 96) {
+                    acc += mix16(p + 48, sec + 96, seed);
+                    acc += mix16(p + len - 64, sec + 112, seed);
+                }
+                acc += mix16(p + 32, sec + 64, seed);
+                acc += mix16(p + len - 48, sec + 80, seed);
+            }
+            acc += mix16(p + 16, sec + 32, seed);
+            acc += mix16(p + len - 32, sec + 48, seed);
+        }
+        acc += mix16(p, sec, seed);
+        acc += mix16(p + len - 16, sec + 16, seed);
+        return avalanche(acc);
+    }
+
+    static inline uint64_t hash_129to240(const uint8_t* p, size_t len,
+                                         const uint8_t* sec, uint64_t seed) {
+        uint64_t acc = len * prime64_1;
+        size_t rounds = len / 16;
+        for (size_t i = 0; i < 8; i++)
+            acc += mix16(p + 16 * i, sec + 16 * i, seed);
+        acc = avalanche(acc);
+        for (size_t i = 8; i < rounds; i++)
+            acc += mix16(p + 16 * i, sec + 16 * (i - 8) + 3, seed);
+        acc += mix16(p + len - 16, sec + 136 - 17, seed);
+        return avalanche(acc);
+    }
+
+    static inline void accumulate_512(uint64_t* acc, const uint8_t* in,
+                                      const uint8_t* sec) {
+        using namespace hash_func;
+        for (size_t i = 0; i < 8; i++) {
+            uint64_t data_val = read64(in + 8 * i);
+            uint64_t data_key = data_val ^ read64(sec + 8 * i);
+            acc[i ^ 1] += data_val;
+            acc[i] += (data_key & 0xFFFFFFFFULL) * (data_key >> 32);
+        }
+    }
+
+    static inline void scramble(uint64_t* acc, const uint8_t* sec) {
+        for (size_t i = 0; i < 8; i++) {
+            uint64_t a = acc[i];
+            a ^= a >> 47;
+            a ^= hash_func::read64(sec + 8 * i);
+            a *= prime32_1;
+            acc[i] = a;
+        }
+    }
+
+    static inline uint64_t hash_long(const uint8_t* p, size_t len,
+                                     const uint8_t* sec) {
+        using namespace hash_func;
+        uint64_t acc[8] = {prime32_3, prime64_1, prime64_2, prime64_3,
+                           prime64_4, prime32_2, prime64_5, prime32_1};
+        const size_t stripes_per_block = (secret_size - stripe_len) / 8;
+        const size_t block_len = stripe_len * stripes_per_block;
+        const size_t blocks = (len - 1) / block_len;
+
+        for (size_t n = 0; n < blocks; n++) {
+            for (size_t s = 0; s < stripes_per_block; s++)
+                accumulate_512(acc, p + n * block_len + s * stripe_len,
+                               sec + s * 8);
+            scramble(acc, sec + secret_size - stripe_len);
+        }
+
+        // 最后一个不完整的block与最后一个stripe
+        const size_t stripes =
+            ((len - 1) - block_len * blocks) / stripe_len;
+        for (size_t s = 0; s < stripes; s++)
+            accumulate_512(acc, p + blocks * block_len + s * stripe_len,
+                           sec + s * 8);
+        accumulate_512(acc, p + len - stripe_len,
+                       sec + secret_size - stripe_len - 7);
+
+        uint64_t result = len * prime64_1;
+        for (size_t i = 0; i < 4; i++)
+            result += mul128_fold64(acc[2 * i] ^ read64(sec + 11 + 16 * i),
+                                    acc[2 * i + 1] ^
+                                        read64(sec + 11 + 16 * i + 8));
+        return avalanche(result);
+    }
+
+    static inline uint64_t hash(const char* data, size_t len, uint64_t seed) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+        const uint8_t* sec = default_secret();
+        if (len <= 16)
+            return hash_0to16(p, len, sec, seed);
+        if (len <= 128)
+            return hash_17to128(p, len, sec, seed);
+        if (len <= 240)
+            return hash_129to240(p, len, sec, seed);
+
+        // 长输入由种子派生出专用secret
+        if (seed == 0)
+            return hash_long(p, len, sec);
+        alignas(64) uint8_t custom[secret_size];
+        for (size_t i = 0; i < secret_size / 16; i++) {
+            uint64_t lo = hash_func::read64(sec + 16 * i) + seed;
+            uint64_t hi = hash_func::read64(sec + 16 * i + 8) - seed;
+            memcpy(custom + 16 * i, &lo, 8);
+            memcpy(custom + 16 * i + 8, &hi, 8);
+        }
+        return hash_long(p, len, custom);
+    }
+};
+
+#if HASH_DICT_HASH_POLICY == HashPolicyStd
+typedef std_hash_policy hash_policy;
+#elif HASH_DICT_HASH_POLICY == HashPolicyXXH3
+typedef xxh3_policy hash_policy;
+#else
+typedef wyhash_policy hash_policy;
+#endif
+
+// 进程级随机哈希种子，使外部无法构造必然冲突的key(哈希洪水攻击)
+inline uint64_t hash_seed() {
+    static const uint64_t seed = [] {
+        random_device rd;
+        return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+    }();
+    return seed;
+}
+
+// 线程局部的快速伪随机数生成器(wyrand)，用于随机采样，不可用于安全场景
+// 各线程的初始状态由进程种子与线程局部变量地址混合得到
+inline uint64_t fast_rand() {
+    thread_local uint64_t state =
+        hash_seed() ^ reinterpret_cast<uintptr_t>(&state);
+    state += 0xa0761d6478bd642full;
+    return hash_func::mul128_fold64(state, state ^ 0xe7037ed1a0b428dbull);
+}
+
+// [0, n)内的随机数，以乘法取高位代替取余(Lemire)，偏差可忽略
+inline uint64_t fast_rand_below(uint64_t n) {
+    return static_cast<uint64_t>(
+        (static_cast<__uint128_t>(fast_rand()) * n) >> 64);
+}
+
+// 按位反转，用于SCAN游标的反向二进制递增
+inline unsigned long rev_bits(unsigned long v) {
+    unsigned long s = 8 * sizeof(v);
+    unsigned long mask = ~0UL;
+    while ((s >>= 1) > 0) {
+        mask ^= (mask << s);
+        v = ((v >> s) & mask) | ((v << s) & ~mask);
+    }
+    return v;
+}
+
+// 游标在mask覆盖的低位中按反向二进制加一(从高位进位)
+// 表扩缩容为2的幂时，已扫描过的桶在新表中对应的桶仍排在游标之前
+inline unsigned long scan_next_cursor(unsigned long v, unsigned long mask) {
+    v |= ~mask;
+    v = rev_bits(v);
+    v++;
+    return rev_bits(v);
+}
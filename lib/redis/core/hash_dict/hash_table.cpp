@@ -1,106 +1,155 @@
 #include "hash_table.h"
 
-hash_table_iterator hash_table::find(const string& key) {
-    if (size == 0) // 哈希表为空
-        return nullptr;
-
-    unsigned long index = hashFunction(key) & sizemask; // 计算哈希表索引
-
-    hash_entry* entry = table[index];
-    while (entry != nullptr) {
-        if (entry->key == key) {
-            return hash_table_iterator(this, index, entry);
-        }
-        entry = entry->next; // 找到匹配的键，返回对应的条目
+bool hash_table::init_bucket_table(hash_bucket_table& t, unsigned long size) {
+    // 使用calloc而非new[]()：大块内存直接映射零页，不必在分配时逐页清零，
+    // 否则扩容开始时仍会有一次与桶数组大小成正比的停顿
+    t.table = size > 0 ? static_cast<hash_entry**>(calloc(size, sizeof(hash_entry*)))
+                       : nullptr;
+    if (size > 0 && t.table == nullptr) {
+        std::cerr << "Memory allocation failed during hash_table init" << endl;
+        return false;
     }
+    t.size = size;
+    t.sizemask = size - 1;
+    t.used = 0;
+    return true;
+}
 
-    return end(); // 未找到，返回尾迭代器
+void hash_table::clear_bucket_table(hash_bucket_table& t) {
+    if (t.size > 0)
+        memset(t.table, 0, t.size * sizeof(hash_entry*));
+    t.used = 0;
 }
 
-int hash_table::findval(const string& key, int& val) {
-    if (size == 0) // 哈希表为空
-        return hashErr;
+hash_table_iterator hash_table::find(string_view key) {
+    return find(key, hashFunction(key));
+}
 
-    unsigned long index = hashFunction(key) & sizemask; // 计算哈希表索引
+hash_table_iterator hash_table::find(string_view key, size_t hash) {
+    if (isEmpty()) // 哈希表为空
+        return end();
 
-    hash_entry* entry = table[index];
-    while (entry != nullptr) {
-        if (entry->key == key) {
-            val = entry->val;
-            return hashOk;
-        }
-        entry = entry->next; // 找到匹配的键，返回对应的条目
+    rehash_step_if_needed();
+
+    for (int t = 0; t <= 1; t++) {
+        unsigned long index = hash & ht[t].sizemask; // 计算哈希表索引
+
+        // 找到匹配的键，返回对应的条目
+        hash_entry* entry = find_in_chain(ht[t].table[index], key, hash);
+        if (entry != nullptr)
+            return hash_table_iterator(this, t, index, entry);
+
+        // 未在rehash时，ht[1]为空
+        if (!isRehashing())
+            break;
     }
 
-    return hashErr; // 未找到，返回空指针
+    return end(); // 未找到，返回尾迭代器
 }
 
-// 不安全
-int hash_table::insert(const string& key, const int& val) {
-    size_t hash = hashFunction(key);
-    unsigned long index = hash & sizemask;
+int hash_table::findval(string_view key, size_t hash, int& val) {
+    hash_table_iterator it = find(key, hash);
+    if (it == end())
+        return hashErr; // 未找到
 
-    // 检查是否已存在key
-    hash_table_iterator it = find(key);
-    if (it != end()) {
+    val = it.val();
+    return hashOk;
+}
+
+// 不安全
+int hash_table::insert(string_view key, const int& val) {
+    bool inserted;
+    int* slot = find_or_insert(key, val, inserted);
+    if (slot == nullptr)
+        return hashErr;
+    if (!inserted) {
         // TODO: 可能需要新的返回格式?(扩充状态码类型or自定义Response结构体)
         cerr << "Hash_table insert failed: The key " << key
-             << " is already in hash table,its value is " << it.val() << endl;
+             << " is already in hash table,its value is " << *slot << endl;
         return hashErr;
     }
+    return hashOk;
+}
 
-    // XXX:
-    // 因为更新在hash_dict.go内定义了根据find的insertOrUpdate，所以并不需要检查并做更新？
-    hash_entry* new_entry = new hash_entry(key, val, table[index]);
+int* hash_table::find_or_insert(string_view key, size_t hash,
+                                const int& val, bool& inserted) {
+    inserted = false;
+    rehash_step_if_needed();
 
-    try {
-        hash_entry* new_entry = new hash_entry(key, val, table[index]);
-        table[index] = new_entry;
-        used++;
+    // 哈希只计算一次，同时用于查找与插入
+    for (int t = 0; t <= 1; t++) {
+        hash_entry* entry =
+            find_in_chain(ht[t].table[hash & ht[t].sizemask], key, hash);
+        if (entry != nullptr)
+            return &entry->val;
 
-        // 负载因子大于阈值，哈希表大小expand为2倍并rehash
-        if (load_factor() > expand_threshold) {
-            rehash(size * 2);
-        }
-        return hashOk;
-    } catch (const std::bad_alloc& e) {
-        std::cerr << "[HashTable] Memory allocation failed during insert: "
-                  << e.what() << endl;
-        delete new_entry; // 确保释放分配失败前的内存
-        return hashErr;
+        if (!isRehashing())
+            break;
     }
+
+    // rehash期间新节点一律插入ht[1]，保证ht[0]只减不增
+    hash_bucket_table& t = isRehashing() ? ht[1] : ht[0];
+    unsigned long index = hash & t.sizemask;
+
+    hash_entry* entry = new_entry(key, val, hash, t.table[index]);
+    if (entry == nullptr) {
+        std::cerr << "[HashTable] Memory allocation failed during insert"
+                  << endl;
+        return nullptr;
+    }
+    t.table[index] = entry;
+    t.used++;
+    inserted = true;
+
+    // 负载因子大于阈值，开始渐进式rehash，哈希表大小expand为2倍
+    // (渐进式rehash只分配新桶数组，不会移动节点，返回的指针依然有效)
+    if (!isRehashing() && load_factor() > expand_threshold &&
+        ht[0].size * 2 <= max_ht_size) {
+        rehash(ht[0].size * 2);
+    }
+    return &entry->val;
 }
 
-int hash_table::remove(const string& key) {
-    unsigned long hash = hashFunction(key);
-    unsigned long index = hash & sizemask;
+int hash_table::remove(string_view key, size_t hash) {
+    if (isEmpty())
+        return hashErr;
 
-    hash_entry* prevEntry = nullptr;
-    hash_entry* entry = table[index];
+    rehash_step_if_needed();
 
-    // 遍历链表
-    while (entry != nullptr) {
-        if (entry->key == key) {
-            int val = entry->val;
-            if (prevEntry == nullptr) {
-                // 要删除的键位于链表头部
-                table[index] = entry->next;
-            } else {
-                // 要删除的键位于链表中间或尾部
-                prevEntry->next = entry->next; // 跳过当前条目
-                entry->next = nullptr; // 断开当前条目与链表的连接
-            }
-            delete entry;
-            used--;
-            // 负载因子小于阈值，并且大小大于2*default，哈希表大小shrink为一半并rehash
-            if (load_factor() > expand_threshold &&
-                size / 2 >= default_ht_size) {
-                rehash(size / 2);
+    for (int t = 0; t <= 1; t++) {
+        unsigned long index = hash & ht[t].sizemask;
+
+        hash_entry* prevEntry = nullptr;
+        hash_entry* entry = ht[t].table[index];
+
+        // 遍历链表
+        while (entry != nullptr) {
+            if (entry->hash == static_cast<uint32_t>(hash) &&
+                entry->equals(key)) {
+                int val = entry->val;
+                if (prevEntry == nullptr) {
+                    // 要删除的键位于链表头部
+                    ht[t].table[index] = entry->next;
+                } else {
+                    // 要删除的键位于链表中间或尾部
+                    prevEntry->next = entry->next; // 跳过当前条目
+                    entry->next = nullptr; // 断开当前条目与链表的连接
+                }
+                free_entry(entry);
+                ht[t].used--;
+                // 负载因子小于阈值，并且大小大于2*default，哈希表大小shrink为一半
+                if (!isRehashing() && load_factor() < shrink_threshold &&
+                    ht[0].size / 2 >= default_ht_size) {
+                    rehash(ht[0].size / 2);
+                }
+                return val;
             }
-            return val;
+            prevEntry = entry;
+            entry = entry->next;
         }
-        prevEntry = entry;
-        entry = entry->next;
+
+        if (!isRehashing())
+            break;
     }
 
     // 因为保存的是索引，所以返回-1即视为报错
@@ -108,16 +157,18 @@ int hash_table::remove(const string& key) {
 }
 
 void hash_table::clear() {
-    for (unsigned long i = 0; i < size; ++i) {
-        hash_entry* entry = table[i];
-        while (entry != nullptr) {
-            hash_entry* temp = entry;
-            entry = entry->next;
-            delete temp;
-        }
-        table[i] = nullptr;
+    // 节点全部来自alloc，无需逐个释放
+    clear_bucket_table(ht[0]);
+
+    // 正在rehash时，清空后直接以新表作为主表
+    if (isRehashing()) {
+        clear_bucket_table(ht[1]);
+        free(ht[0].table);
+        ht[0] = ht[1];
+        ht[1] = hash_bucket_table();
+        rehashidx = -1;
     }
-    used = 0;
+    alloc.release();
 
     /*
     // XXX: 重新分配到初始大小，似乎不需要
@@ -128,119 +179,154 @@ void hash_table::clear() {
     */
 }
 
-// 随机返回一个迭代器指向哈希表中的随机条目
-vector<hash_table_iterator> hash_table::random(size_t n) {
-    vector<hash_table_iterator> result;
+vector<hash_table_iterator> hash_table::random(size_t n, bool distinct) {
+    return random_sample(*this, n, distinct);
+}
 
-    if (n <= 0) {
-        cerr << "[HashTable] Invalid number in getting random elements" << endl;
-        return result;
+// 拒绝采样：均匀选取一个桶(rehash时为ht[0]中未迁移的桶与ht[1]的全部桶)，
+// 设链长为c，在[0, max(c, cap))中取随机数k，k < c时选中链中第k个节点，否则重试。
+// 每次尝试中链长不超过cap的节点被选中的概率均为1/(桶数*cap)；
+// 负载因子不低于shrink阈值，期望尝试次数有界
+hash_table_iterator hash_table::random_one() const {
+    if (isEmpty())
+        return end();
+
+    // ht[0]中rehashidx之前的桶已迁移完，必为空
+    unsigned long skip = isRehashing() ? rehashidx : 0;
+    unsigned long size0 = ht[0].size - skip;
+    unsigned long total = size0 + (isRehashing() ? ht[1].size : 0);
+
+    for (int attempt = 0; attempt < random_max_attempts; attempt++) {
+        unsigned long r = fast_rand_below(total);
+        int t = r < size0 ? 0 : 1;
+        unsigned long bucket = t == 0 ? skip + r : r - size0;
+
+        hash_entry* head = ht[t].table[bucket];
+        if (head == nullptr)
+            continue;
+
+        unsigned long c = 0;
+        for (hash_entry* entry = head; entry != nullptr; entry = entry->next)
+            c++;
+        unsigned long k = fast_rand_below(max(c, random_chain_cap));
+        if (k >= c)
+            continue;
+
+        hash_entry* entry = head;
+        while (k--)
+            entry = entry->next;
+        return hash_table_iterator(this, t, bucket, entry);
     }
 
-    if (isEmpty()) {
-        cerr << "[HashTable] Getting elements in empty hash table" << endl;
-        return result;
+    // 极少数情况下(表极度稀疏)退化为从随机位置开始找第一个非空桶
+    unsigned long r = fast_rand_below(total);
+    for (unsigned long i = 0; i < total; i++) {
+        unsigned long pos = (r + i) % total;
+        int t = pos < size0 ? 0 : 1;
+        unsigned long bucket = t == 0 ? skip + pos : pos - size0;
+        if (ht[t].table[bucket] != nullptr)
+            return hash_table_iterator(this, t, bucket, ht[t].table[bucket]);
     }
+    return end();
+}
 
-    // 随机数生成器初始化
-    random_device rd;
-    mt19937 gen(rd());
-    vector<int> randomIndexes(n);
-    uniform_int_distribution<> distrib(0, sizemask);
-
-    // 生成n个随机数并排序
-    for (int& index : randomIndexes) {
-        index = distrib(gen);
+void hash_table::rehash(const unsigned long newSize) {
+    if (isRehashing() || newSize == ht[0].size)
+        return;
+
+    // 只分配新桶数组，节点的迁移分摊到之后的操作中
+    if (!init_bucket_table(ht[1], newSize)) {
+        std::cerr << "[HashTable] Memory allocation failed during rehash"
+                  << endl;
+        return;
     }
-    sort(randomIndexes.begin(), randomIndexes.end());
-
-    hash_table_iterator it = begin();
-    int cur = 0;
-    for (int target : randomIndexes) {
-        // 移动迭代器到下一个目标位置
-        for (int i = 0; i < target - cur; ++i) {
-            it = it.next();
+    rehashidx = 0;
+}
+
+bool hash_table::rehash_step(int n) {
+    if (!isRehashing())
+        return false;
+
+    int empty_visits = n * rehash_empty_visits;
+    while (n-- && ht[0].used != 0) {
+        // 跳过空桶，但最多访问empty_visits个
+        while (ht[0].table[rehashidx] == nullptr) {
+            rehashidx++;
+            if (--empty_visits == 0)
+                return true;
         }
 
-        cur = target;
-        // 添加迭代器到结果
-        if (it != end()) {
-            result.push_back(it);
-        } else {
-            // 如果迭代器到达尾后，停止添加
-            break;
+        // 将该桶中的所有节点迁移到新表
+        hash_entry* entry = ht[0].table[rehashidx];
+        while (entry != nullptr) {
+            hash_entry* nextEntry = entry->next;
+            // 直接使用缓存的哈希值计算新索引，无需重新哈希key
+            unsigned long newIndex = entry->hash & ht[1].sizemask;
+
+            entry->next = ht[1].table[newIndex];
+            ht[1].table[newIndex] = entry;
+            ht[0].used--;
+            ht[1].used++;
+
+            entry = nextEntry;
         }
+        ht[0].table[rehashidx] = nullptr;
+        rehashidx++;
+    }
+
+    // 迁移完成，新表替换旧表
+    if (ht[0].used == 0) {
+        free(ht[0].table);
+        ht[0] = ht[1];
+        ht[1] = hash_bucket_table();
+        rehashidx = -1;
+        return false;
     }
-    return result;
+    return true;
 }
 
-// TODO: 目前暂不考虑分步式rehash
-void hash_table::rehash(const unsigned long newSize) {
-    hash_entry** newTable = nullptr;
-    try {
-        newTable = new hash_entry*[newSize]();
-        unsigned long newSizemask = newSize - 1;
-
-        // 遍历旧哈希表，重新哈希每个元素到新哈希表
-        for (unsigned long i = 0; i < size; ++i) {
-            hash_entry* entry = table[i];
-            while (entry != nullptr) {
-                hash_entry* nextEntry = entry->next;
-                // 重新计算哈希值的索引
-                unsigned long newIndex = hashFunction(entry->key) & newSizemask;
-
-                // 将元素插入新哈希表
-                entry->next = newTable[newIndex];
-                newTable[newIndex] = entry;
-
-                entry = nextEntry;
-            }
-        }
+int hash_table::rehash_milliseconds(int ms) {
+    if (rehash_paused > 0)
+        return 0;
 
-        // 释放旧哈希表内存
-        delete[] table;
-
-        // 更新哈希表属性为新哈希表
-        table = newTable;
-        size = newSize;
-        sizemask = newSizemask;
-    } catch (const std::bad_alloc& e) {
-        std::cerr << "[HashTable] Memory allocation failed during rehash: "
-                  << e.what() << endl;
-        // 确保释放分配失败前的内存
-        delete[] newTable;
+    auto start = chrono::steady_clock::now();
+    int steps = 0;
+    // 每100个桶检查一次时间
+    while (rehash_step(100)) {
+        steps += 100;
+        if (chrono::steady_clock::now() - start >= chrono::milliseconds(ms))
+            break;
     }
+    return steps;
 }
 
 // 调试用输出
 void hash_table::print() const {
     // return;
     cout << "Hash Table:" << endl;
-    cout << "used:" << used << endl;
-    for (unsigned long i = 0; i < size; ++i) {
-        hash_entry* entry = table[i];
-        if (entry == nullptr) {
-            cout << "Bucket " << i << ": empty" << endl;
-        } else {
-            cout << "Bucket " << i << ":";
-            while (entry != nullptr) {
-                cout << " (" << entry->key << ", " << entry->val << ")";
-                entry = entry->next;
+    cout << "used:" << len() << endl;
+    cout << "rehashidx:" << rehashidx << endl;
+    for (int t = 0; t <= (isRehashing() ? 1 : 0); t++) {
+        for (unsigned long i = 0; i < ht[t].size; ++i) {
+            hash_entry* entry = ht[t].table[i];
+            if (entry == nullptr) {
+                cout << "Bucket " << t << "-" << i << ": empty" << endl;
+            } else {
+                cout << "Bucket " << t << "-" << i << ":";
+                while (entry != nullptr) {
+                    cout << " (" << entry->keyview() << ", " << entry->val << ")";
+                    entry = entry->next;
+                }
+                cout << endl;
             }
-            cout << endl;
         }
     }
     cout << endl;
 }
 
 hash_table_iterator hash_table::begin() const {
-    for (unsigned long i = 0; i < size; ++i) {
-        if (table[i] != nullptr) {
-            return hash_table_iterator(this, i, table[i]);
-        }
-    }
     // 如果哈希表为空，则返回尾后迭代器
-    return end();
+    return hash_table_iterator(this);
 }
 
 hash_table_iterator hash_table::end() const {
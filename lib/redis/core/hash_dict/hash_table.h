@@ -1,11 +1,20 @@
-// #include "MurmurHash3.h"
+#pragma once
+
+#include "hash_func.h"
+#include "slab_allocator.h"
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <iostream>
 #include <optional>
 #include <random>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 using namespace std;
 
@@ -14,16 +23,26 @@ class hash_entry;
 class hash_table;
 class hash_table_iterator;
 
-// // Murmurhash随机种子
-// const uint64_t dict_hash_func_seed = 42;
-
 // 哈希表默认大小
 const uint64_t default_ht_size = 4;
 
+// 哈希表最大大小，节点只缓存了哈希值的低32位
+const uint64_t max_ht_size = 1ULL << 32;
+
 // rehash阈值(load_factor)
 const static float expand_threshold = 0.8;
 const static float shrink_threshold = 0.2;
 
+// 渐进式rehash: 每次增删查顺带迁移的桶数
+const static int rehash_buckets_per_op = 1;
+// 单步rehash中最多连续访问的空桶数(乘以步数)，避免在稀疏表上停顿过久
+const static int rehash_empty_visits = 10;
+
+// 随机采样: 链长不超过该值的节点被选中的概率严格相等
+const static unsigned long random_chain_cap = 4;
+// 随机采样的最大尝试次数，超过后退化为线性扫描
+const static int random_max_attempts = 1024;
+
 enum {
     hashOk = 0,
     hashErr = -1,
@@ -31,94 +50,206 @@ enum {
 };
 
 // 哈希表节点
-// 占48字节内存(32+8+8)
+// 头部占20字节(8+4+4+4)，key紧随其后，与节点一同从表的slab分配器中分配，
+// 不再单独分配string的堆内存
 class hash_entry {
     friend class hash_table;
     friend class hash_table_iterator;
 
 public:
     // 实际以迭代器调用
-    inline string getkey() const { return key; };
+    inline string getkey() const { return string(key, len); };
+    inline string_view keyview() const { return string_view(key, len); };
     inline int getval() const { return val; };
     inline hash_entry* getnext() const { return next; };
 
 private:
-    // 键值对，key为string类型，val为int类型的内存索引(?)
-    string key;
-    int val;
-
     // 指向下个哈希表节点，形成链表
     hash_entry* next;
 
-    // 不包含next指针的构造函数
-    hash_entry(const string& key, const int& val)
-        : key(key), val(val), next(nullptr){};
+    // val为int类型的内存索引(?)
+    int val;
+
+    // 缓存的key哈希值(低32位)
+    // rehash时直接用于计算新索引，查找时先比较哈希再比较key
+    // 桶数组大小不超过2^32(max_ht_size)，低32位足以确定索引
+    uint32_t hash;
 
-    // 包含next指针的构造函数
-    hash_entry(const string& key, const int& val, hash_entry* next)
-        : key(key), val(val), next(next){};
+    // key长度与内容
+    uint32_t len;
+    char key[];
 
-    ~hash_entry(){};
+    // 容纳长度为len的key的节点大小
+    static inline size_t alloc_size(size_t len) {
+        return offsetof(hash_entry, key) + len;
+    }
+
+    inline bool equals(string_view k) const {
+        return k.size() == len && memcmp(key, k.data(), len) == 0;
+    }
+
+    // 只能通过hash_table::new_entry创建
+    hash_entry() = delete;
+    ~hash_entry() = delete;
 };
 
-// 哈希表
+// 哈希桶数组
+// 渐进式rehash期间同时存在两个桶数组：ht[0]为旧表，ht[1]为新表
+struct hash_bucket_table {
+    // 存指向哈希表第一排节点的指针
+    hash_entry** table = nullptr;
+
+    // 桶数组大小
+    unsigned long size = 0;
+
+    // 大小掩码(size - 1)，用于计算索引值(使用按位与sizemask代替取余)
+    unsigned long sizemask = 0;
+
+    // 该桶数组已有节点的数量
+    unsigned long used = 0;
+};
 
+// 哈希表
+// 扩缩容采用渐进式rehash：开始rehash时只分配新桶数组，
+// 之后每次insert/find/remove迁移少量桶，空闲时也可调用rehash_milliseconds批量迁移
 class hash_table {
     friend class hash_table_iterator;
 
 public:
-    static inline size_t hashFunction(string key) {
-        // murmurhash在测试中性能不佳，冲突较多（测试1~100整数键值），故采用标准库
-        static hash<std::string> hash_fn;
-        return hash_fn(key);
+    typedef hash_table_iterator iterator;
+
+    // 哈希函数由编译期的hash_policy决定(见hash_func.h)，并以进程级随机种子加盐
+    static inline size_t hashFunction(string_view key) {
+        return hash_policy::hash(key.data(), key.size(), hash_seed());
     }
 
     // 分配内存
     hash_table(const unsigned long size = default_ht_size)
-        : size(size), sizemask(size - 1), used(0) {
-        try {
-            table = size > 0 ? new hash_entry*[size]() : nullptr;
-            for (unsigned long i = 0; i < size; ++i)
-                table[i] = nullptr;
-        } catch (const std::bad_alloc& e) {
-            std::cerr << "Memory allocation failed during hash_table init: "
-                      << e.what() << endl;
-            delete[] table; // 确保释放分配失败前的内存
-        }
+        : rehashidx(-1), rehash_paused(0) {
+        init_bucket_table(ht[0], size);
+    }
+    ~hash_table() {
+        // 节点由alloc析构时整体归还
+        free(ht[0].table);
+        free(ht[1].table);
     }
-    ~hash_table() { delete[] table; }
 
-    // 负载因子
+    // 负载因子(以当前主表ht[0]计算)
     inline float load_factor() const {
-        return size > 0 ? static_cast<float>(used) / size : 0.0f;
+        return ht[0].size > 0 ? static_cast<float>(ht[0].used) / ht[0].size
+                              : 0.0f;
     }
 
-    /* 查找对应键值对应hash_table_iterator
+    /* 查找对应键值对应hash_table_iterator，hash为hashFunction(key)
        返回值：键值是否存在?对应迭代器:end */
-    hash_table_iterator find(const string& key);
+    hash_table_iterator find(string_view key, size_t hash);
+    hash_table_iterator find(string_view key);
 
     /* 查找对应键值对应val，返回值以传输引用方式获得
        返回值：键值是否存在?hashOk:hashErr */
-    int findval(const string& key, int& val);
+    int findval(string_view key, size_t hash, int& val);
+    inline int findval(string_view key, int& val) {
+        return findval(key, hashFunction(key), val);
+    }
 
     /* 插入键值对，并判断是否需要expand
        返回值：插入是否成功 */
-    int insert(const string& key, const int& val);
+    int insert(string_view key, const int& val);
+
+    /* 查找key，不存在则以val插入；只计算一次哈希、只探测一次
+       inserted返回是否新插入
+       返回值：指向key对应val的指针，在下一次修改哈希表前有效；分配失败返回nullptr */
+    int* find_or_insert(string_view key, size_t hash, const int& val,
+                        bool& inserted);
+    inline int* find_or_insert(string_view key, const int& val,
+                               bool& inserted) {
+        return find_or_insert(key, hashFunction(key), val, inserted);
+    }
 
     /* 插入键值对，并判断是否需要shrink
        返回值：删除key对应的val */
-    int remove(const string& key);
+    int remove(string_view key, size_t hash);
+    inline int remove(string_view key) {
+        return remove(key, hashFunction(key));
+    }
+
+    // 批量操作时的两阶段预取：先预取桶，桶到达缓存后再预取链表首个节点
+    inline void prefetch(size_t hash) const {
+        __builtin_prefetch(&ht[0].table[hash & ht[0].sizemask]);
+        if (isRehashing())
+            __builtin_prefetch(&ht[1].table[hash & ht[1].sizemask]);
+    }
+    inline void prefetch_entry(size_t hash) const {
+        __builtin_prefetch(ht[0].table[hash & ht[0].sizemask]);
+        if (isRehashing())
+            __builtin_prefetch(ht[1].table[hash & ht[1].sizemask]);
+    }
 
     /* 随机返回n个指向哈希表条目的迭代器
-       返回值：指向随机条目的迭代器数组 */
-    vector<hash_table_iterator> random(size_t n);
+       distinct为true时返回min(n, len)个互不相同的条目，否则有放回地抽取n个
+       返回值：指向随机条目的迭代器数组，表为空时为空 */
+    vector<hash_table_iterator> random(size_t n, bool distinct = false);
+
+    /* 均匀随机返回一个条目，期望O(1)
+       返回值：表为空时为end */
+    hash_table_iterator random_one() const;
 
-    // 清空哈希表（不重置为初始大小）
+    // 清空哈希表（不重置为初始大小），节点内存一次性归还
     void clear();
 
-    // rehash为指定大小
+    // 开始渐进式rehash到指定大小(正在rehash时忽略)
     void rehash(const unsigned long newSize);
 
+    /* 迁移至多n个桶
+       返回值：迁移后是否仍处于rehash状态 */
+    bool rehash_step(int n);
+
+    /* 在ms毫秒内尽可能多地迁移，供空闲时调用
+       返回值：迁移的步数 */
+    int rehash_milliseconds(int ms);
+
+    /* SCAN：以游标cursor扫描一个桶，对其中每个节点调用fn(key, val)；
+       rehash时扫描小表的一个桶，以及该桶在大表中对应的所有桶
+       返回值：下一次扫描的游标，为0表示扫描结束
+       从扫描开始到结束一直存在的节点保证至少返回一次(表扩缩容时可能重复) */
+    template <class Fn> unsigned long scan(unsigned long cursor, Fn fn) const {
+        if (isEmpty())
+            return 0;
+
+        auto emit = [&](const hash_bucket_table& t, unsigned long idx) {
+            for (hash_entry* entry = t.table[idx & t.sizemask];
+                 entry != nullptr; entry = entry->next) {
+                fn(entry->keyview(), entry->val);
+            }
+        };
+
+        if (!isRehashing()) {
+            emit(ht[0], cursor);
+            return scan_next_cursor(cursor, ht[0].sizemask);
+        }
+
+        const hash_bucket_table* t0 = &ht[0];
+        const hash_bucket_table* t1 = &ht[1];
+        if (t0->size > t1->size)
+            swap(t0, t1);
+        unsigned long m0 = t0->sizemask, m1 = t1->sizemask;
+
+        emit(*t0, cursor);
+        // 小表中的一个桶对应大表中低位相同的所有桶
+        do {
+            emit(*t1, cursor);
+            cursor = scan_next_cursor(cursor, m1);
+        } while (cursor & (m0 ^ m1));
+        return cursor;
+    }
+
+    // 是否正在rehash
+    inline bool isRehashing() const { return rehashidx != -1; }
+
+    // 暂停/恢复rehash，迭代期间需暂停以免节点在两表间移动
+    inline void pause_rehash() { rehash_paused++; }
+    inline void resume_rehash() { rehash_paused--; }
+
     // 打印哈希表
     void print() const;
 
@@ -128,47 +259,100 @@ public:
     // 尾后迭代器
     hash_table_iterator end() const;
 
-    int getSize() const { return this->size; };
+    // 桶数组大小
+    int getSize() const { return this->ht[0].size; };
 
-    bool isEmpty() const { return this->used == 0; }
+    // 节点数量
+    unsigned long len() const { return ht[0].used + ht[1].used; }
+
+    bool isEmpty() const { return len() == 0; }
+
+    // 节点分配器统计信息
+    const slab_stats& alloc_stats() const { return alloc.stats(); }
 
 private:
-    // 哈希表数组，存指向哈希表第一排节点的指针
-    hash_entry** table;
+    // 两个桶数组，未在rehash时只使用ht[0]
+    hash_bucket_table ht[2];
+
+    // 下一个待迁移的ht[0]桶的索引，-1表示未在rehash
+    long rehashidx;
+
+    // 大于0时暂停rehash
+    int rehash_paused;
+
+    // 节点(连同key)的分配器
+    slab_allocator alloc;
+
+    // 分配并初始化节点，分配失败返回nullptr
+    inline hash_entry* new_entry(string_view key, int val, uint32_t hash,
+                                 hash_entry* next) {
+        hash_entry* entry = static_cast<hash_entry*>(
+            alloc.allocate(hash_entry::alloc_size(key.size())));
+        if (entry == nullptr)
+            return nullptr;
+        entry->next = next;
+        entry->val = val;
+        entry->hash = hash;
+        entry->len = key.size();
+        memcpy(entry->key, key.data(), key.size());
+        return entry;
+    }
+
+    inline void free_entry(hash_entry* entry) {
+        alloc.deallocate(entry, hash_entry::alloc_size(entry->len));
+    }
+
+    // 链表中查找key，先比较缓存的哈希值，相同时才比较key
+    static inline hash_entry* find_in_chain(hash_entry* entry,
+                                            string_view key,
+                                            uint32_t hash) {
+        while (entry != nullptr) {
+            if (entry->hash == hash && entry->equals(key))
+                return entry;
+            entry = entry->next;
+        }
+        return nullptr;
+    }
 
-    // 哈希表大小
-    unsigned long size;
+    // 为桶数组分配内存
+    static bool init_bucket_table(hash_bucket_table& t, unsigned long size);
 
-    // 哈希表大小掩码(size - 1)，用于计算索引值(使用按位与sizemask代替取余)
-    unsigned long sizemask;
+    // 清空桶数组(不释放节点)
+    static void clear_bucket_table(hash_bucket_table& t);
 
-    // 该哈希表已有节点的数量
-    unsigned long used;
+    // 在增删查时顺带迁移少量桶
+    inline void rehash_step_if_needed() {
+        if (isRehashing() && rehash_paused == 0) {
+            rehash_step(rehash_buckets_per_op);
+        }
+    }
 };
 
 // hash_table_iterator迭代器
 // 不安全迭代器，可以直接删除当前迭代器指向的节点
+// rehash期间依次遍历ht[0]与ht[1]，遍历时应暂停rehash
 class hash_table_iterator {
 public:
     // 初始化构造函数，用于构造begin或end迭代器
     hash_table_iterator(const hash_table* ht, bool end = false)
-        : ht(ht), bucket(0), entry(nullptr) {
+        : ht(ht), table(0), bucket(0), entry(nullptr) {
         if (!end) {
             // 如果不是创建一个尾后迭代器，则初始化到第一个有效元素
             advanceToFirst();
         } else {
             // 创建一个尾后迭代器
-            bucket = ht->size;
+            setEnd();
         }
     }
     // 构造函数，用于对指定hash_entry进行迭代
-    hash_table_iterator(const hash_table* ht, unsigned long bucket,
+    hash_table_iterator(const hash_table* ht, int table, unsigned long bucket,
                         hash_entry* entry)
-        : ht(ht), bucket(bucket), entry(entry) {}
+        : ht(ht), table(table), bucket(bucket), entry(entry) {}
 
     // 复制构造函数
     hash_table_iterator(const hash_table_iterator& clone)
-        : ht(clone.ht), bucket(clone.bucket), entry(clone.entry) {}
+        : ht(clone.ht), table(clone.table), bucket(clone.bucket),
+          entry(clone.entry) {}
 
     // 前缀自增，移动到下一个元素
     hash_table_iterator& operator++() {
@@ -177,7 +361,10 @@ public:
     }
 
     // 对应entry中的方法
-    inline const string key() { return this->entry->key; };
+    inline const string key() { return this->entry->getkey(); };
+    inline string_view keyview() { return this->entry->keyview(); };
+    // 节点的唯一标识，用于随机采样去重
+    inline const void* id() const { return this->entry; };
     inline const int val() { return this->entry->val; };
     inline hash_table_iterator next() {
         hash_table_iterator nxt(*this);
@@ -193,7 +380,8 @@ public:
 
     // 比较两个迭代器是否相等
     bool operator==(const hash_table_iterator& other) const {
-        return ht == other.ht && bucket == other.bucket && entry == other.entry;
+        return ht == other.ht && table == other.table &&
+               bucket == other.bucket && entry == other.entry;
     }
 
     // 比较两个迭代器是否不相等
@@ -201,68 +389,105 @@ public:
         return !(*this == other);
     }
 
-    // // 删除当前节点
-    // 直接调用找到的entry的remove即可
-    // bool erase() {
-    //     if (!entry)
-    //         return false; // 如果当前节点为空，则不执行删除
-
-    //     hash_entry* toDelete = entry;
-    //     // 预先移动到下一个节点
-    //     advance();
-
-    //     // 执行删除操作
-    //     // 如果不使用prevEntry则需要重新遍历过
-    //     if (prevEntry) {
-    //         // 如果不是第一个节点
-    //         prevEntry->next = entry->next;
-    //     } else {
-    //         // 如果是第一个节点
-    //         ht->table[bucket] = entry->next;
-    //     }
-
-    //     delete toDelete; // 删除节点
-    //     ht->used--;      // 更新已使用节点的数量
-
-    //     return true;
-    // }
-
 private:
     const hash_table* ht;
+    int table;            // 当前桶数组(0或1)
     unsigned long bucket; // 当前桶的索引
     hash_entry* entry;    // 当前节点的指针
 
+    // 尾后迭代器的状态与桶数组大小无关，避免rehash前后生成的end不相等
+    void setEnd() {
+        table = 2;
+        bucket = 0;
+        entry = nullptr;
+    }
+
+    // 从(table, bucket)开始找到第一个非空桶
+    void seek() {
+        while (table < 2) {
+            const hash_bucket_table& t = ht->ht[table];
+            while (bucket < t.size) {
+                if (t.table[bucket]) {
+                    entry = t.table[bucket];
+                    return;
+                }
+                bucket++;
+            }
+            // ht[1]只在rehash时有效
+            if (table == 0 && ht->isRehashing()) {
+                table = 1;
+                bucket = 0;
+            } else {
+                break;
+            }
+        }
+        setEnd();
+    }
+
     // 移动到下一个有效元素
     void advance() {
         // 如果为有效节点，则直接到下一个
         if (entry) {
             entry = entry->next;
         }
+        if (entry) {
+            return;
+        }
 
         // next为空，到下一个桶的开头找
-        // 注意这里是sizemask，不然会超索引
-        // while (!entry && bucket < ht->size) {
-        while (!entry && bucket < ht->sizemask) {
+        if (table < 2) {
             bucket++;
-            entry = ht->table[bucket];
-        }
-
-        // 检查是否到达了最后一个节点，或者当前已经是尾后迭代器
-        if (!entry && bucket >= ht->sizemask) {
-            // 设置为尾后迭代器
-            bucket = ht->size;
-            entry = nullptr;
-            return;
+            seek();
         }
     }
 
     // 初始化到第一个有效元素
-    void advanceToFirst() {
-        while (bucket < ht->size && !ht->table[bucket]) {
-            ++bucket;
-        }
-        if (bucket < ht->size) {
-            entry = ht->table[bucket];
+    void advanceToFirst() { seek(); }
+};
+
+// 随机采样，hash_table与swiss_table共用
+// Table需提供random_one()、begin()/end()、len()，迭代器需提供id()
+template <class Table>
+vector<typename Table::iterator> random_sample(Table& t, size_t n,
+                                               bool distinct) {
+    typedef typename Table::iterator iterator;
+    vector<iterator> result;
+    if (n == 0 || t.isEmpty())
+        return result;
+
+    if (!distinct) {
+        result.reserve(n);
+        for (size_t i = 0; i < n; i++)
+            result.push_back(t.random_one());
+        return result;
+    }
+
+    size_t len = t.len();
+    if (n * 4 > len) {
+        // 所需元素占比较大时，遍历全表做蓄水池抽样，再打乱顺序
+        result.reserve(min(n, len));
+        size_t i = 0;
+        for (auto it = t.begin(); it != t.end(); ++it, ++i) {
+            if (i < n) {
+                result.push_back(it);
+            } else {
+                size_t j = fast_rand_below(i + 1);
+                if (j < n)
+                    result[j] = it;
+            }
         }
+        for (size_t k = result.size(); k > 1; k--)
+            swap(result[k - 1], result[fast_rand_below(k)]);
+        return result;
     }
-};
+
+    // 所需元素较少时，逐个抽取并丢弃重复(重复概率不超过1/4)
+    result.reserve(n);
+    unordered_set<const void*> seen;
+    while (result.size() < n) {
+        iterator it = t.random_one();
+        if (seen.insert(it.id()).second)
+            result.push_back(it);
+    }
+    return result;
+}
@@ -0,0 +1,110 @@
+#include "slab_allocator.h"
+
+slab_allocator::slab_allocator()
+    : free_lists(), cur(nullptr), remain(0), chunks(nullptr),
+      larges(nullptr) {}
+
+void* slab_allocator::allocate(size_t size) {
+    if (size == 0)
+        size = 1;
+
+    if (size > slab_max_size) {
+        large_header* h = static_cast<large_header*>(
+            malloc(sizeof(large_header) + size));
+        if (h == nullptr)
+            return nullptr;
+        h->prev = nullptr;
+        h->next = larges;
+        if (larges)
+            larges->prev = h;
+        larges = h;
+
+        st.sys_allocs++;
+        st.reserved += sizeof(large_header) + size;
+        st.used += size;
+        st.objects++;
+        return h + 1;
+    }
+
+    size_t cls = size_class(size);
+    size_t rounded = (cls + 1) * slab_align;
+    void* p;
+    if (free_lists[cls] != nullptr) {
+        // 优先复用同一大小类中释放的对象
+        free_node* node = free_lists[cls];
+        free_lists[cls] = node->next;
+        p = node;
+    } else {
+        if (remain < rounded) {
+            // 当前slab剩余不足，申请新的slab(剩余部分不超过512字节，直接舍弃)
+            chunk_header* c =
+                static_cast<chunk_header*>(malloc(slab_chunk_size));
+            if (c == nullptr)
+                return nullptr;
+            c->next = chunks;
+            chunks = c;
+            cur = reinterpret_cast<char*>(c + 1);
+            remain = slab_chunk_size - sizeof(chunk_header);
+
+            st.sys_allocs++;
+            st.reserved += slab_chunk_size;
+        }
+        p = cur;
+        cur += rounded;
+        remain -= rounded;
+    }
+
+    st.used += rounded;
+    st.objects++;
+    return p;
+}
+
+void slab_allocator::deallocate(void* p, size_t size) {
+    if (p == nullptr)
+        return;
+    if (size == 0)
+        size = 1;
+
+    st.objects--;
+    if (size > slab_max_size) {
+        large_header* h = static_cast<large_header*>(p) - 1;
+        if (h->prev)
+            h->prev->next = h->next;
+        else
+            larges = h->next;
+        if (h->next)
+            h->next->prev = h->prev;
+        free(h);
+
+        st.reserved -= sizeof(large_header) + size;
+        st.used -= size;
+        return;
+    }
+
+    size_t cls = size_class(size);
+    free_node* node = static_cast<free_node*>(p);
+    node->next = free_lists[cls];
+    free_lists[cls] = node;
+    st.used -= (cls + 1) * slab_align;
+}
+
+void slab_allocator::release() {
+    while (chunks != nullptr) {
+        chunk_header* next = chunks->next;
+        free(chunks);
+        chunks = next;
+    }
+    while (larges != nullptr) {
+        large_header* next = larges->next;
+        free(larges);
+        larges = next;
+    }
+    for (size_t i = 0; i < slab_classes; i++)
+        free_lists[i] = nullptr;
+    cur = nullptr;
+    remain = 0;
+
+    st.reserved = 0;
+    st.used = 0;
+    st.objects = 0;
+}
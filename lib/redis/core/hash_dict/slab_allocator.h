@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+// 按16字节划分大小类，不超过slab_max_size的对象从slab中分配
+const size_t slab_align = 16;
+const size_t slab_max_size = 512;
+const size_t slab_classes = slab_max_size / slab_align;
+
+// 每次向系统申请的slab大小
+const size_t slab_chunk_size = 64 * 1024;
+
+// 分配器统计信息
+struct slab_stats {
+    // 累计向系统申请内存的次数(slab与大对象)
+    uint64_t sys_allocs = 0;
+    // 当前向系统申请的字节数
+    uint64_t reserved = 0;
+    // 当前分配给对象的字节数(按大小类向上取整)
+    uint64_t used = 0;
+    // 当前存活对象数
+    uint64_t objects = 0;
+};
+
+// slab分配器
+// 小对象按大小类从64KB的slab中顺序切分，释放后进入该大小类的空闲链表复用；
+// 大对象直接malloc并挂在链表上。slab只在release时整体归还，
+// 频繁增删时内存在表内循环使用，不会碎片化进程堆
+class slab_allocator {
+public:
+    slab_allocator();
+    ~slab_allocator() { release(); }
+
+    slab_allocator(const slab_allocator&) = delete;
+    slab_allocator& operator=(const slab_allocator&) = delete;
+
+    /* 分配size字节，按16字节对齐
+       返回值：分配失败返回nullptr */
+    void* allocate(size_t size);
+
+    // 释放对象，size须与分配时一致
+    void deallocate(void* p, size_t size);
+
+    // 一次性归还所有内存，之前分配的对象全部失效
+    void release();
+
+    const slab_stats& stats() const { return st; }
+
+private:
+    // 空闲对象复用自身内存作为链表节点
+    struct free_node {
+        free_node* next;
+    };
+
+    // slab头部，串成链表以便整体归还
+    struct alignas(slab_align) chunk_header {
+        chunk_header* next;
+    };
+
+    // 大对象头部，双向链表以便单独释放
+    struct alignas(slab_align) large_header {
+        large_header* prev;
+        large_header* next;
+    };
+
+    free_node* free_lists[slab_classes];
+
+    // 当前slab中未切分部分
+    char* cur;
+    size_t remain;
+
+    chunk_header* chunks;
+    large_header* larges;
+
+    slab_stats st;
+
+    static inline size_t size_class(size_t size) {
+        return (size + slab_align - 1) / slab_align - 1;
+    }
+};
@@ -0,0 +1,254 @@
+#include "swiss_table.h"
+
+swiss_table::swiss_table(const unsigned long size)
+    : ctrl(nullptr), slots(nullptr), capacity(0), groupmask(0), used(0),
+      deleted(0) {
+    unsigned long cap = swiss_group::width;
+    while (cap < size)
+        cap <<= 1;
+    alloc_table(cap);
+}
+
+swiss_table::~swiss_table() {
+    // 长key由alloc析构时整体归还
+    free(ctrl);
+    free(slots);
+}
+
+bool swiss_table::alloc_table(unsigned long cap) {
+    swiss_ctrl* newCtrl = static_cast<swiss_ctrl*>(malloc(cap));
+    swiss_slot* newSlots =
+        static_cast<swiss_slot*>(malloc(cap * sizeof(swiss_slot)));
+    if (!newCtrl || !newSlots) {
+        std::cerr << "[SwissTable] Memory allocation failed" << endl;
+        free(newCtrl);
+        free(newSlots);
+        return false;
+    }
+    memset(newCtrl, ctrl_empty, cap);
+
+    ctrl = newCtrl;
+    slots = newSlots;
+    capacity = cap;
+    groupmask = cap / swiss_group::width - 1;
+    used = 0;
+    deleted = 0;
+    return true;
+}
+
+// 按组做三角数探测(步长1,2,3...)，组数为2的幂时可以遍历到所有组
+long swiss_table::find_slot(string_view key, size_t hash) const {
+    swiss_ctrl tag = h2(hash);
+    unsigned long g = h1(hash) & groupmask;
+    for (unsigned long step = 1; step <= groupmask + 1; step++) {
+        unsigned long base = g * swiss_group::width;
+        swiss_group group(ctrl + base);
+
+        // 只对h2相同的槽位比较key
+        for (auto mask = group.match(tag); mask; mask &= mask - 1) {
+            unsigned long pos = base + __builtin_ctz(mask);
+            if (slots[pos].equals(key))
+                return pos;
+        }
+
+        // 组内有空槽说明探测序列到此为止
+        if (group.match_empty())
+            return -1;
+
+        g = (g + step) & groupmask;
+    }
+    return -1;
+}
+
+unsigned long swiss_table::find_insert_slot(size_t hash) const {
+    unsigned long g = h1(hash) & groupmask;
+    for (unsigned long step = 1;; step++) {
+        unsigned long base = g * swiss_group::width;
+        auto mask = swiss_group(ctrl + base).match_empty_or_deleted();
+        if (mask)
+            return base + __builtin_ctz(mask);
+        g = (g + step) & groupmask;
+    }
+}
+
+swiss_table_iterator swiss_table::find(string_view key) {
+    return find(key, hashFunction(key));
+}
+
+swiss_table_iterator swiss_table::find(string_view key, size_t hash) {
+    long pos = find_slot(key, hash);
+    return pos < 0 ? end() : swiss_table_iterator(this, pos);
+}
+
+int swiss_table::findval(string_view key, size_t hash, int& val) {
+    long pos = find_slot(key, hash);
+    if (pos < 0)
+        return hashErr;
+    val = slots[pos].val;
+    return hashOk;
+}
+
+int swiss_table::insert(string_view key, const int& val) {
+    bool inserted;
+    int* slot = find_or_insert(key, val, inserted);
+    if (slot == nullptr)
+        return hashErr;
+    if (!inserted) {
+        cerr << "Swiss_table insert failed: The key " << key
+             << " is already in hash table,its value is " << *slot << endl;
+        return hashErr;
+    }
+    return hashOk;
+}
+
+int* swiss_table::find_or_insert(string_view key, size_t hash,
+                                 const int& val, bool& inserted) {
+    inserted = false;
+
+    // 哈希只计算一次，同时用于查找与插入
+    long found = find_slot(key, hash);
+    if (found >= 0)
+        return &slots[found].val;
+
+    // 删除标记同样占据探测序列，一并计入负载
+    if (used + deleted + 1 > capacity * swiss_max_load) {
+        // 删除标记较多时原地清理即可，否则扩容为2倍
+        rehash(deleted > used / 2 ? capacity : capacity * 2);
+    }
+
+    unsigned long pos = find_insert_slot(hash);
+    swiss_slot& slot = slots[pos];
+    slot.len = key.size();
+    slot.val = val;
+    if (slot.len > swiss_inline_key_len) {
+        slot.heap_key = static_cast<char*>(alloc.allocate(slot.len));
+        if (slot.heap_key == nullptr) {
+            std::cerr << "[SwissTable] Memory allocation failed during insert"
+                      << endl;
+            return nullptr;
+        }
+    }
+    memcpy(const_cast<char*>(slot.data()), key.data(), slot.len);
+
+    if (ctrl[pos] == ctrl_deleted)
+        deleted--;
+    ctrl[pos] = h2(hash);
+    used++;
+    inserted = true;
+    return &slot.val;
+}
+
+int swiss_table::remove(string_view key, size_t hash) {
+    long pos = find_slot(key, hash);
+    if (pos < 0)
+        return hashErr;
+
+    int val = slots[pos].val;
+    free_slot(slots[pos]);
+
+    // 所在组内仍有空槽时，任何探测序列都不会越过该组，可直接置为空槽
+    unsigned long base = pos / swiss_group::width * swiss_group::width;
+    if (swiss_group(ctrl + base).match_empty()) {
+        ctrl[pos] = ctrl_empty;
+    } else {
+        ctrl[pos] = ctrl_deleted;
+        deleted++;
+    }
+    used--;
+
+    // 负载因子小于阈值，缩容为一半
+    if (load_factor() < swiss_shrink_threshold &&
+        capacity / 2 >= swiss_group::width) {
+        rehash(capacity / 2);
+    }
+    return val;
+}
+
+void swiss_table::clear() {
+    alloc.release();
+    memset(ctrl, ctrl_empty, capacity);
+    used = 0;
+    deleted = 0;
+}
+
+void swiss_table::rehash(unsigned long newSize) {
+    unsigned long cap = swiss_group::width;
+    while (cap < newSize)
+        cap <<= 1;
+
+    swiss_ctrl* oldCtrl = ctrl;
+    swiss_slot* oldSlots = slots;
+    unsigned long oldCapacity = capacity;
+    unsigned long oldUsed = used;
+    unsigned long oldDeleted = deleted;
+    if (!alloc_table(cap)) {
+        // 分配失败则保留原表
+        ctrl = oldCtrl, slots = oldSlots, capacity = oldCapacity;
+        groupmask = oldCapacity / swiss_group::width - 1;
+        used = oldUsed, deleted = oldDeleted;
+        return;
+    }
+
+    // 槽位按值搬移，长key的指针随之转移，无需重新分配
+    for (unsigned long i = 0; i < oldCapacity; i++) {
+        if (oldCtrl[i] < 0)
+            continue;
+        const swiss_slot& slot = oldSlots[i];
+        size_t hash =
+            hash_table::hashFunction(string_view(slot.data(), slot.len));
+        unsigned long pos = find_insert_slot(hash);
+        slots[pos] = slot;
+        ctrl[pos] = h2(hash);
+        used++;
+    }
+
+    free(oldCtrl);
+    free(oldSlots);
+}
+
+vector<swiss_table_iterator> swiss_table::random(size_t n, bool distinct) {
+    return random_sample(*this, n, distinct);
+}
+
+// 随机选取槽位直到命中满槽，负载因子不低于shrink阈值，期望尝试次数有界
+swiss_table_iterator swiss_table::random_one() const {
+    if (isEmpty())
+        return end();
+
+    for (int attempt = 0; attempt < random_max_attempts; attempt++) {
+        unsigned long pos = fast_rand_below(capacity);
+        if (ctrl[pos] >= 0)
+            return swiss_table_iterator(this, pos);
+    }
+
+    // 极少数情况下退化为从随机位置开始找第一个满槽
+    unsigned long r = fast_rand_below(capacity);
+    for (unsigned long i = 0; i < capacity; i++) {
+        unsigned long pos = (r + i) & (capacity - 1);
+        if (ctrl[pos] >= 0)
+            return swiss_table_iterator(this, pos);
+    }
+    return end();
+}
+
+// 调试用输出
+void swiss_table::print() const {
+    cout << "Swiss Table:" << endl;
+    cout << "used:" << used << " deleted:" << deleted << endl;
+    for (unsigned long i = 0; i < capacity; i++) {
+        if (ctrl[i] >= 0) {
+            cout << "Slot " << i << ": ("
+                 << string(slots[i].data(), slots[i].len) << ", "
+                 << slots[i].val << ")" << endl;
+        }
+    }
+    cout << endl;
+}
+
+swiss_table_iterator swiss_table::begin() const {
+    return swiss_table_iterator(this, 0);
+}
+
+swiss_table_iterator swiss_table::end() const {
+    return swiss_table_iterator(this, capacity);
+}
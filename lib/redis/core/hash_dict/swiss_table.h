@@ -0,0 +1,323 @@
+#pragma once
+
+#include "hash_table.h"
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// 前向声明
+class swiss_table;
+class swiss_table_iterator;
+
+// 控制字节: 满槽为0b0xxxxxxx(低7位为哈希值的h2部分)，空槽与删除标记最高位为1
+typedef int8_t swiss_ctrl;
+const swiss_ctrl ctrl_empty = -128;  // 0b10000000
+const swiss_ctrl ctrl_deleted = -2;  // 0b11111110
+
+// 最大负载因子7/8，开放寻址下再高会使探测序列迅速变长
+const static float swiss_max_load = 0.875;
+const static float swiss_shrink_threshold = 0.2;
+
+// 不超过该长度的key直接内联在槽位中，不额外分配内存
+const size_t swiss_inline_key_len = 16;
+
+// 一组控制字节，一次比较整组
+// 按编译选项依次选用AVX2(32字节)、SSE2(16字节)，否则退化为逐字节比较(8字节)
+struct swiss_group {
+#if defined(__AVX2__)
+    static const size_t width = 32;
+    typedef uint32_t mask_t;
+
+    __m256i ctrl;
+    explicit swiss_group(const swiss_ctrl* p)
+        : ctrl(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))) {}
+
+    // 控制字节等于h2的槽位
+    inline mask_t match(swiss_ctrl h2) const {
+        return _mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(ctrl, _mm256_set1_epi8(h2)));
+    }
+    inline mask_t match_empty() const { return match(ctrl_empty); }
+    // 空槽或删除标记(均小于-1)
+    inline mask_t match_empty_or_deleted() const {
+        return _mm256_movemask_epi8(
+            _mm256_cmpgt_epi8(_mm256_set1_epi8(-1), ctrl));
+    }
+#elif defined(__SSE2__)
+    static const size_t width = 16;
+    typedef uint32_t mask_t;
+
+    __m128i ctrl;
+    explicit swiss_group(const swiss_ctrl* p)
+        : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) {}
+
+    inline mask_t match(swiss_ctrl h2) const {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2)));
+    }
+    inline mask_t match_empty() const { return match(ctrl_empty); }
+    inline mask_t match_empty_or_deleted() const {
+        return _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl));
+    }
+#else
+    static const size_t width = 8;
+    typedef uint32_t mask_t;
+
+    const swiss_ctrl* ctrl;
+    explicit swiss_group(const swiss_ctrl* p) : ctrl(p) {}
+
+    inline mask_t match(swiss_ctrl h2) const {
+        mask_t mask = 0;
+        for (size_t i = 0; i < width; i++)
+            mask |= static_cast<mask_t>(ctrl[i] == h2) << i;
+        return mask;
+    }
+    inline mask_t match_empty() const { return match(ctrl_empty); }
+    inline mask_t match_empty_or_deleted() const {
+        mask_t mask = 0;
+        for (size_t i = 0; i < width; i++)
+            mask |= static_cast<mask_t>(ctrl[i] < -1) << i;
+        return mask;
+    }
+#endif
+};
+
+// 槽位
+// 占24字节内存(4+4+16)，短key内联存储，长key存指针
+struct swiss_slot {
+    uint32_t len;
+    int val;
+    union {
+        char inline_key[swiss_inline_key_len];
+        char* heap_key;
+    };
+
+    inline const char* data() const {
+        return len <= swiss_inline_key_len ? inline_key : heap_key;
+    }
+    inline bool equals(string_view key) const {
+        return key.size() == len && memcmp(data(), key.data(), len) == 0;
+    }
+};
+
+// 开放寻址哈希表(Swiss table)
+// 控制字节与槽位分开存放，查找时先以SIMD整组比较h2，只有命中时才访问槽位；
+// 扩缩容为一次性rehash，不支持渐进式rehash；长key从表的slab分配器中分配
+class swiss_table {
+    friend class swiss_table_iterator;
+
+public:
+    typedef swiss_table_iterator iterator;
+
+    swiss_table(const unsigned long size = swiss_group::width);
+    ~swiss_table();
+
+    // 与hash_table使用相同的哈希函数
+    static inline size_t hashFunction(string_view key) {
+        return hash_table::hashFunction(key);
+    }
+
+    // 负载因子
+    inline float load_factor() const {
+        return capacity > 0 ? static_cast<float>(used) / capacity : 0.0f;
+    }
+
+    /* 查找对应键值对应迭代器
+       返回值：键值是否存在?对应迭代器:end */
+    swiss_table_iterator find(string_view key, size_t hash);
+    swiss_table_iterator find(string_view key);
+
+    /* 查找对应键值对应val，返回值以传输引用方式获得
+       返回值：键值是否存在?hashOk:hashErr */
+    int findval(string_view key, size_t hash, int& val);
+    inline int findval(string_view key, int& val) {
+        return findval(key, hashFunction(key), val);
+    }
+
+    /* 插入键值对，并判断是否需要expand
+       返回值：插入是否成功 */
+    int insert(string_view key, const int& val);
+
+    /* 查找key，不存在则以val插入；只计算一次哈希、只探测一次
+       inserted返回是否新插入
+       返回值：指向key对应val的指针，在下一次修改哈希表前有效；分配失败返回nullptr */
+    int* find_or_insert(string_view key, size_t hash, const int& val,
+                        bool& inserted);
+    inline int* find_or_insert(string_view key, const int& val,
+                               bool& inserted) {
+        return find_or_insert(key, hashFunction(key), val, inserted);
+    }
+
+    /* 删除键值对，并判断是否需要shrink
+       返回值：删除key对应的val */
+    int remove(string_view key, size_t hash);
+    inline int remove(string_view key) {
+        return remove(key, hashFunction(key));
+    }
+
+    // 批量操作时的两阶段预取：先预取探测起点的控制字节组，
+    // 控制字节到达缓存后再预取组内首个h2匹配的槽位
+    inline void prefetch(size_t hash) const {
+        __builtin_prefetch(ctrl + (h1(hash) & groupmask) * swiss_group::width);
+    }
+    inline void prefetch_entry(size_t hash) const {
+        unsigned long base = (h1(hash) & groupmask) * swiss_group::width;
+        auto mask = swiss_group(ctrl + base).match(h2(hash));
+        if (mask)
+            __builtin_prefetch(slots + base + __builtin_ctz(mask));
+    }
+
+    /* 随机返回n个指向哈希表条目的迭代器
+       distinct为true时返回min(n, len)个互不相同的条目，否则有放回地抽取n个
+       返回值：指向随机条目的迭代器数组，表为空时为空 */
+    vector<swiss_table_iterator> random(size_t n, bool distinct = false);
+
+    /* 均匀随机返回一个条目，期望O(1)
+       返回值：表为空时为end */
+    swiss_table_iterator random_one() const;
+
+    // 清空哈希表（不重置为初始大小），长key内存一次性归还
+    void clear();
+
+    // 一次性rehash为指定容量(向上取整到组宽度的2的幂倍)
+    void rehash(unsigned long newSize);
+
+    /* SCAN：以游标cursor扫描一组，对所有探测起点为该组的节点调用fn(key, val)
+       这些节点位于从该组开始的探测序列上，直到第一个含空槽的组为止
+       返回值：下一次扫描的游标，为0表示扫描结束
+       组数为2的幂，游标按反向二进制递增，保证与hash_table相同 */
+    template <class Fn> unsigned long scan(unsigned long cursor, Fn fn) const {
+        if (isEmpty())
+            return 0;
+
+        unsigned long home = cursor & groupmask;
+        unsigned long g = home;
+        for (unsigned long step = 1; step <= groupmask + 1; step++) {
+            unsigned long base = g * swiss_group::width;
+            for (unsigned long pos = base; pos < base + swiss_group::width;
+                 pos++) {
+                if (ctrl[pos] < 0)
+                    continue;
+                string_view key(slots[pos].data(), slots[pos].len);
+                if ((h1(hashFunction(key)) & groupmask) == home)
+                    fn(key, slots[pos].val);
+            }
+            if (swiss_group(ctrl + base).match_empty())
+                break;
+            g = (g + step) & groupmask;
+        }
+        return scan_next_cursor(cursor, groupmask);
+    }
+
+    // 与hash_table接口保持一致，扩缩容一次完成，无需渐进式迁移
+    inline int rehash_milliseconds(int ms) { return 0; }
+    inline void pause_rehash() {}
+    inline void resume_rehash() {}
+
+    // 打印哈希表
+    void print() const;
+
+    // 起始位置迭代器
+    swiss_table_iterator begin() const;
+
+    // 尾后迭代器
+    swiss_table_iterator end() const;
+
+    int getSize() const { return this->capacity; };
+
+    unsigned long len() const { return used; }
+
+    bool isEmpty() const { return used == 0; }
+
+    // 长key分配器统计信息
+    const slab_stats& alloc_stats() const { return alloc.stats(); }
+
+private:
+    // 控制字节数组，长度为capacity
+    swiss_ctrl* ctrl;
+
+    // 槽位数组，长度为capacity
+    swiss_slot* slots;
+
+    // 槽位数量，为组宽度的2的幂倍
+    unsigned long capacity;
+
+    // 组数量掩码(capacity / width - 1)
+    unsigned long groupmask;
+
+    // 已有节点数量
+    unsigned long used;
+
+    // 删除标记数量，同样会拉长探测序列，计入负载
+    unsigned long deleted;
+
+    // 长key的分配器
+    slab_allocator alloc;
+
+    // h1决定探测起点，h2存入控制字节
+    static inline size_t h1(size_t hash) { return hash >> 7; }
+    static inline swiss_ctrl h2(size_t hash) { return hash & 0x7f; }
+
+    // 查找key所在槽位，不存在则返回-1
+    long find_slot(string_view key, size_t hash) const;
+
+    // 寻找可插入的空槽或删除标记
+    unsigned long find_insert_slot(size_t hash) const;
+
+    // 分配指定容量的空表
+    bool alloc_table(unsigned long cap);
+
+    // 释放槽位中的长key
+    inline void free_slot(swiss_slot& slot) {
+        if (slot.len > swiss_inline_key_len)
+            alloc.deallocate(slot.heap_key, slot.len);
+    }
+};
+
+// swiss_table_iterator迭代器
+// 按槽位顺序遍历所有满槽
+class swiss_table_iterator {
+public:
+    swiss_table_iterator(const swiss_table* st, unsigned long pos)
+        : st(st), pos(pos) {
+        skipEmpty();
+    }
+
+    // 前缀自增，移动到下一个元素
+    swiss_table_iterator& operator++() {
+        pos++;
+        skipEmpty();
+        return *this;
+    }
+
+    // 对应slot中的方法
+    inline const string key() {
+        const swiss_slot& slot = st->slots[pos];
+        return string(slot.data(), slot.len);
+    };
+    inline string_view keyview() {
+        const swiss_slot& slot = st->slots[pos];
+        return string_view(slot.data(), slot.len);
+    };
+    inline const int val() { return st->slots[pos].val; };
+    // 槽位的唯一标识，用于随机采样去重
+    inline const void* id() const { return st->slots + pos; };
+
+    bool operator==(const swiss_table_iterator& other) const {
+        return st == other.st && pos == other.pos;
+    }
+
+    bool operator!=(const swiss_table_iterator& other) const {
+        return !(*this == other);
+    }
+
+private:
+    const swiss_table* st;
+    unsigned long pos; // 当前槽位，capacity为尾后
+
+    void skipEmpty() {
+        while (pos < st->capacity && st->ctrl[pos] < 0)
+            pos++;
+    }
+};
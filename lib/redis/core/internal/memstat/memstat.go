@@ -0,0 +1,21 @@
+// Package memstat 测试与基准测试共用的进程内存统计
+package memstat
+
+import (
+	"fmt"
+	"os"
+)
+
+// RSS 进程常驻内存(字节)，读取失败返回0
+// 读取/proc/self/statm的第二列(常驻页数)乘以页大小；C++侧的分配不经过Go的内存统计，
+// 比较cgo数据结构的内存占用只能看RSS
+func RSS() uint64 {
+	f, err := os.Open("/proc/self/statm")
+	if err != nil {
+		return 0
+	}
+	defer f.Close()
+	var size, resident uint64
+	fmt.Fscan(f, &size, &resident)
+	return resident * uint64(os.Getpagesize())
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <vector>
 #include <iostream>
 #include <cstdio>
@@ -5,6 +6,13 @@
 #include <cstring>
 #include <cstdint>
 #include <climits>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
 extern "C" {
@@ -21,6 +29,282 @@ extern "C" {
 
 typedef uint8_t Encoding;
 
+// 元素个数不超过该值时用线性扫描代替二分查找：
+// 整个数组只有几条缓存行，顺序比较(SIMD)没有难以预测的分支
+// 没有对应SIMD比较指令的元素类型逐个比较，只在很小时才划算
+const int intset_linear_scan_max = 64;
+const int intset_scalar_scan_max = 8;
+
+// 一组元素的SIMD比较，按编译选项依次选用AVX2(32字节)、SSE2(16字节)，
+// 否则enabled为false，退化为逐个比较；SSE2没有64位的比较，int64需要SSE4.2
+// gt(a, b)在a > b的通道上为全1(即-1)，从累加器中减去即为计数加一，不需要popcnt指令
+// all(m)判断比较结果是否所有通道都为真
+template <typename T>
+struct intset_simd {
+    static const bool enabled = false;
+};
+
+#if defined(__AVX2__)
+typedef __m256i intset_vec;
+#define INTSET_SIMD_OPS(T, cmp, set)                                           \
+    template <>                                                                \
+    struct intset_simd<T> {                                                    \
+        static const bool enabled = true;                                      \
+        typedef intset_vec vec;                                                \
+        static inline intset_vec load(const T* p) {                            \
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));    \
+        }                                                                      \
+        static inline intset_vec set1(T v) { return _mm256_set1_##set(v); }    \
+        static inline intset_vec gt(intset_vec a, intset_vec b) {              \
+            return _mm256_cmpgt_##cmp(a, b);                                   \
+        }                                                                      \
+        static inline intset_vec sub(intset_vec a, intset_vec b) {             \
+            return _mm256_sub_##cmp(a, b);                                     \
+        }                                                                      \
+        static inline bool all(intset_vec m) {                                 \
+            return _mm256_movemask_epi8(m) == -1;                              \
+        }                                                                      \
+    };
+INTSET_SIMD_OPS(int8_t, epi8, epi8)
+INTSET_SIMD_OPS(int16_t, epi16, epi16)
+INTSET_SIMD_OPS(int32_t, epi32, epi32)
+INTSET_SIMD_OPS(int64_t, epi64, epi64x)
+#elif defined(__SSE2__)
+typedef __m128i intset_vec;
+#define INTSET_SIMD_OPS(T, cmp, set)                                           \
+    template <>                                                                \
+    struct intset_simd<T> {                                                    \
+        static const bool enabled = true;                                      \
+        typedef intset_vec vec;                                                \
+        static inline intset_vec load(const T* p) {                            \
+            return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));       \
+        }                                                                      \
+        static inline intset_vec set1(T v) { return _mm_set1_##set(v); }       \
+        static inline intset_vec gt(intset_vec a, intset_vec b) {              \
+            return _mm_cmpgt_##cmp(a, b);                                      \
+        }                                                                      \
+        static inline intset_vec sub(intset_vec a, intset_vec b) {             \
+            return _mm_sub_##cmp(a, b);                                        \
+        }                                                                      \
+        static inline bool all(intset_vec m) {                                 \
+            return _mm_movemask_epi8(m) == 0xFFFF;                             \
+        }                                                                      \
+    };
+INTSET_SIMD_OPS(int8_t, epi8, epi8)
+INTSET_SIMD_OPS(int16_t, epi16, epi16)
+INTSET_SIMD_OPS(int32_t, epi32, epi32)
+#if defined(__SSE4_2__)
+INTSET_SIMD_OPS(int64_t, epi64, epi64x)
+#endif
+#endif
+
+// 有序数组data[0, n)中小于v的元素个数，n不超过intset_linear_scan_max，
+// 每个通道的计数不会超出T的范围
+template <typename T>
+static inline int count_less(const T* data, int n, T v)
+{
+    int i = 0, cnt = 0;
+    if constexpr (intset_simd<T>::enabled) {
+        typedef intset_simd<T> simd;
+        typedef typename simd::vec vec;
+        const int width = sizeof(vec) / sizeof(T);
+        const vec key = simd::set1(v);
+        vec acc = simd::set1(0);
+        for (; i + width <= n; i += width) {
+            acc = simd::sub(acc, simd::gt(key, simd::load(data + i)));
+        }
+        T lanes[width];
+        memcpy(lanes, &acc, sizeof(acc));
+        for (int j = 0; j < width; j++) {
+            cnt += lanes[j];
+        }
+    }
+    for (; i < n; i++) {
+        cnt += data[i] < v;
+    }
+    return cnt;
+}
+
+#if defined(__SSE2__) && !defined(__AVX2__)
+// v的16字节按T解释，与符号掩码(0 > v)交错即得到两倍宽的元素(符号扩展)，逐级扩展到int64写入out
+template <typename T>
+static inline void widen_store(__m128i v, int64_t* out)
+{
+    if constexpr (sizeof(T) == 8) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+    } else {
+        typedef conditional_t<sizeof(T) == 1, int16_t,
+                              conditional_t<sizeof(T) == 2, int32_t, int64_t>> W;
+        const __m128i zero = _mm_setzero_si128();
+        __m128i lo, hi;
+        if constexpr (sizeof(T) == 1) {
+            __m128i sign = _mm_cmpgt_epi8(zero, v);
+            lo = _mm_unpacklo_epi8(v, sign);
+            hi = _mm_unpackhi_epi8(v, sign);
+        } else if constexpr (sizeof(T) == 2) {
+            __m128i sign = _mm_cmpgt_epi16(zero, v);
+            lo = _mm_unpacklo_epi16(v, sign);
+            hi = _mm_unpackhi_epi16(v, sign);
+        } else {
+            __m128i sign = _mm_cmpgt_epi32(zero, v);
+            lo = _mm_unpacklo_epi32(v, sign);
+            hi = _mm_unpackhi_epi32(v, sign);
+        }
+        widen_store<W>(lo, out);
+        widen_store<W>(hi, out + 8 / sizeof(T));
+    }
+}
+#endif
+
+// 将data[0, n)符号扩展为int64写入out
+// AVX2每次用vpmovsx扩展4个元素；SSE2没有扩展指令，每次16字节逐级与符号掩码交错；否则逐个转换
+template <typename T>
+static void widen(const T* data, int n, int64_t* out)
+{
+    if constexpr (sizeof(T) == 8) {
+        memcpy(out, data, n * sizeof(T));
+        return;
+    }
+    int i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        __m256i w;
+        if constexpr (sizeof(T) == 1) {
+            int32_t bytes;
+            memcpy(&bytes, data + i, sizeof(bytes));
+            w = _mm256_cvtepi8_epi64(_mm_cvtsi32_si128(bytes));
+        } else if constexpr (sizeof(T) == 2) {
+            w = _mm256_cvtepi16_epi64(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data + i)));
+        } else {
+            w = _mm256_cvtepi32_epi64(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), w);
+    }
+#elif defined(__SSE2__)
+    const int width = 16 / sizeof(T);
+    for (; i + width <= n; i += width) {
+        widen_store<T>(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), out + i);
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = data[i];
+    }
+}
+
+// 有序数组data[0, n)中第一个不小于v的位置
+// 二分时每步只有一次比较与条件赋值(编译为cmov)，没有分支预测失败
+template <typename T>
+static inline int lower_bound(const T* data, int n, T v)
+{
+    if (n <= (intset_simd<T>::enabled ? intset_linear_scan_max
+                                       : intset_scalar_scan_max)) {
+        return count_less(data, n, v);
+    }
+    const T* base = data;
+    while (n > 1) {
+        int half = n / 2;
+        base = base[half] < v ? base + half : base;
+        n -= half;
+    }
+    return (base - data) + (*base < v);
+}
+
+// val能否用T表示
+template <typename T>
+static inline bool fits(int64_t val)
+{
+    return val >= numeric_limits<T>::min() && val <= numeric_limits<T>::max();
+}
+
+// 集合运算中a远小于b(b的元素个数超过a的该倍数)时，在b中倍增跳跃(galloping)查找，
+// 否则按块顺序前进
+const int intset_gallop_ratio = 32;
+
+// 有序数组data[0, n)中小于v的前缀长度，从头按块顺序扫描，遇到含有不小于v的块即停止
+// 与count_less不同，n不受限制，代价与跳过的元素个数成正比
+template <typename T>
+static inline int scan_less(const T* data, int n, T v)
+{
+    int i = 0;
+    if constexpr (intset_simd<T>::enabled) {
+        typedef intset_simd<T> simd;
+        typedef typename simd::vec vec;
+        const int width = sizeof(vec) / sizeof(T);
+        const vec key = simd::set1(v);
+        for (; i + width <= n; i += width) {
+            if (!simd::all(simd::gt(key, simd::load(data + i)))) {
+                break;
+            }
+        }
+    }
+    while (i < n && data[i] < v) {
+        i++;
+    }
+    return i;
+}
+
+// 有序数组data[0, n)中第一个不小于v的位置，从头倍增步长直到越过v，再在最后一段中二分
+// 代价为O(log d)，d为跳过的元素个数
+template <typename T>
+static inline int gallop(const T* data, int n, T v)
+{
+    int step = 1;
+    while (step < n && data[step] < v) {
+        step *= 2;
+    }
+    // data[step / 2]之前都小于v(step为1时data[0]尚未比较)
+    int lo = step / 2;
+    int hi = min(step + 1, n);
+    return lo + lower_bound(data + lo, hi - lo, v);
+}
+
+/*
+依次在有序数组b中查找有序数组a的每个元素，对每个元素调用visit(值, 是否在b中)
+a有序，所以b中的查找位置只需单调前进：
+两者大小相近时按SIMD块顺序扫描(即归并)，b远大于a时倍增跳跃，总代价为O(|a| log(|b| / |a|))
+*/
+template <typename A, typename B, typename F>
+static void probe_sorted(const A* a, int na, const B* b, int nb, F&& visit)
+{
+    const bool galloping = nb / intset_gallop_ratio > na;
+    int j = 0;
+    for (int i = 0; i < na; i++) {
+        // 超出b的编码范围的值不在b中
+        if (!fits<B>(a[i])) {
+            visit(a[i], false);
+            continue;
+        }
+        B key = a[i];
+        j += galloping ? gallop(b + j, nb - j, key) : scan_less(b + j, nb - j, key);
+        visit(a[i], j < nb && b[j] == key);
+    }
+}
+
+// 有序数组a、b归并为有序且无重复的out
+template <typename A, typename B>
+static void merge_sorted(const A* a, int na, const B* b, int nb, vector<int64_t>& out)
+{
+    int i = 0, j = 0;
+    while (i < na && j < nb) {
+        int64_t x = a[i], y = b[j];
+        if (x < y) {
+            out.push_back(x);
+            i++;
+        } else if (x > y) {
+            out.push_back(y);
+            j++;
+        } else {
+            out.push_back(x);
+            i++;
+            j++;
+        }
+    }
+    out.insert(out.end(), a + i, a + na);
+    out.insert(out.end(), b + j, b + nb);
+}
+
 class intset {
 private:
     Encoding encoding;
@@ -28,50 +312,148 @@ private:
     vector<uint8_t> store;
 
     void upgrade(Encoding target);
+    // 所有元素都能用更窄的target表示时降级
+    void downgrade(Encoding target);
+    // 删除后容量远大于实际大小时释放多余的空间
+    void shrink();
+
+    // 将store调整为n个当前编码的元素，容量不足时至少翻倍，逐个添加为均摊O(1)的分配
+    void resize(int n);
+
+    // 按当前编码的元素类型调用f(T())，每次操作只分派一次
+    template <typename F>
+    auto dispatch(F&& f) const;
 
-    int insert(int64_t val, int pos);
+    template <typename T>
+    T* elements() { return reinterpret_cast<T*>(store.data()); }
+    template <typename T>
+    const T* elements() const { return reinterpret_cast<const T*>(store.data()); }
 
-    /// @brief 查找元素的位置
+    // 在pos处插入val，由调用方保证编码足够宽
+    template <typename T>
+    void insert(int64_t val, int pos);
+
+    /// @brief 查找元素的位置，T为当前编码的元素类型
     /// @param val
     /// @return 若元素存在，则返回元素位置（大于等于0）；否则，返回应该插入的位置（之前）的相反数减一。
-    int find_index(int64_t val);
+    template <typename T>
+    int find_index(int64_t val) const;
+    template <typename T>
+    int remove(int64_t val);
+    // 将有序且无重复的vals一次合并进来，由调用方保证编码足够宽
+    template <typename T>
+    int merge(const vector<int64_t>& vals);
+
+    // 由有序且无重复的vals构建，编码为容纳两端元素的最小编码
+    static intset* from_sorted(const vector<int64_t>& vals);
+
+    // 按a、b的元素类型调用f(A(), B())
+    template <typename F>
+    static auto dispatch2(const intset& a, const intset& b, F&& f);
 public:
     intset();
+    // 集合运算，结果为新建的整数集合，a、b不变
+    static intset* intersect(const intset& a, const intset& b);
+    static intset* unite(const intset& a, const intset& b);
+    static intset* difference(const intset& a, const intset& b);
     int add(int64_t val);
+    // 批量添加，先排序去重，至多升级一次，再与现有元素一遍合并；返回新增的个数
+    int add_many(const int64_t* vals, int n);
     int remove(int64_t val);
     int find(int64_t val);
     int64_t random();
     int64_t get(int index);
+    // 将从start开始的至多n个元素按int64复制到out，返回复制的个数
+    int export_range(int start, int64_t* out, int n);
     int len();
     int blob_len();
+    // 占用的内存(字节)，包括未使用的容量
+    size_t memory_usage();
     void debug();
 };
 
+template <typename F>
+auto intset::dispatch(F&& f) const
+{
+    switch (encoding) {
+    case ENC_INT8:
+        return f(int8_t());
+    case ENC_INT16:
+        return f(int16_t());
+    case ENC_INT32:
+        return f(int32_t());
+    default:
+        return f(int64_t());
+    }
+}
+
+template <typename F>
+auto intset::dispatch2(const intset& a, const intset& b, F&& f)
+{
+    return a.dispatch([&](auto ta) {
+        return b.dispatch([&](auto tb) { return f(ta, tb); });
+    });
+}
+
+// 将val按编码enc写入data的第index个元素
+static void set_value(uint8_t* data, Encoding enc, int index, int64_t val)
+{
+    switch (enc) {
+    case ENC_INT8:
+        reinterpret_cast<int8_t*>(data)[index] = val;
+        break;
+    case ENC_INT16:
+        reinterpret_cast<int16_t*>(data)[index] = val;
+        break;
+    case ENC_INT32:
+        reinterpret_cast<int32_t*>(data)[index] = val;
+        break;
+    default:
+        reinterpret_cast<int64_t*>(data)[index] = val;
+    }
+}
+
+void intset::resize(int n)
+{
+    size_t size = (size_t(1) << encoding) * n;
+    if (size > store.capacity()) {
+        store.reserve(max(size, 2 * store.capacity()));
+    }
+    store.resize(size, 0);
+}
+
 void intset::upgrade(Encoding target)
 {
-    int current_bit_size = 1 << encoding;
     int target_bit_size = 1 << target;
+    store.resize(target_bit_size * length, 0);
 
-    int current_blob_len = current_bit_size * length;
-    int target_blob_len = target_bit_size * length;
+    // 从后往前逐个按新编码重写(带符号扩展)，
+    // 第i个元素的新位置不会覆盖前面尚未读取的元素
+    for (int i = length - 1; i >= 0; i--) {
+        set_value(store.data(), target, i, get(i));
+    }
 
-    store.resize(target_blob_len, 0);
-    auto data = store.data();
+    encoding = target;
+}
 
-    for (int i = length - 1; i >= 0; i--) {
-        // 需要根据大小端字序来条件编译
-#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
-        int ol = i * current_bit_size;
-        int nl = i * target_bit_size + target_bit_size - current_bit_size;
-        memcpy(data + nl, data + ol, current_bit_size);
-#else
-        int ol = i * current_bit_size;
-        int nl = i * target_bit_size;
-        memcpy(data + nl, data + ol, current_bit_size);
-#endif
+void intset::downgrade(Encoding target)
+{
+    // 从前往后逐个按新编码重写，
+    // 第i个元素的新位置不会覆盖后面尚未读取的元素
+    for (int i = 0; i < length; i++) {
+        set_value(store.data(), target, i, get(i));
     }
 
     encoding = target;
+    store.resize((size_t(1) << target) * length);
+}
+
+void intset::shrink()
+{
+    // 超过4倍才收缩，与resize的翻倍错开，增删交替时不会反复分配
+    if (store.capacity() > 4 * store.size()) {
+        store.shrink_to_fit();
+    }
 }
 
 Encoding encoding_level(int64_t val) {
@@ -105,69 +487,34 @@ Encoding encoding_level(int64_t val) {
     }
 }
 
-int intset::insert(int64_t val, int pos)
+template <typename T>
+void intset::insert(int64_t val, int pos)
 {
-    auto target_encoding = encoding_level(val);
-    if (target_encoding > encoding) {
-        // 需要升级
-        upgrade(target_encoding);
-    }
-
     // 扩容
-    auto bit_size = 1 << encoding;
-    auto new_size = bit_size * (length + 1);
-    store.resize(new_size, 0);
-
-    // 挪动数据
-    auto data = store.data();
-    int ol = bit_size * pos;
-    int nl = bit_size * (pos + 1);
-    memcpy(data + nl, data + ol, (length - pos) * bit_size);
-
-    // 复制数据
-    uint8_t val_ptr[8]{};
-    *(int64_t*)val_ptr = val;
-#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
-    memcpy(data + bit_size * pos,val_ptr + 8 - bit_size, bit_size);
-#else
-    memcpy(data + bit_size * pos, val_ptr, bit_size);
-#endif
+    resize(length + 1);
 
-    length++;
+    // 挪动数据(区间重叠，用memmove)
+    T* data = elements<T>();
+    memmove(data + pos + 1, data + pos, (length - pos) * sizeof(T));
+    data[pos] = val;
 
-    return OK;
+    length++;
 }
 
-int intset::find_index(int64_t val)
+template <typename T>
+int intset::find_index(int64_t val) const
 {
-    auto check = [this, &val](const int i) {
-        return this->get(i) <= val;
-        };
-
-    if (length == 0) {
-        return -1;
+    // 超出当前编码范围的值必然不存在，且比所有元素都小或都大
+    if (!fits<T>(val)) {
+        return val < 0 ? -1 : -length - 1;
     }
 
-    int l = 0, r = length - 1;
-    int result = -1; // 使用一个变量来保存找到的满足条件的最右边元素的索引
-    while (l <= r) {
-        int mid = l + (r - l) / 2; // 防止溢出
-        if (check(mid)) {
-            result = mid; // 更新满足条件的索引
-            l = mid + 1; // 尝试找到更右边的满足条件的元素
-        } else {
-            r = mid - 1;
-        }
-    }
-
-    if (get(result) != val) {
-//        cout << "find_index(" << val << ") = " << -result - 2 << " ; result = " << result << " ; get(result) = "<< get(result) << endl;
-        return -result - 2;
+    const T* data = elements<T>();
+    int pos = lower_bound(data, length, static_cast<T>(val));
+    if (pos < length && data[pos] == val) {
+        return pos;
     }
-
-//     cout << "find_index(" << val << ") = " << result << endl;
-
-    return result;
+    return -pos - 1;
 }
 
 intset::intset() : encoding(ENC_INT8), length(0)
@@ -175,39 +522,122 @@ intset::intset() : encoding(ENC_INT8), length(0)
 
 int intset::add(int64_t val)
 {
-    auto fi = find_index(val);
-    if (fi < 0) {
-        fi = -(fi + 1);
-        insert(val, fi);
+    auto target_encoding = encoding_level(val);
+    if (target_encoding > encoding) {
+        // 需要升级；超出原编码范围的值比所有元素都小或都大，直接放在两端
+        upgrade(target_encoding);
+        int pos = val < 0 ? 0 : length;
+        dispatch([&](auto t) { this->insert<decltype(t)>(val, pos); });
         return OK;
     }
-    return Err;
+
+    return dispatch([&](auto t) {
+        using T = decltype(t);
+        int fi = this->find_index<T>(val);
+        if (fi >= 0) {
+            return Err;
+        }
+        this->insert<T>(val, -(fi + 1));
+        return OK;
+    });
 }
 
+int intset::add_many(const int64_t* vals, int n)
+{
+    if (n == 0) {
+        return 0;
+    }
+    if (n == 1) {
+        return add(vals[0]) == OK ? 1 : 0;
+    }
+
+    vector<int64_t> sorted(vals, vals + n);
+    sort(sorted.begin(), sorted.end());
+    sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+
+    // 有序后只需看两端即可确定所需编码
+    auto target_encoding = max(encoding_level(sorted.front()),
+                               encoding_level(sorted.back()));
+    if (target_encoding > encoding) {
+        upgrade(target_encoding);
+    }
+    return dispatch([&](auto t) { return this->merge<decltype(t)>(sorted); });
+}
+
+template <typename T>
+int intset::merge(const vector<int64_t>& vals)
+{
+    // 归并到新的存储中，已存在的值只保留一份
+    vector<uint8_t> merged(sizeof(T) * (length + vals.size()));
+    T* out = reinterpret_cast<T*>(merged.data());
+    const T* cur = elements<T>();
+    const T* end = cur + length;
+    auto next = vals.begin();
+    int k = 0;
+    while (cur < end && next != vals.end()) {
+        if (*cur < *next) {
+            out[k++] = *cur++;
+        } else if (*cur > *next) {
+            out[k++] = *next++;
+        } else {
+            out[k++] = *cur++;
+            next++;
+        }
+    }
+    while (cur < end) {
+        out[k++] = *cur++;
+    }
+    while (next != vals.end()) {
+        out[k++] = *next++;
+    }
+
+    int added = k - length;
+    merged.resize(sizeof(T) * k);
+    store.swap(merged);
+    length = k;
+    return added;
+}
+
+template <typename T>
 int intset::remove(int64_t val)
 {
-    auto fi = find_index(val);
+    int fi = find_index<T>(val);
     if (fi < 0) {
         return Err;
     }
 
     // 挪动元素
-    auto bit_size = 1 << encoding;
-    auto data = store.data();
-    int ol = bit_size * (fi + 1);
-    int nl = bit_size * fi;
-    memcpy(data + nl,  data + ol, (length - fi - 1) * bit_size);
+    T* data = elements<T>();
+    memmove(data + fi, data + fi + 1, (length - fi - 1) * sizeof(T));
 
     length--;
-    auto new_size = bit_size * length;
-    store.resize(new_size);
+    store.resize(sizeof(T) * length);
+
+    // 有序，所需编码只由两端元素决定，删除的是两端元素时才可能降级
+    if (fi == 0 || fi == length) {
+        Encoding target = ENC_INT8;
+        if (length > 0) {
+            target = max(encoding_level(data[0]), encoding_level(data[length - 1]));
+        }
+        if (target < encoding) {
+            downgrade(target);
+        }
+    }
+    shrink();
 
-    return 0;
+    return OK;
+}
+
+int intset::remove(int64_t val)
+{
+    return dispatch([&](auto t) { return this->remove<decltype(t)>(val); });
 }
 
 int intset::find(int64_t val)
 {
-    return find_index(val) >= 0 ? OK : Err;
+    return dispatch([&](auto t) {
+        return this->find_index<decltype(t)>(val) >= 0 ? OK : Err;
+    });
 }
 
 int64_t intset::random()
@@ -225,31 +655,91 @@ int64_t intset::get(int index)
         return -1;
     }
 
-    switch (this->encoding)
-    {
-    case ENC_INT8:
-    {
-        auto ptr = this->store.data() + index;
-        return *(int8_t*)ptr;
-    }
-    case ENC_INT16:
-    {
-        auto ptr = this->store.data() + index * 2;
-        return *(int16_t*)ptr;
-    }
-    case ENC_INT32:
-    {
-        auto ptr = this->store.data() + index * 4;
-        return *(int32_t*)ptr;
+    return dispatch([&](auto t) -> int64_t {
+        return this->elements<decltype(t)>()[index];
+    });
+}
+
+intset* intset::from_sorted(const vector<int64_t>& vals)
+{
+    intset* is = new intset();
+    if (vals.empty()) {
+        return is;
     }
-    case ENC_INT64:
-    {
-        auto ptr = this->store.data() + index * 8;
-        return *(int64_t*)ptr;
+    is->encoding = max(encoding_level(vals.front()), encoding_level(vals.back()));
+    is->resize(vals.size());
+    is->length = vals.size();
+    is->dispatch([&](auto t) {
+        using T = decltype(t);
+        T* data = is->elements<T>();
+        for (size_t i = 0; i < vals.size(); i++) {
+            data[i] = vals[i];
+        }
+    });
+    return is;
+}
+
+intset* intset::intersect(const intset& a, const intset& b)
+{
+    // 从小的集合出发在大的集合中查找
+    if (a.length > b.length) {
+        return intersect(b, a);
     }
-    default:
+    vector<int64_t> out;
+    out.reserve(a.length);
+    dispatch2(a, b, [&](auto ta, auto tb) {
+        using A = decltype(ta);
+        using B = decltype(tb);
+        probe_sorted(a.elements<A>(), a.length, b.elements<B>(), b.length,
+                     [&](int64_t val, bool found) {
+                         if (found) {
+                             out.push_back(val);
+                         }
+                     });
+    });
+    return from_sorted(out);
+}
+
+intset* intset::unite(const intset& a, const intset& b)
+{
+    vector<int64_t> out;
+    out.reserve(a.length + b.length);
+    dispatch2(a, b, [&](auto ta, auto tb) {
+        using A = decltype(ta);
+        using B = decltype(tb);
+        merge_sorted(a.elements<A>(), a.length, b.elements<B>(), b.length, out);
+    });
+    return from_sorted(out);
+}
+
+intset* intset::difference(const intset& a, const intset& b)
+{
+    vector<int64_t> out;
+    out.reserve(a.length);
+    dispatch2(a, b, [&](auto ta, auto tb) {
+        using A = decltype(ta);
+        using B = decltype(tb);
+        probe_sorted(a.elements<A>(), a.length, b.elements<B>(), b.length,
+                     [&](int64_t val, bool found) {
+                         if (!found) {
+                             out.push_back(val);
+                         }
+                     });
+    });
+    return from_sorted(out);
+}
+
+int intset::export_range(int start, int64_t* out, int n)
+{
+    if (start < 0 || start >= length || n <= 0) {
         return 0;
     }
+    n = min(n, length - start);
+    dispatch([&](auto t) {
+        using T = decltype(t);
+        widen(this->elements<T>() + start, n, out);
+    });
+    return n;
 }
 
 int intset::len()
@@ -263,6 +753,11 @@ int intset::blob_len()
     return bit_size * length;
 }
 
+size_t intset::memory_usage()
+{
+    return sizeof(intset) + store.capacity();
+}
+
 void intset::debug()
 {
     for (int i = 0;i < length;i++) {
@@ -286,6 +781,33 @@ int IntsetAdd(IntsetHandle handle, long long val)
     return static_cast<intset*>(handle)->add(val);
 }
 
+int IntsetAddMany(IntsetHandle handle, const long long* vals, int n)
+{
+    static_assert(sizeof(long long) == sizeof(int64_t), "long long must be 64-bit");
+    return static_cast<intset*>(handle)->add_many(
+        reinterpret_cast<const int64_t*>(vals), n);
+}
+
+IntsetHandle IntsetCopy(IntsetHandle handle)
+{
+    return new intset(*static_cast<intset*>(handle));
+}
+
+IntsetHandle IntsetIntersect(IntsetHandle a, IntsetHandle b)
+{
+    return intset::intersect(*static_cast<intset*>(a), *static_cast<intset*>(b));
+}
+
+IntsetHandle IntsetUnion(IntsetHandle a, IntsetHandle b)
+{
+    return intset::unite(*static_cast<intset*>(a), *static_cast<intset*>(b));
+}
+
+IntsetHandle IntsetDiff(IntsetHandle a, IntsetHandle b)
+{
+    return intset::difference(*static_cast<intset*>(a), *static_cast<intset*>(b));
+}
+
 int IntsetRemove(IntsetHandle handle, long long val)
 {
     return static_cast<intset*>(handle)->remove(val);
@@ -306,6 +828,12 @@ long long IntsetGet(IntsetHandle handle, int index)
     return static_cast<intset*>(handle)->get(index);
 }
 
+int IntsetExport(IntsetHandle handle, int start, long long* out, int n)
+{
+    return static_cast<intset*>(handle)->export_range(
+        start, reinterpret_cast<int64_t*>(out), n);
+}
+
 int IntsetLen(IntsetHandle handle)
 {
     return static_cast<intset*>(handle)->len();
@@ -316,6 +844,11 @@ int IntsetBlobLen(IntsetHandle handle)
     return static_cast<intset*>(handle)->blob_len();
 }
 
+long long IntsetMemoryUsage(IntsetHandle handle)
+{
+    return static_cast<intset*>(handle)->memory_usage();
+}
+
 // int main() {
 //     intset s;
 //     // s.debug();
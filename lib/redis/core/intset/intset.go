@@ -20,6 +20,9 @@ const (
 // Intset 整数集合
 /**
 用于存储少量的整数
+
+C++对象由finalizer释放；集合运算产生的临时Intset在取出ptr后可能不再可达，
+所以每次cgo调用之后都用runtime.KeepAlive保证调用期间不会被回收
 */
 type Intset struct {
 	ptr unsafe.Pointer
@@ -27,8 +30,11 @@ type Intset struct {
 
 // NewIntset 创建一个新的整数集合
 func NewIntset() *Intset {
-	ptr := C.NewIntset()
+	return wrapIntset(C.NewIntset())
+}
 
+// 包装C++侧新建的整数集合，由GC回收时释放
+func wrapIntset(ptr unsafe.Pointer) *Intset {
 	s := &Intset{ptr: ptr}
 
 	runtime.SetFinalizer(s, func(s *Intset) {
@@ -40,35 +46,108 @@ func NewIntset() *Intset {
 
 // IntsetAdd 添加元素
 func (s *Intset) IntsetAdd(val int64) int {
-	return int(C.IntsetAdd(s.ptr, C.longlong(val)))
+	ret := C.IntsetAdd(s.ptr, C.longlong(val))
+	runtime.KeepAlive(s)
+	return int(ret)
+}
+
+// IntsetAddMany 批量添加元素，只需一次cgo调用；返回新增的元素个数
+func (s *Intset) IntsetAddMany(vals []int64) int {
+	if len(vals) == 0 {
+		return 0
+	}
+	ret := C.IntsetAddMany(s.ptr, (*C.longlong)(unsafe.Pointer(&vals[0])), C.int(len(vals)))
+	runtime.KeepAlive(s)
+	return int(ret)
+}
+
+// IntsetCopy 复制一个新的整数集合
+func (s *Intset) IntsetCopy() *Intset {
+	ret := C.IntsetCopy(s.ptr)
+	runtime.KeepAlive(s)
+	return wrapIntset(ret)
+}
+
+// IntsetIntersect 交集，返回新的整数集合，s与other不变
+// 在大集合中的查找位置单调前进：大小相近时按SIMD块归并，相差悬殊时倍增跳跃
+func (s *Intset) IntsetIntersect(other *Intset) *Intset {
+	ret := C.IntsetIntersect(s.ptr, other.ptr)
+	runtime.KeepAlive(s)
+	runtime.KeepAlive(other)
+	return wrapIntset(ret)
+}
+
+// IntsetUnion 并集，返回新的整数集合，s与other不变
+func (s *Intset) IntsetUnion(other *Intset) *Intset {
+	ret := C.IntsetUnion(s.ptr, other.ptr)
+	runtime.KeepAlive(s)
+	runtime.KeepAlive(other)
+	return wrapIntset(ret)
+}
+
+// IntsetDiff 差集(s中不属于other的元素)，返回新的整数集合，s与other不变
+func (s *Intset) IntsetDiff(other *Intset) *Intset {
+	ret := C.IntsetDiff(s.ptr, other.ptr)
+	runtime.KeepAlive(s)
+	runtime.KeepAlive(other)
+	return wrapIntset(ret)
 }
 
 // IntsetRemove 删除指定元素
 func (s *Intset) IntsetRemove(val int64) int {
-	return int(C.IntsetRemove(s.ptr, C.longlong(val)))
+	ret := C.IntsetRemove(s.ptr, C.longlong(val))
+	runtime.KeepAlive(s)
+	return int(ret)
 }
 
 // IntsetFind 查找指定元素是否存在（返回IntsetOk或IntsetErr）
 func (s *Intset) IntsetFind(val int64) int {
-	return int(C.IntsetFind(s.ptr, C.longlong(val)))
+	ret := C.IntsetFind(s.ptr, C.longlong(val))
+	runtime.KeepAlive(s)
+	return int(ret)
 }
 
 // IntsetRandom 返回随机元素
 func (s *Intset) IntsetRandom() int64 {
-	return int64(C.IntsetRandom(s.ptr))
+	ret := C.IntsetRandom(s.ptr)
+	runtime.KeepAlive(s)
+	return int64(ret)
 }
 
 // IntsetGet 获取指定位置的元素
 func (s *Intset) IntsetGet(index int) int64 {
-	return int64(C.IntsetGet(s.ptr, C.int(index)))
+	ret := C.IntsetGet(s.ptr, C.int(index))
+	runtime.KeepAlive(s)
+	return int64(ret)
+}
+
+// IntsetExport 将从start开始的元素复制到out中(至多len(out)个)，只需一次cgo调用；返回复制的个数
+func (s *Intset) IntsetExport(start int, out []int64) int {
+	if len(out) == 0 {
+		return 0
+	}
+	ret := C.IntsetExport(s.ptr, C.int(start), (*C.longlong)(unsafe.Pointer(&out[0])), C.int(len(out)))
+	runtime.KeepAlive(s)
+	return int(ret)
 }
 
 // IntsetLen 获取元素数量
 func (s *Intset) IntsetLen() int {
-	return int(C.IntsetLen(s.ptr))
+	ret := C.IntsetLen(s.ptr)
+	runtime.KeepAlive(s)
+	return int(ret)
 }
 
 // IntsetBlobLen 获取元素占据空间大小（字节）
 func (s *Intset) IntsetBlobLen() int {
-	return int(C.IntsetBlobLen(s.ptr))
+	ret := C.IntsetBlobLen(s.ptr)
+	runtime.KeepAlive(s)
+	return int(ret)
+}
+
+// IntsetMemoryUsage 获取占用的内存（字节），包括未使用的容量
+func (s *Intset) IntsetMemoryUsage() int {
+	ret := C.IntsetMemoryUsage(s.ptr)
+	runtime.KeepAlive(s)
+	return int(ret)
 }
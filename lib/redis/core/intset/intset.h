@@ -6,6 +6,19 @@ void ReleaseIntset(IntsetHandle handle);
 
 int IntsetAdd(IntsetHandle handle, long long val);
 
+// 一次添加n个元素(可以无序、有重复)，返回新增的个数
+int IntsetAddMany(IntsetHandle handle, const long long* vals, int n);
+
+// 复制一个新的整数集合
+IntsetHandle IntsetCopy(IntsetHandle handle);
+
+// 交集、并集、差集(a中不属于b的元素)，返回新建的整数集合，a、b不变
+IntsetHandle IntsetIntersect(IntsetHandle a, IntsetHandle b);
+
+IntsetHandle IntsetUnion(IntsetHandle a, IntsetHandle b);
+
+IntsetHandle IntsetDiff(IntsetHandle a, IntsetHandle b);
+
 int IntsetRemove(IntsetHandle handle, long long val);
 
 int IntsetFind(IntsetHandle handle, long long val);
@@ -14,6 +27,12 @@ long long IntsetRandom(IntsetHandle handle);
 
 long long IntsetGet(IntsetHandle handle, int index);
 
+// 将从start开始的至多n个元素复制到out，返回复制的个数
+int IntsetExport(IntsetHandle handle, int start, long long* out, int n);
+
 int IntsetLen(IntsetHandle handle);
 
 int IntsetBlobLen(IntsetHandle handle);
+
+// 占用的内存(字节)，包括未使用的容量
+long long IntsetMemoryUsage(IntsetHandle handle);
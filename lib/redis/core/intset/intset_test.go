@@ -1,6 +1,9 @@
 package intset
 
 import (
+	"fmt"
+	"math/rand"
+	"slices"
 	"testing"
 	"time"
 )
@@ -83,3 +86,378 @@ func TestIntsetUpgrade(t *testing.T) {
 	et := time.Now()
 	t.Logf("TestIntsetUpgrade finished in %d us.", et.Sub(st).Microseconds())
 }
+
+// 与有序切片对照，覆盖各编码、线性扫描与二分查找两种规模以及负数的升级
+func TestIntsetRandom(t *testing.T) {
+	limits := []int64{100, 30_000, 2_000_000_000, 1 << 40}
+	for _, limit := range limits {
+		for _, n := range []int{10, 60, 200, 1000} {
+			rnd := rand.New(rand.NewSource(int64(n)))
+			s := NewIntset()
+			ref := map[int64]bool{}
+			for i := 0; i < n; i++ {
+				v := rnd.Int63n(2*limit) - limit
+				res := s.IntsetAdd(v)
+				if (res == Ok) == ref[v] {
+					t.Fatalf("IntsetAdd(%d): got %d, exists %v", v, res, ref[v])
+				}
+				ref[v] = true
+			}
+			for i := 0; i < n/3; i++ {
+				v := rnd.Int63n(2*limit) - limit
+				if res := s.IntsetRemove(v); (res == Ok) != ref[v] {
+					t.Fatalf("IntsetRemove(%d): got %d, exists %v", v, res, ref[v])
+				}
+				delete(ref, v)
+			}
+
+			sorted := make([]int64, 0, len(ref))
+			for v := range ref {
+				sorted = append(sorted, v)
+			}
+			slices.Sort(sorted)
+			if s.IntsetLen() != len(sorted) {
+				t.Fatalf("IntsetLen(): got %d, want %d", s.IntsetLen(), len(sorted))
+			}
+			for i, v := range sorted {
+				if got := s.IntsetGet(i); got != v {
+					t.Fatalf("limit %d, n %d: IntsetGet(%d) = %d, want %d", limit, n, i, got, v)
+				}
+				// 元素本身与其相邻的值
+				for _, probe := range []int64{v - 1, v, v + 1} {
+					if res := s.IntsetFind(probe); (res == Ok) != ref[probe] {
+						t.Fatalf("IntsetFind(%d): got %d, exists %v", probe, res, ref[probe])
+					}
+				}
+			}
+		}
+	}
+
+	// 负数在升级时需要符号扩展
+	s := NewIntset()
+	s.IntsetAdd(-1)
+	s.IntsetAdd(-100)
+	s.IntsetAdd(300)
+	s.IntsetAdd(-70000)
+	s.IntsetAdd(1 << 40)
+	for i, want := range []int64{-70000, -100, -1, 300, 1 << 40} {
+		if got := s.IntsetGet(i); got != want {
+			t.Errorf("After upgrade IntsetGet(%d) = %d, want %d", i, got, want)
+		}
+	}
+}
+
+// SISMEMBER：各编码下不同规模的查找，一半命中
+func BenchmarkIntsetFind(b *testing.B) {
+	encodings := []struct {
+		name  string
+		limit int64
+	}{
+		{"int16", 30_000},
+		{"int32", 2_000_000_000},
+		{"int64", 1 << 40},
+	}
+	for _, enc := range encodings {
+		for _, n := range []int{16, 64, 512, 5000} {
+			b.Run(fmt.Sprintf("%s/%d", enc.name, n), func(b *testing.B) {
+				rnd := rand.New(rand.NewSource(1))
+				s := NewIntset()
+				members := make([]int64, n)
+				for i := range members {
+					members[i] = rnd.Int63n(enc.limit)
+					s.IntsetAdd(members[i])
+				}
+				probes := make([]int64, 1024)
+				for i := range probes {
+					if i%2 == 0 {
+						probes[i] = members[rnd.Intn(n)]
+					} else {
+						probes[i] = rnd.Int63n(enc.limit)
+					}
+				}
+
+				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					s.IntsetFind(probes[i%len(probes)])
+				}
+			})
+		}
+	}
+}
+
+func TestIntsetAddMany(t *testing.T) {
+	rnd := rand.New(rand.NewSource(3))
+	limits := []int64{100, 30_000, 2_000_000_000, 1 << 40}
+	for round := 0; round < 50; round++ {
+		s := NewIntset()
+		ref := map[int64]bool{}
+		// 每轮多批，编码逐批放宽，批内无序且有重复
+		for _, limit := range limits[:1+round%len(limits)] {
+			vals := make([]int64, rnd.Intn(300))
+			for i := range vals {
+				vals[i] = rnd.Int63n(2*limit) - limit
+			}
+			if len(vals) > 1 {
+				vals[len(vals)-1] = vals[0]
+			}
+			added := 0
+			for _, v := range vals {
+				if !ref[v] {
+					added++
+				}
+				ref[v] = true
+			}
+			if got := s.IntsetAddMany(vals); got != added {
+				t.Fatalf("IntsetAddMany: got %d added, want %d", got, added)
+			}
+		}
+
+		sorted := make([]int64, 0, len(ref))
+		for v := range ref {
+			sorted = append(sorted, v)
+		}
+		slices.Sort(sorted)
+		if s.IntsetLen() != len(sorted) {
+			t.Fatalf("IntsetLen(): got %d, want %d", s.IntsetLen(), len(sorted))
+		}
+		for i, v := range sorted {
+			if got := s.IntsetGet(i); got != v {
+				t.Fatalf("IntsetGet(%d) = %d, want %d", i, got, v)
+			}
+		}
+	}
+}
+
+// SADD key id1 ... id5000：逐个添加与一次批量添加
+func BenchmarkIntsetAddMany(b *testing.B) {
+	rnd := rand.New(rand.NewSource(4))
+	vals := make([]int64, 5000)
+	for i := range vals {
+		vals[i] = rnd.Int63n(2_000_000_000)
+	}
+
+	b.Run("single", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			s := NewIntset()
+			for _, v := range vals {
+				s.IntsetAdd(v)
+			}
+		}
+	})
+	b.Run("many", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			NewIntset().IntsetAddMany(vals)
+		}
+	})
+}
+
+// 按元素顺序取出全部元素
+func intsetValues(s *Intset) []int64 {
+	vals := make([]int64, s.IntsetLen())
+	for i := range vals {
+		vals[i] = s.IntsetGet(i)
+	}
+	return vals
+}
+
+func TestIntsetSetOps(t *testing.T) {
+	rnd := rand.New(rand.NewSource(5))
+	limits := []int64{100, 30_000, 2_000_000_000, 1 << 40}
+	// 随机生成大小悬殊(触发倍增跳跃)或相近、编码各异的两个集合
+	randomSet := func() (*Intset, map[int64]bool) {
+		s := NewIntset()
+		ref := map[int64]bool{}
+		n := rnd.Intn(40)
+		if rnd.Intn(2) == 0 {
+			n = rnd.Intn(5000)
+		}
+		limit := limits[rnd.Intn(len(limits))]
+		vals := make([]int64, n)
+		for i := range vals {
+			// 取值集中在小范围内，使交集非空
+			vals[i] = rnd.Int63n(200) - 100
+			if rnd.Intn(3) == 0 {
+				vals[i] = rnd.Int63n(2*limit) - limit
+			}
+			ref[vals[i]] = true
+		}
+		s.IntsetAddMany(vals)
+		return s, ref
+	}
+	expect := func(a, b map[int64]bool, keep func(inA, inB bool) bool) []int64 {
+		var out []int64
+		for _, m := range []map[int64]bool{a, b} {
+			for v := range m {
+				if keep(a[v], b[v]) && !slices.Contains(out, v) {
+					out = append(out, v)
+				}
+			}
+		}
+		slices.Sort(out)
+		return out
+	}
+
+	for round := 0; round < 200; round++ {
+		a, refA := randomSet()
+		b, refB := randomSet()
+		lenA, lenB := a.IntsetLen(), b.IntsetLen()
+		cases := []struct {
+			name string
+			got  *Intset
+			keep func(inA, inB bool) bool
+		}{
+			{"IntsetIntersect", a.IntsetIntersect(b), func(inA, inB bool) bool { return inA && inB }},
+			{"IntsetUnion", a.IntsetUnion(b), func(inA, inB bool) bool { return inA || inB }},
+			{"IntsetDiff", a.IntsetDiff(b), func(inA, inB bool) bool { return inA && !inB }},
+		}
+		for _, c := range cases {
+			want := expect(refA, refB, c.keep)
+			if got := intsetValues(c.got); !slices.Equal(got, want) {
+				t.Fatalf("round %d %s: got %d elements, want %d", round, c.name, len(got), len(want))
+			}
+		}
+		if got := intsetValues(a.IntsetCopy()); !slices.Equal(got, intsetValues(a)) {
+			t.Fatalf("round %d IntsetCopy: got %d elements, want %d", round, len(got), lenA)
+		}
+		// 结果是新的集合，原集合不变
+		if a.IntsetLen() != lenA || b.IntsetLen() != lenB {
+			t.Fatalf("round %d: operands modified", round)
+		}
+	}
+}
+
+// SINTER：5000与5000个元素(归并)、50与5000个元素(倍增跳跃)，与在大集合中逐个查找比较
+func BenchmarkIntsetIntersect(b *testing.B) {
+	rnd := rand.New(rand.NewSource(6))
+	randomSet := func(n int) *Intset {
+		vals := make([]int64, n)
+		for i := range vals {
+			vals[i] = rnd.Int63n(20_000)
+		}
+		s := NewIntset()
+		s.IntsetAddMany(vals)
+		return s
+	}
+	large := randomSet(5000)
+	for _, n := range []int{5000, 50} {
+		small := randomSet(n)
+		smallVals := intsetValues(small)
+		b.Run(fmt.Sprintf("%d/probe", n), func(b *testing.B) {
+			for i := 0; i < b.N; i++ {
+				var hits []int64
+				for _, v := range smallVals {
+					if large.IntsetFind(v) == Ok {
+						hits = append(hits, v)
+					}
+				}
+				NewIntset().IntsetAddMany(hits)
+			}
+		})
+		b.Run(fmt.Sprintf("%d/intersect", n), func(b *testing.B) {
+			for i := 0; i < b.N; i++ {
+				small.IntsetIntersect(large)
+			}
+		})
+	}
+}
+
+func TestIntsetDowngrade(t *testing.T) {
+	s := NewIntset()
+	vals := make([]int64, 512)
+	for i := range vals {
+		vals[i] = int64(i) - 100
+	}
+	s.IntsetAddMany(vals)
+	small := s.IntsetMemoryUsage()
+	if s.IntsetBlobLen() != 2*512 {
+		t.Fatalf("IntsetBlobLen(): got %d, want %d", s.IntsetBlobLen(), 2*512)
+	}
+
+	// 短暂地存放过int64的两端元素，删除后恢复为int16
+	for _, wide := range []int64{1 << 40, -1 << 40} {
+		s.IntsetAdd(wide)
+		if s.IntsetBlobLen() != 8*513 {
+			t.Fatalf("IntsetBlobLen() after adding %d: got %d, want %d", wide, s.IntsetBlobLen(), 8*513)
+		}
+		s.IntsetRemove(wide)
+		if s.IntsetBlobLen() != 2*512 {
+			t.Fatalf("IntsetBlobLen() after removing %d: got %d, want %d", wide, s.IntsetBlobLen(), 2*512)
+		}
+		if s.IntsetMemoryUsage() > 2*small {
+			t.Fatalf("IntsetMemoryUsage(): got %d, want at most %d", s.IntsetMemoryUsage(), 2*small)
+		}
+	}
+	for i, v := range vals {
+		if got := s.IntsetGet(i); got != v {
+			t.Fatalf("IntsetGet(%d) = %d, want %d", i, got, v)
+		}
+	}
+
+	// 删除中间的元素不改变编码；删除到只剩int8范围内的元素后降级为int8
+	s.IntsetRemove(0)
+	if s.IntsetBlobLen() != 2*511 {
+		t.Fatalf("IntsetBlobLen(): got %d, want %d", s.IntsetBlobLen(), 2*511)
+	}
+	for _, v := range vals[228:] {
+		s.IntsetRemove(v)
+	}
+	if s.IntsetLen() != 227 || s.IntsetBlobLen() != 227 {
+		t.Fatalf("IntsetLen() = %d, IntsetBlobLen() = %d, want 227, 227", s.IntsetLen(), s.IntsetBlobLen())
+	}
+	if s.IntsetFind(-100) != Ok || s.IntsetFind(127) != Ok || s.IntsetFind(0) != Err {
+		t.Fatalf("IntsetFind after downgrade: wrong result")
+	}
+	if s.IntsetMemoryUsage() >= small {
+		t.Fatalf("IntsetMemoryUsage(): got %d, want less than %d", s.IntsetMemoryUsage(), small)
+	}
+}
+
+func TestIntsetExport(t *testing.T) {
+	rnd := rand.New(rand.NewSource(7))
+	// 各种编码，元素有正有负，个数不是向量宽度的整数倍
+	for _, limit := range []int64{100, 30_000, 2_000_000_000, 1 << 40} {
+		s := NewIntset()
+		vals := make([]int64, 203)
+		for i := range vals {
+			vals[i] = rnd.Int63n(2*limit) - limit
+		}
+		s.IntsetAddMany(vals)
+		want := intsetValues(s)
+
+		for start := 0; start <= len(want)+1; start += 1 + rnd.Intn(9) {
+			out := make([]int64, rnd.Intn(len(want)+10))
+			n := s.IntsetExport(start, out)
+			wantN := min(len(out), max(len(want)-start, 0))
+			if n != wantN {
+				t.Fatalf("limit %d: IntsetExport(%d, [%d]) = %d, want %d", limit, start, len(out), n, wantN)
+			}
+			if !slices.Equal(out[:n], want[min(start, len(want)):][:n]) {
+				t.Fatalf("limit %d: IntsetExport(%d, [%d]) copied wrong elements", limit, start, len(out))
+			}
+		}
+	}
+}
+
+// SMEMBERS：512个元素逐个IntsetGet与一次IntsetExport
+func BenchmarkIntsetExport(b *testing.B) {
+	s := NewIntset()
+	vals := make([]int64, 512)
+	for i := range vals {
+		vals[i] = int64(i * 37)
+	}
+	s.IntsetAddMany(vals)
+	out := make([]int64, s.IntsetLen())
+
+	b.Run("get", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			for j := range out {
+				out[j] = s.IntsetGet(j)
+			}
+		}
+	})
+	b.Run("export", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			s.IntsetExport(0, out)
+		}
+	})
+}
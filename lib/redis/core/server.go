@@ -1,5 +1,7 @@
 package core
 
+import "sync"
+
 type RedisServer struct {
 	Pid int
 
@@ -16,6 +18,9 @@ type RedisServer struct {
 	IpfdCount  int
 
 	Events *EventLoop
+	// gnet在单独的goroutine中调用OnTick，serverCron与事件循环上的命令执行用DbLock互斥，
+	// 否则rehash会与命令同时修改同一个字典
+	DbLock sync.Mutex
 
 	LruClock uint64
 }
@@ -1,8 +1,11 @@
 package core
 
 import (
+	"cmp"
 	"redis-go/lib/redis/core/hash_dict"
 	"redis-go/lib/redis/core/intset"
+	"slices"
+	"strconv"
 )
 
 const (
@@ -11,10 +14,13 @@ const (
 	encDict          // 底层类型：Dict
 )
 
+// 与redis的set-max-intset-entries含义相同：整数元素个数超过SetMaxIntsetEntries时转换为哈希表
+var SetMaxIntsetEntries = 512
+
 // Set
 /**
 根据存储内容自动选择底层的数据结构；
-在存储少量整数（32个及以下）时，采用整数集合；否则，采取哈希表
+在存储少量整数（不超过SetMaxIntsetEntries个）时，采用整数集合；否则，采取哈希表
 
 Set只可以存储字符串类型。
 */
@@ -23,25 +29,30 @@ type Set struct {
 	ptr interface{}
 }
 
+// 整数集合的所有元素，一次cgo调用批量复制
+func intsetValues(is *intset.Intset) []int64 {
+	vals := make([]int64, is.IntsetLen())
+	is.IntsetExport(0, vals)
+	return vals
+}
+
 // 转换底层格式为哈希表
 func (s *Set) intsetToDict() {
 	if s.enc != encIntset {
 		return
 	}
-	is := s.ptr.(*intset.Intset)
+	integers := intsetValues(s.ptr.(*intset.Intset))
 
-	intsetLen := is.IntsetLen()
-	nums := make([]*Object, 0, intsetLen)
-	for i := range intsetLen {
-		integer := is.IntsetGet(i)
-		nums = append(nums, CreateInteger(integer))
+	keys := make([]string, len(integers))
+	vals := make([]interface{}, len(integers))
+	for i, integer := range integers {
+		keys[i] = strconv.FormatInt(integer, 10)
+		vals[i] = true
 	}
 
+	// 一次cgo调用插入所有元素
 	dict := NewDict()
-	for _, v := range nums {
-		str, _ := v.GetString()
-		dict.DictAdd(str, true)
-	}
+	dict.DictAddMany(keys, vals)
 	s.enc = encDict
 	s.ptr = dict
 }
@@ -53,7 +64,7 @@ func (s *Set) Add(obj *Object) (repeat bool, err error) {
 	}
 
 	// 检查是否需要提升为Dict
-	if s.enc == encIntset && (!obj.IsInteger() || s.Size() >= 32) {
+	if s.enc == encIntset && !obj.IsInteger() {
 		s.intsetToDict()
 	}
 
@@ -74,6 +85,10 @@ func (s *Set) Add(obj *Object) (repeat bool, err error) {
 		repeat = is.IntsetFind(integer) == intset.Ok
 
 		is.IntsetAdd(integer)
+		// 元素过多时提升为Dict
+		if is.IntsetLen() > SetMaxIntsetEntries {
+			s.intsetToDict()
+		}
 	} else if s.enc == encDict {
 		dict := s.ptr.(*Dict)
 		str, _ := obj.GetString()
@@ -86,6 +101,59 @@ func (s *Set) Add(obj *Object) (repeat bool, err error) {
 	return
 }
 
+// AddMany 批量添加元素，返回新增的个数
+// 全为整数时排序后与整数集合一次合并；否则在哈希表中一次cgo调用批量插入
+func (s *Set) AddMany(objs []*Object) (added int, err error) {
+	allIntegers := true
+	for _, obj := range objs {
+		if obj.Type != RedisString {
+			return 0, errNotString
+		}
+		allIntegers = allIntegers && obj.IsInteger()
+	}
+
+	if s.enc == encIntset && !allIntegers {
+		s.intsetToDict()
+	}
+	if s.enc == encNone {
+		if allIntegers {
+			s.enc = encIntset
+			s.ptr = intset.NewIntset()
+		} else {
+			s.enc = encDict
+			s.ptr = hash_dict.NewDict()
+		}
+	}
+
+	if s.enc == encIntset {
+		is := s.ptr.(*intset.Intset)
+		integers := make([]int64, len(objs))
+		for i, obj := range objs {
+			integers[i], _ = obj.GetInteger()
+		}
+		added = is.IntsetAddMany(integers)
+		// 元素过多时提升为Dict
+		if is.IntsetLen() > SetMaxIntsetEntries {
+			s.intsetToDict()
+		}
+		return
+	}
+
+	dict := s.ptr.(*Dict)
+	keys := make([]string, len(objs))
+	vals := make([]interface{}, len(objs))
+	for i, obj := range objs {
+		keys[i], _ = obj.GetString()
+		vals[i] = true
+	}
+	for _, status := range dict.DictAddMany(keys, vals) {
+		if status == hash_dict.DictOk {
+			added++
+		}
+	}
+	return
+}
+
 // Remove 删除元素，元素不存在时不报错
 func (s *Set) Remove(obj *Object) (ok bool, err error) {
 	if obj.Type != RedisString {
@@ -93,6 +161,10 @@ func (s *Set) Remove(obj *Object) (ok bool, err error) {
 	}
 
 	if s.enc == encIntset {
+		// 非整数不可能在整数集合中
+		if !obj.IsInteger() {
+			return false, nil
+		}
 		is := s.ptr.(*intset.Intset)
 		integer, _ := obj.GetInteger()
 
@@ -113,6 +185,10 @@ func (s *Set) Find(obj *Object) bool {
 	}
 
 	if s.enc == encIntset {
+		// 非整数不可能在整数集合中
+		if !obj.IsInteger() {
+			return false
+		}
 		is := s.ptr.(*intset.Intset)
 		integer, _ := obj.GetInteger()
 
@@ -140,12 +216,8 @@ func (s *Set) Size() int {
 
 func (s *Set) ForEach(callback func(object *Object)) {
 	if s.enc == encIntset {
-		is := s.ptr.(*intset.Intset)
-		isl := is.IntsetLen()
-		for i := range isl {
-			integer := is.IntsetGet(i)
-			obj := CreateInteger(integer)
-			callback(obj)
+		for _, integer := range intsetValues(s.ptr.(*intset.Intset)) {
+			callback(CreateInteger(integer))
 		}
 	} else if s.enc == encDict {
 		dict := s.ptr.(*Dict)
@@ -155,3 +227,191 @@ func (s *Set) ForEach(callback func(object *Object)) {
 		})
 	}
 }
+
+// ForEachString 以字符串形式遍历所有元素
+// 整数集合的元素不需要构造Object，所有数字格式化到同一块内存中，回调得到的是其中的子串
+func (s *Set) ForEachString(callback func(str string)) {
+	if s.enc == encIntset {
+		integers := intsetValues(s.ptr.(*intset.Intset))
+		ends := make([]int, len(integers))
+		buf := make([]byte, 0, 8*len(integers))
+		for i, integer := range integers {
+			buf = strconv.AppendInt(buf, integer, 10)
+			ends[i] = len(buf)
+		}
+		all := string(buf)
+		start := 0
+		for _, end := range ends {
+			callback(all[start:end])
+			start = end
+		}
+	} else if s.enc == encDict {
+		dict := s.ptr.(*Dict)
+		dict.ForEach(func(key string, _ interface{}) {
+			callback(key)
+		})
+	}
+}
+
+// 所有元素
+func (s *Set) members() []*Object {
+	objs := make([]*Object, 0, s.Size())
+	s.ForEach(func(obj *Object) {
+		objs = append(objs, obj)
+	})
+	return objs
+}
+
+// 由整数集合构建Set，元素过多时转换为哈希表
+func newSetFromIntset(is *intset.Intset) *Set {
+	s := &Set{enc: encIntset, ptr: is}
+	if is.IntsetLen() > SetMaxIntsetEntries {
+		s.intsetToDict()
+	}
+	return s
+}
+
+// 由元素构建Set，全为整数且不多时为整数集合
+func newSetFromObjects(objs []*Object) *Set {
+	s := &Set{}
+	s.AddMany(objs)
+	return s
+}
+
+// 整数集合is中在(keep为true)或不在(keep为false)哈希表dict中的元素，一次cgo调用批量查找
+func filterIntsetByDict(is *intset.Intset, dict *Dict, keep bool) *intset.Intset {
+	vals := intsetValues(is)
+	keys := make([]string, len(vals))
+	for i, val := range vals {
+		keys[i] = strconv.FormatInt(val, 10)
+	}
+	kept := vals[:0]
+	for i, found := range dict.DictFindMany(keys) {
+		if (found != nil) == keep {
+			kept = append(kept, vals[i])
+		}
+	}
+	result := intset.NewIntset()
+	result.IntsetAddMany(kept)
+	return result
+}
+
+/*
+SetInter 交集(SINTER)
+sets中的nil表示不存在的key，按空集处理
+从元素最少的集合出发：若为整数集合，与其余整数集合有序求交，与哈希表批量查找，结果直接是整数集合；
+否则逐个元素在其余集合中查找，不在某个集合中即可提前放弃
+返回值：新建的集合
+*/
+func SetInter(sets []*Set) *Set {
+	if len(sets) == 0 {
+		return &Set{}
+	}
+	for _, s := range sets {
+		if s == nil || s.Size() == 0 {
+			return &Set{}
+		}
+	}
+	sorted := slices.Clone(sets)
+	slices.SortFunc(sorted, func(a, b *Set) int {
+		return cmp.Compare(a.Size(), b.Size())
+	})
+
+	if smallest := sorted[0]; smallest.enc == encIntset {
+		is := smallest.ptr.(*intset.Intset).IntsetCopy()
+		for _, other := range sorted[1:] {
+			if other.enc == encIntset {
+				is = is.IntsetIntersect(other.ptr.(*intset.Intset))
+			} else {
+				is = filterIntsetByDict(is, other.ptr.(*Dict), true)
+			}
+			if is.IntsetLen() == 0 {
+				break
+			}
+		}
+		return newSetFromIntset(is)
+	}
+
+	var objs []*Object
+	sorted[0].ForEach(func(obj *Object) {
+		for _, other := range sorted[1:] {
+			if !other.Find(obj) {
+				return
+			}
+		}
+		objs = append(objs, obj)
+	})
+	return newSetFromObjects(objs)
+}
+
+/*
+SetUnion 并集(SUNION)
+sets的含义同SetInter；全为整数集合时逐个有序归并，否则批量添加到新的集合中
+*/
+func SetUnion(sets []*Set) *Set {
+	var is *intset.Intset
+	for _, s := range sets {
+		if s == nil || s.enc == encNone {
+			continue
+		}
+		if s.enc != encIntset {
+			is = nil
+			break
+		}
+		if is == nil {
+			is = s.ptr.(*intset.Intset).IntsetCopy()
+		} else {
+			is = is.IntsetUnion(s.ptr.(*intset.Intset))
+		}
+	}
+	if is != nil {
+		return newSetFromIntset(is)
+	}
+
+	result := &Set{}
+	for _, s := range sets {
+		if s != nil {
+			result.AddMany(s.members())
+		}
+	}
+	return result
+}
+
+/*
+SetDiff 差集(SDIFF)：第一个集合中不属于其余任何集合的元素
+sets的含义同SetInter；第一个集合为整数集合时，与其余整数集合有序求差，与哈希表批量查找
+*/
+func SetDiff(sets []*Set) *Set {
+	if len(sets) == 0 || sets[0] == nil || sets[0].Size() == 0 {
+		return &Set{}
+	}
+
+	if first := sets[0]; first.enc == encIntset {
+		is := first.ptr.(*intset.Intset).IntsetCopy()
+		for _, other := range sets[1:] {
+			if is.IntsetLen() == 0 {
+				break
+			}
+			if other == nil || other.enc == encNone {
+				continue
+			}
+			if other.enc == encIntset {
+				is = is.IntsetDiff(other.ptr.(*intset.Intset))
+			} else {
+				is = filterIntsetByDict(is, other.ptr.(*Dict), false)
+			}
+		}
+		return newSetFromIntset(is)
+	}
+
+	var objs []*Object
+	sets[0].ForEach(func(obj *Object) {
+		for _, other := range sets[1:] {
+			if other != nil && other.Find(obj) {
+				return
+			}
+		}
+		objs = append(objs, obj)
+	})
+	return newSetFromObjects(objs)
+}
@@ -0,0 +1,250 @@
+package core
+
+import (
+	"maps"
+	"strconv"
+	"testing"
+)
+
+// 由字符串成员构建集合，members为nil时返回nil(表示不存在的key)
+func newTestSet(members []string) *Set {
+	if members == nil {
+		return nil
+	}
+	s := &Set{}
+	objs := make([]*Object, len(members))
+	for i, member := range members {
+		objs[i] = CreateString(member)
+	}
+	s.AddMany(objs)
+	return s
+}
+
+// 集合的所有成员
+func setMembers(s *Set) map[string]struct{} {
+	members := map[string]struct{}{}
+	if s != nil {
+		s.ForEachString(func(str string) {
+			members[str] = struct{}{}
+		})
+	}
+	return members
+}
+
+// 成员列表对应的参照集合
+func refSet(members []string) map[string]struct{} {
+	ref := map[string]struct{}{}
+	for _, member := range members {
+		ref[member] = struct{}{}
+	}
+	return ref
+}
+
+// 由0到n-1组成的成员列表
+func integerMembers(n int) []string {
+	members := make([]string, n)
+	for i := range members {
+		members[i] = strconv.Itoa(i)
+	}
+	return members
+}
+
+// 检查成员与编码：全为整数且不超过SetMaxIntsetEntries时应为整数集合，否则为哈希表
+func checkSet(t *testing.T, s *Set, want map[string]struct{}) {
+	t.Helper()
+	got := setMembers(s)
+	if !maps.Equal(got, want) {
+		t.Fatalf("members = %v, want %v", got, want)
+	}
+	if s.Size() != len(want) {
+		t.Fatalf("Size() = %d, want %d", s.Size(), len(want))
+	}
+	if len(want) == 0 {
+		return
+	}
+	allIntegers := true
+	for member := range want {
+		allIntegers = allIntegers && IsInteger(member)
+	}
+	wantIntset := allIntegers && len(want) <= SetMaxIntsetEntries
+	if (s.enc == encIntset) != wantIntset {
+		t.Fatalf("intset encoding = %t, want %t", s.enc == encIntset, wantIntset)
+	}
+}
+
+func TestSetAddMany(t *testing.T) {
+	tests := []struct {
+		name       string
+		maxIntset  int
+		batches    [][]string
+		wantAdded  []int
+		wantIntset bool
+	}{
+		{"duplicates in one batch", 512, [][]string{{"1", "2", "2", "3", "1"}}, []int{3}, true},
+		{"existing members", 512, [][]string{{"1", "2"}, {"2", "3", "1"}}, []int{2, 1}, true},
+		{"strings", 512, [][]string{{"a", "b", "a"}}, []int{2}, false},
+		{"mixed first batch", 512, [][]string{{"a", "1", "a", "1"}}, []int{2}, false},
+		{"intset to dict mid-batch", 512, [][]string{{"1", "2"}, {"3", "a", "1", "a"}}, []int{2, 2}, false},
+		{"integers after dict", 512, [][]string{{"a"}, {"1", "2", "1"}}, []int{1, 2}, false},
+		{"exactly max entries", 4, [][]string{{"1", "2", "3", "4"}}, []int{4}, true},
+		{"max entries with duplicates", 4, [][]string{{"1", "2"}, {"3", "4", "4", "1"}}, []int{2, 2}, true},
+		{"one past max in one batch", 4, [][]string{{"1", "2", "3", "4", "5"}}, []int{5}, false},
+		{"one past max in a later batch", 4, [][]string{{"1", "2", "3", "4"}, {"5"}}, []int{4, 1}, false},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			old := SetMaxIntsetEntries
+			SetMaxIntsetEntries = tt.maxIntset
+			defer func() { SetMaxIntsetEntries = old }()
+
+			s := &Set{}
+			var all []string
+			for i, batch := range tt.batches {
+				objs := make([]*Object, len(batch))
+				for j, member := range batch {
+					objs[j] = CreateString(member)
+				}
+				added, err := s.AddMany(objs)
+				if err != nil {
+					t.Fatalf("batch %d: AddMany: %v", i, err)
+				}
+				if added != tt.wantAdded[i] {
+					t.Fatalf("batch %d: added = %d, want %d", i, added, tt.wantAdded[i])
+				}
+				all = append(all, batch...)
+			}
+			checkSet(t, s, refSet(all))
+			if (s.enc == encIntset) != tt.wantIntset {
+				t.Fatalf("intset encoding = %t, want %t", s.enc == encIntset, tt.wantIntset)
+			}
+		})
+	}
+}
+
+// 逐个Add与批量添加在SetMaxIntsetEntries处的转换一致
+func TestSetAddPromotion(t *testing.T) {
+	old := SetMaxIntsetEntries
+	SetMaxIntsetEntries = 4
+	defer func() { SetMaxIntsetEntries = old }()
+
+	s := &Set{}
+	for i, member := range integerMembers(5) {
+		if _, err := s.Add(CreateString(member)); err != nil {
+			t.Fatalf("Add(%s): %v", member, err)
+		}
+		if wantIntset := i+1 <= SetMaxIntsetEntries; (s.enc == encIntset) != wantIntset {
+			t.Fatalf("after %d members: intset encoding = %t, want %t", i+1, s.enc == encIntset, wantIntset)
+		}
+	}
+	checkSet(t, s, refSet(integerMembers(5)))
+}
+
+// 参照实现：交集、并集、差集，nil表示不存在的key
+func refInter(sets []map[string]struct{}) map[string]struct{} {
+	result := map[string]struct{}{}
+	for member := range sets[0] {
+		inAll := true
+		for _, other := range sets[1:] {
+			_, ok := other[member]
+			inAll = inAll && ok
+		}
+		if inAll {
+			result[member] = struct{}{}
+		}
+	}
+	return result
+}
+
+func refUnion(sets []map[string]struct{}) map[string]struct{} {
+	result := map[string]struct{}{}
+	for _, s := range sets {
+		maps.Copy(result, s)
+	}
+	return result
+}
+
+func refDiff(sets []map[string]struct{}) map[string]struct{} {
+	result := maps.Clone(sets[0])
+	for _, other := range sets[1:] {
+		for member := range other {
+			delete(result, member)
+		}
+	}
+	return result
+}
+
+func TestSetOperations(t *testing.T) {
+	ops := []struct {
+		name string
+		op   func([]*Set) *Set
+		ref  func([]map[string]struct{}) map[string]struct{}
+	}{
+		{"inter", SetInter, refInter},
+		{"union", SetUnion, refUnion},
+		{"diff", SetDiff, refDiff},
+	}
+	large := integerMembers(400)
+	// 成员为nil的集合表示不存在的key
+	tests := []struct {
+		name      string
+		maxIntset int
+		sets      [][]string
+	}{
+		{"intset and intset", 512, [][]string{{"1", "2", "3", "4", "-70000"}, {"3", "4", "5", "-70000"}}},
+		{"intset galloping in large intset", 512, [][]string{{"7", "150", "1000", "-1"}, large}},
+		{"large intset and small intset", 512, [][]string{large, {"399", "400", "0"}}},
+		{"intset and dict", 512, [][]string{{"1", "2", "3"}, {"2", "3", "x"}}},
+		{"dict and intset", 512, [][]string{{"2", "x"}, {"1", "2", "3", "4"}}},
+		{"dict and dict", 512, [][]string{{"a", "b", "1"}, {"b", "1", "c"}}},
+		{"promoted dict and intset", 4, [][]string{integerMembers(6), {"1", "5", "9"}}},
+		{"result past max entries", 4, [][]string{{"1", "2", "3"}, {"3", "4", "5"}}},
+		{"missing key in the middle", 512, [][]string{{"1", "2", "3"}, nil, {"2", "a"}}},
+		{"missing first key", 512, [][]string{nil, {"1", "2"}}},
+		{"only missing keys", 512, [][]string{nil, nil}},
+		{"single intset", 512, [][]string{{"5", "6"}}},
+		{"single dict", 512, [][]string{{"5", "y"}}},
+		{"three mixed sets", 512, [][]string{{"1", "2", "3", "4"}, {"a", "2", "3", "4"}, {"3", "4", "9"}}},
+	}
+	for _, tt := range tests {
+		for _, op := range ops {
+			t.Run(tt.name+"/"+op.name, func(t *testing.T) {
+				old := SetMaxIntsetEntries
+				SetMaxIntsetEntries = tt.maxIntset
+				defer func() { SetMaxIntsetEntries = old }()
+
+				sets := make([]*Set, len(tt.sets))
+				refs := make([]map[string]struct{}, len(tt.sets))
+				for i, members := range tt.sets {
+					sets[i] = newTestSet(members)
+					refs[i] = refSet(members)
+				}
+
+				checkSet(t, op.op(sets), op.ref(refs))
+				// 结果是新的集合，参与运算的集合不变
+				for i, s := range sets {
+					if s != nil && !maps.Equal(setMembers(s), refs[i]) {
+						t.Fatalf("operand %d modified", i)
+					}
+				}
+			})
+		}
+	}
+}
+
+// 整数集合中查找、删除非整数成员
+func TestSetNonIntegerOnIntset(t *testing.T) {
+	s := newTestSet([]string{"0", "1"})
+	if s.enc != encIntset {
+		t.Fatalf("expected intset encoding")
+	}
+	if s.Find(CreateString("x")) {
+		t.Fatalf(`Find("x") = true on an intset`)
+	}
+	if ok, err := s.Remove(CreateString("x")); ok || err != nil {
+		t.Fatalf(`Remove("x") = %t, %v, want false, nil`, ok, err)
+	}
+	if !s.Find(CreateString("0")) {
+		t.Fatalf(`Find("0") = false`)
+	}
+	checkSet(t, s, refSet([]string{"0", "1"}))
+}
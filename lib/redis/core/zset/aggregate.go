@@ -0,0 +1,185 @@
+package zset
+
+import (
+	"cmp"
+	"math"
+	"slices"
+	"strings"
+)
+
+// ZUNIONSTORE/ZINTERSTORE的AGGREGATE选项
+const (
+	AggregateSum = iota
+	AggregateMin
+	AggregateMax
+)
+
+// 第i个集合的权重，weights为nil时为1
+func weightAt(weights []float64, i int) float64 {
+	if weights == nil {
+		return 1
+	}
+	return weights[i]
+}
+
+// 带权重的score，与redis一致，inf乘0得到的NaN按0处理
+func weightedScore(score, weight float64) float64 {
+	score *= weight
+	if math.IsNaN(score) {
+		return 0
+	}
+	return score
+}
+
+// 按AGGREGATE合并score，与redis一致，inf与-inf相加得到的NaN按0处理
+func aggregateScore(aggregate int, target, score float64) float64 {
+	switch aggregate {
+	case AggregateMin:
+		if score < target {
+			return score
+		}
+		return target
+	case AggregateMax:
+		if score > target {
+			return score
+		}
+		return target
+	default:
+		target += score
+		if math.IsNaN(target) {
+			return 0
+		}
+		return target
+	}
+}
+
+// 遍历所有元素，顺序不定
+func (zs *ZSet) forEach(fn func(member string, score float64)) {
+	if zs.enc == encListpack {
+		for off := 0; off < len(zs.lp.buf); {
+			score, member, next := zs.lp.entry(off)
+			fn(string(member), score)
+			off = next
+		}
+		return
+	}
+	for member, pos := range zs.v2i {
+		fn(member, zs.objs[pos].Score)
+	}
+}
+
+// 按(score, member)比较，score不会是NaN
+func compareNodes(a, b ZNode) int {
+	if a.Score < b.Score {
+		return -1
+	}
+	if a.Score > b.Score {
+		return 1
+	}
+	return strings.Compare(a.Value, b.Value)
+}
+
+// 按(score, member)排序
+func sortNodes(nodes []ZNode) {
+	slices.SortFunc(nodes, compareNodes)
+}
+
+// 由member互不相同的元素构建有序集合，先排序再按序一次性构建
+func newZSetFromNodes(nodes []ZNode) *ZSet {
+	sortNodes(nodes)
+	return newZSetFromSorted(nodes)
+}
+
+/*
+ZSetUnion 并集(ZUNIONSTORE)
+sets中的nil表示不存在的key，按空集处理；weights为nil时所有权重为1
+返回值：新建的有序集合
+*/
+func ZSetUnion(sets []*ZSet, weights []float64, aggregate int) *ZSet {
+	size := 0
+	for _, zs := range sets {
+		if zs != nil && zs.Len() > size {
+			size = zs.Len()
+		}
+	}
+
+	scores := make(map[string]float64, size)
+	for i, zs := range sets {
+		if zs == nil {
+			continue
+		}
+		weight := weightAt(weights, i)
+		zs.forEach(func(member string, score float64) {
+			score = weightedScore(score, weight)
+			if target, ok := scores[member]; ok {
+				score = aggregateScore(aggregate, target, score)
+			}
+			scores[member] = score
+		})
+	}
+
+	nodes := make([]ZNode, 0, len(scores))
+	for member, score := range scores {
+		nodes = append(nodes, ZNode{score, member})
+	}
+	return newZSetFromNodes(nodes)
+}
+
+/*
+ZSetInter 交集(ZINTERSTORE)
+从元素最少的集合出发，在其余集合的索引中逐个查找，不在某个集合中即可提前放弃
+sets、weights的含义同ZSetUnion
+*/
+func ZSetInter(sets []*ZSet, weights []float64, aggregate int) *ZSet {
+	if len(sets) == 0 {
+		return NewZSet()
+	}
+	order := make([]int, len(sets))
+	for i, zs := range sets {
+		if zs == nil {
+			return NewZSet()
+		}
+		order[i] = i
+	}
+	slices.SortFunc(order, func(a, b int) int {
+		return cmp.Compare(sets[a].Len(), sets[b].Len())
+	})
+
+	var nodes []ZNode
+	sets[order[0]].forEach(func(member string, score float64) {
+		score = weightedScore(score, weightAt(weights, order[0]))
+		for _, i := range order[1:] {
+			other, ok := sets[i].ZSetGetScore(member)
+			if !ok {
+				return
+			}
+			score = aggregateScore(aggregate, score, weightedScore(other, weightAt(weights, i)))
+		}
+		nodes = append(nodes, ZNode{score, member})
+	})
+	return newZSetFromNodes(nodes)
+}
+
+/*
+ZSetDiff 差集(ZDIFFSTORE)：第一个集合中不属于其余任何集合的元素，score不变
+sets中的nil表示不存在的key，按空集处理
+*/
+func ZSetDiff(sets []*ZSet) *ZSet {
+	if len(sets) == 0 || sets[0] == nil {
+		return NewZSet()
+	}
+
+	var nodes []ZNode
+	sets[0].forEach(func(member string, score float64) {
+		for _, other := range sets[1:] {
+			if other == nil {
+				continue
+			}
+			if _, ok := other.ZSetGetScore(member); ok {
+				return
+			}
+		}
+		nodes = append(nodes, ZNode{score, member})
+	})
+	return newZSetFromNodes(nodes)
+}
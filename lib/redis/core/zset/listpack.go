@@ -0,0 +1,170 @@
+package zset
+
+import (
+	"encoding/binary"
+	"math"
+)
+
+// listpack 小有序集合的紧凑编码(参考redis的listpack)
+// 所有元素按(score, member)有序，首尾相接地存放在一块连续内存中，每个元素为:
+//
+//	score(8字节) | member长度(uvarint) | member字节
+//
+// 查找、插入、删除都是O(n)，但元素少时整块数据都在缓存中，
+// 且没有跳表头结点、哈希表与cgo调用的固定开销
+type listpack struct {
+	buf []byte
+	n   int // 元素个数
+}
+
+// 解码偏移off处的元素，返回score、member以及下一个元素的偏移
+// member直接引用buf，修改listpack后失效
+func (lp *listpack) entry(off int) (score float64, member []byte, next int) {
+	score = math.Float64frombits(binary.LittleEndian.Uint64(lp.buf[off:]))
+	l, k := binary.Uvarint(lp.buf[off+8:])
+	start := off + 8 + k
+	next = start + int(l)
+	return score, lp.buf[start:next], next
+}
+
+// 查找member，返回其所在偏移与score，不存在时ok为false
+func (lp *listpack) find(member string) (off int, score float64, ok bool) {
+	for off < len(lp.buf) {
+		s, m, next := lp.entry(off)
+		if string(m) == member {
+			return off, s, true
+		}
+		off = next
+	}
+	return 0, 0, false
+}
+
+// 按(score, member)的顺序插入，由调用方保证member不存在
+func (lp *listpack) insert(score float64, member string) {
+	off := 0
+	for off < len(lp.buf) {
+		s, m, next := lp.entry(off)
+		if s > score || (s == score && string(m) > member) {
+			break
+		}
+		off = next
+	}
+
+	var head [listpackMaxHead]byte
+	k := encodeHead(head[:], score, member)
+	size := k + len(member)
+
+	// 在off处腾出size字节
+	lp.buf = append(lp.buf, make([]byte, size)...)
+	copy(lp.buf[off+size:], lp.buf[off:])
+	copy(lp.buf[off:], head[:k])
+	copy(lp.buf[off+k:], member)
+	lp.n++
+}
+
+// 在末尾追加元素，由调用方保证(score, member)不小于最后一个元素
+func (lp *listpack) append(score float64, member string) {
+	var head [listpackMaxHead]byte
+	k := encodeHead(head[:], score, member)
+	lp.buf = append(lp.buf, head[:k]...)
+	lp.buf = append(lp.buf, member...)
+	lp.n++
+}
+
+// 元素头部(score与member长度)的最大字节数
+const listpackMaxHead = 8 + binary.MaxVarintLen64
+
+// 将元素头部写入head，返回写入的字节数
+func encodeHead(head []byte, score float64, member string) int {
+	binary.LittleEndian.PutUint64(head, math.Float64bits(score))
+	return 8 + binary.PutUvarint(head[8:], uint64(len(member)))
+}
+
+// 删除字节区间[from, to)内的n个元素
+func (lp *listpack) deleteRange(from, to, n int) {
+	lp.buf = append(lp.buf[:from], lp.buf[to:]...)
+	lp.n -= n
+}
+
+// 从偏移off开始跳过至多n个元素，返回新的偏移
+func (lp *listpack) skip(off, n int) int {
+	for ; n > 0 && off < len(lp.buf); n-- {
+		_, _, off = lp.entry(off)
+	}
+	return off
+}
+
+/*
+区间[start, end)：从第一个满足gteMin的元素开始，跳过offset个元素后，
+取满足lteMax的连续元素，至多count个(count为负数表示不限)
+返回值：区间的起止偏移与元素个数，offset为负数时为空
+*/
+func (lp *listpack) span(gteMin, lteMax func(score float64, member []byte) bool,
+	offset, count int) (start, end, n int) {
+	if offset < 0 {
+		return 0, 0, 0
+	}
+	for start < len(lp.buf) {
+		s, m, next := lp.entry(start)
+		if gteMin(s, m) {
+			break
+		}
+		start = next
+	}
+	start = lp.skip(start, offset)
+
+	end = start
+	for end < len(lp.buf) && n != count {
+		s, m, next := lp.entry(end)
+		if !lteMax(s, m) {
+			break
+		}
+		end = next
+		n++
+	}
+	return start, end, n
+}
+
+// score区间对应的span
+func (lp *listpack) scoreSpan(r ScoreRange, offset, count int) (start, end, n int) {
+	return lp.span(
+		func(score float64, _ []byte) bool { return r.gteMin(score) },
+		func(score float64, _ []byte) bool { return r.lteMax(score) },
+		offset, count)
+}
+
+// 字典序区间对应的span
+func (lp *listpack) lexSpan(min, max LexBound, offset, count int) (start, end, n int) {
+	return lp.span(
+		func(_ float64, member []byte) bool { return min.lteMember(member) },
+		func(_ float64, member []byte) bool { return max.gteMember(member) },
+		offset, count)
+}
+
+// 排名区间[lrank, rrank]对应的span，排名含义同SkipList::searchRankRange
+func (lp *listpack) rankSpan(lrank, rrank int) (start, end, n int) {
+	lrank, rrank, ok := normalizeRankRange(lrank, rrank, lp.n)
+	if !ok {
+		return 0, 0, 0
+	}
+	start = lp.skip(0, lrank-1)
+	end = lp.skip(start, rrank-lrank+1)
+	return start, end, rrank - lrank + 1
+}
+
+// 将负数排名转换为正数并截断到[1, length]，与SkipList::normalizeRankRange一致
+func normalizeRankRange(lrank, rrank, length int) (int, int, bool) {
+	if lrank < 0 {
+		lrank = length + lrank + 1
+	}
+	if rrank < 0 {
+		rrank = length + rrank + 1
+	}
+	if lrank < 1 {
+		lrank = 1
+	}
+	if rrank > length {
+		rrank = length
+	}
+	return lrank, rrank, lrank <= rrank
+}
@@ -1,42 +1,39 @@
 #include "skip_list.h"
 
-inline void SkipListNode::AddSibling(ZSetType value) {
-    SkipListSiblingNode* last = this->nextSibling;
-    // 若目前暂无Sibling，则直接插入并更新首节点的nextSibling指针
-    if (!last) {
-        this->nextSibling = new SkipListSiblingNode(value);
-        return;
-    }
-    // 如果有Sibling，则按照链表push_back操作
-    while (last->nextSibling) {
-        last = last->nextSibling;
-    }
-    last->nextSibling = new SkipListSiblingNode(value);
-    return;
+SkipListNode* SkipListNode::create(double scr, ZSetType val, string_view member,
+                                   ZSetSizeType height) {
+    // 节点头、height个层与member一次分配
+    SkipListNode* node = static_cast<SkipListNode*>(
+        malloc(offsetof(SkipListNode, level) + height * sizeof(SkipListLevel) +
+               member.size()));
+    if (!node) {
+        throw bad_alloc();
+    }
+    node->score = scr;
+    node->backward = nullptr;
+    node->value = val;
+    node->height = height;
+    node->len = member.size();
+    for (ZSetSizeType i = 0; i < height; i++) {
+        node->level[i].forward = nullptr;
+        node->level[i].span = 0;
+    }
+    if (!member.empty()) {
+        memcpy(node->level + height, member.data(), member.size());
+    }
+    return node;
 }
 
 void SkipListNode::print() const {
-    cout << "[SLNode] s=" << score << ", v=" << value << endl;
-
-    // 打印重复score的节点
-    if (nextSibling) {
-        SkipListSiblingNode* s = nextSibling;
-        cout << "[";
-        while (s) {
-            cout << ", v=" << s->value;
-            s = s->nextSibling;
-        }
-        cout << "]" << endl;
-    }
+    cout << "[SLNode] s=" << score << ", m=" << getMember() << ", v=" << value
+         << endl;
 
-    // for (int i = 1; i < SKIP_LIST_MAX_LEVEL; i++) {
-    for (int i = 0; i < forward.size(); i++) {
-        // 如果越界了，检查可能不为空，但根本不是forward节点
-        if (!forward[i]) {
+    for (ZSetSizeType i = 0; i < height; i++) {
+        if (!level[i].forward) {
             break;
         }
-        cout << "forward[" << i << "]: " << forward[i]->value << " "
-             << forward[i]->score << " sp=" << span[i] << ", ";
+        cout << "forward[" << i << "]: " << level[i].forward->value << " "
+             << level[i].forward->score << " sp=" << level[i].span << ", ";
     }
     if (backward) {
         cout << "backward: " << backward->score;
@@ -44,114 +41,119 @@ void SkipListNode::print() const {
     cout << endl;
 }
 
-// 随机生成节点层数
-// 50%概率加层
-// 少量高层节点快速跳过大部分低层节点
-ZSetSizeType SkipList::randomLevel() const {
-    int lvl = 1;
-    while ((rand() & 1) && lvl < SKIP_LIST_MAX_LEVEL) {
-        lvl++;
+bool SkipListLexRange::empty() const {
+    if (min.inf > 0 || max.inf < 0) {
+        return true;
     }
-    return lvl;
+    if (min.inf < 0 || max.inf > 0) {
+        return false;
+    }
+    int cmp = min.member.compare(max.member);
+    return cmp > 0 || (cmp == 0 && (min.ex || max.ex));
 }
 
-void SkipList::insert(double score, ZSetType value) {
-    // cout << "Inserting [" << score << "] " << value << endl;
+bool SkipListLexRange::gteMin(string_view member) const {
+    if (min.inf != 0) {
+        return min.inf < 0;
+    }
+    return min.ex ? member > min.member : member >= min.member;
+}
+
+bool SkipListLexRange::lteMax(string_view member) const {
+    if (max.inf != 0) {
+        return max.inf > 0;
+    }
+    return max.ex ? member < max.member : member <= max.member;
+}
 
-    // newNodeLevel<level时：0~nL为新节点需更新的直接前驱；nL~l为“从新节点头顶跨过”的需要更新span的
-    // newNodeLevel>=level时：0~l为新节点需更新的直接前驱，l~nL无需存储直接对header更新
-    vector<SkipListNode*> update(level, nullptr);
+// splitmix64，把任意种子(包括相近的种子)打散为xorshift的初始状态
+static uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+SkipListRandom::SkipListRandom(uint64_t seed) {
+    if (seed == 0) {
+        seed = static_cast<uint64_t>(
+                   chrono::steady_clock::now().time_since_epoch().count()) ^
+               reinterpret_cast<uintptr_t>(this);
+    }
+    state = splitmix64(seed);
+    if (state == 0) {
+        state = 1;
+    }
+}
+
+// 随机生成节点层数
+// 一个随机数的低位每pBits位为一组，每组全为0的概率为p，
+// 从最低位起连续k组全为0则加k层，由count-trailing-zeros一次得到，无需循环
+// 少量高层节点快速跳过大部分低层节点
+ZSetSizeType SkipList::randomLevel() {
+    uint64_t r = rng.next();
+    ZSetSizeType lvl = 1 + (r ? __builtin_ctzll(r) : 64) / pBits;
+    return lvl < maxLevel ? lvl : maxLevel;
+}
+
+void SkipList::insert(double score, ZSetType value, string_view member) {
+    // update[i]为第i层上新节点的直接前驱
+    // 最多SKIP_LIST_MAX_LEVEL层，直接放在栈上
+    SkipListNode* update[SKIP_LIST_MAX_LEVEL];
     // 存储update[i]到header的距离
-    vector<ZSetSizeType> updateRank(level, 0);
+    ZSetSizeType updateRank[SKIP_LIST_MAX_LEVEL];
 
     SkipListNode* cur = header;
-    // cur到header的距离
-    ZSetSizeType dist = 0;
 
     // 从最高层开始，查找插入位置
     // 渐进式的查找，下一层查找起点在上一层终点
     for (int i = level - 1; i >= 0; i--) {
-        while (cur->forward[i] && cur->forward[i]->score < score) {
-            dist += cur->span[i];
-            cur = cur->forward[i];
+        updateRank[i] = i == level - 1 ? 0 : updateRank[i + 1];
+        while (cur->level[i].forward &&
+               cur->level[i].forward->lessThan(score, member)) {
+            updateRank[i] += cur->level[i].span;
+            cur = cur->level[i].forward;
         }
-        // 如果level比newNodeLevel高，那么高出来的部分也要记录(需要更新跨度)
         update[i] = cur;
-        updateRank[i] = dist;
     }
-    // 经过上面的循环后，cur抵达小于score的最后一个Node(其第一层后继节点大于等于score)
+    // 经过上面的循环后，cur抵达排在(score, member)之前的最后一个Node
 
-    // 如果有重复score
-    if (cur->forward[0] && cur->forward[0]->score == score) {
-        // 如果判定有相等的，则先抵达score对应的Node
-        cur = cur->forward[0];
-        // 插入兄弟节点
-        cur->AddSibling(value);
-
-        // 更新跨度
-
-        int curLevel = cur->forward.size();
-        // 每一个level的span++
-        for (int i = 0; i < curLevel; i++) {
-            cur->span[i]++;
-        }
-
-        // 如果当前节点层数小于目前最大层数，则“从cur顶上跨过的forward”的跨度需要++
-        for (int i = curLevel; i < level; i++) {
-            if (update[i]->forward[i]) { // 如果forward不指向null
-                update[i]->span[i]++;
-            }
-        }
-        return;
-    } // 直接return，无需更新其他forward
-
-    // 如果无重复score
-    // 此时cur位置：newnode应该在的位置的直接前驱节点
     // 新节点层数
-    const ZSetType newNodeLevel = randomLevel();
-    // cout << "level = " << newNodeLevel << endl;
-    SkipListNode* newNode = new SkipListNode(score, value, newNodeLevel);
-
+    const ZSetSizeType newNodeLevel = randomLevel();
     if (newNodeLevel > level) {
-        // 如果新节点层数大于目前最大层数:
-        // level以下的部分正常更新，多出来的部分指向header
-        for (int i = 0; i < level; i++) {
-            newNode->forward[i] = update[i]->forward[i];
-            newNode->span[i] = dist - updateRank[i] + 1;
-
-            update[i]->forward[i] = newNode;
-        }
-
+        // 如果新节点层数大于目前最大层数，多出来的部分前驱为header
+        // header在这些层上此前没有后继，span记为整个跳表的长度
         for (int i = level; i < newNodeLevel; i++) {
-            // newNode->forward[i] = nullptr, newNode->span[i] = 0; // 本来就是
-            header->forward[i] = newNode;
-            header->span[i] = dist + 1;
+            updateRank[i] = 0;
+            update[i] = header;
+            header->level[i].span = length;
         }
         level = newNodeLevel;
-    } else {
-        // 如果新节点层数小于目前最大层数:
-        // newNodeLevel以下的部分正常更新，nL~l的部分需要更新跨度
-        for (int i = 0; i < newNodeLevel; i++) {
-            newNode->forward[i] = update[i]->forward[i];
-            newNode->span[i] = dist - updateRank[i] + 1;
+    }
 
-            update[i]->forward[i] = newNode;
-        }
+    SkipListNode* newNode =
+        SkipListNode::create(score, value, member, newNodeLevel);
+    for (int i = 0; i < newNodeLevel; i++) {
+        newNode->level[i].forward = update[i]->level[i].forward;
+        update[i]->level[i].forward = newNode;
 
-        // 如果新节点层数小于目前最大层数，则“从newNode顶上跨过的forward”的跨度需要++
-        for (int i = newNodeLevel; i < level; i++) {
-            if (update[i]->forward[i]) { // 如果forward不指向null
-                update[i]->span[i]++;
-            }
-        }
+        // updateRank[0] - updateRank[i]为update[i]与新节点直接前驱之间的距离
+        newNode->level[i].span =
+            update[i]->level[i].span - (updateRank[0] - updateRank[i]);
+        update[i]->level[i].span = updateRank[0] - updateRank[i] + 1;
+    }
+
+    // “从newNode顶上跨过的forward”的跨度需要++
+    for (int i = newNodeLevel; i < level; i++) {
+        update[i]->level[i].span++;
     }
 
-    // 设置后向指针：由于修改了update存储的长度，所以不能还是单纯存update[0]了
-    newNode->backward = update.size() > 0 ? update[0] : header;
+    // 设置后向指针
+    newNode->backward = update[0] == header ? nullptr : update[0];
 
     // 设置后继节点的后向指针
-    if (newNode->forward[0]) {
-        newNode->forward[0]->backward = newNode;
+    if (newNode->level[0].forward) {
+        newNode->level[0].forward->backward = newNode;
     } else {
         // 如果后继为null，则设置尾节点
         tail = newNode;
@@ -160,376 +162,510 @@ void SkipList::insert(double score, ZSetType value) {
     length++;
 }
 
-SkipListNode* SkipList::searchNode(double score) {
-    SkipListNode* cur = header;
-
-    for (int i = level - 1; i >= 0; i--) {
-        while (cur->forward[i] && cur->forward[i]->score < score) {
-            cur = cur->forward[i];
+SkipListBuilder::SkipListBuilder(SkipList& list) : list(list) {
+    // 沿各层走到最后一个节点
+    SkipListNode* cur = list.header;
+    ZSetSizeType rank = 0;
+    for (int i = list.level - 1; i >= 0; i--) {
+        while (cur->level[i].forward) {
+            rank += cur->level[i].span;
+            cur = cur->level[i].forward;
         }
+        last[i] = cur;
+        lastRank[i] = rank;
     }
-    cur = cur->forward[0];
-
-    // Score not found
-    if (!cur || cur->score != score) {
-        return nullptr;
+    for (ZSetSizeType i = list.level; i < list.maxLevel; i++) {
+        last[i] = list.header;
+        lastRank[i] = 0;
     }
-    // Score found
-    return cur;
 }
 
-// 无需额外检查l>r的情况(正常返回空vector)
-vector<SkipListNode*> SkipList::searchRangeNode(double lscore, double rscore) {
-    vector<SkipListNode*> result;
-    SkipListNode* cur = header;
-    for (int i = level - 1; i >= 0; i--) {
-        while (cur->forward[i] && cur->forward[i]->score < lscore) {
-            cur = cur->forward[i];
-        }
+void SkipListBuilder::append(double score, ZSetType value, string_view member) {
+    const ZSetSizeType lvl = list.randomLevel();
+    if (lvl > list.level) {
+        list.level = lvl;
     }
-    // cur抵达小于lscore的最后一个节点
 
-    // 从>=lscore的第一个节点开始，按顺序找直系后继
-    while (cur->forward[0] && cur->forward[0]->score < rscore) {
-        cur = cur->forward[0];
-        result.push_back(cur);
+    SkipListNode* node = SkipListNode::create(score, value, member, lvl);
+    const ZSetSizeType rank = list.length + 1;
+    for (ZSetSizeType i = 0; i < lvl; i++) {
+        last[i]->level[i].forward = node;
+        last[i]->level[i].span = rank - lastRank[i];
+        last[i] = node;
+        lastRank[i] = rank;
     }
+    // 空表时tail为nullptr，第一个节点的后向指针正好为空
+    node->backward = list.tail;
+    list.tail = node;
+    list.length++;
+}
 
-    return result;
+void SkipListBuilder::finish() {
+    // forward为空时span为到表尾的节点数
+    for (ZSetSizeType i = 0; i < list.level; i++) {
+        last[i]->level[i].span = list.length - lastRank[i];
+    }
 }
 
-SkipListNode* SkipList::removeNode(double score) {
-    vector<SkipListNode*> update(level, nullptr);
+SkipListNode* SkipList::searchNode(double score) {
     SkipListNode* cur = header;
-    // 该score的所有节点的数量
-    int num = 1;
 
-    // 寻找所有层的前驱节点，应该从1开始，而不是0
-    for (int i = level; i >= 0; i--) {
-        while (cur->forward[i] && cur->forward[i]->score < score) {
-            cur = cur->forward[i];
+    for (int i = level - 1; i >= 0; i--) {
+        while (cur->level[i].forward && cur->level[i].forward->score < score) {
+            cur = cur->level[i].forward;
         }
-        update[i] = cur;
     }
+    cur = cur->level[0].forward;
 
-    // 寻找同score的链表的起始节点
-    cur = cur->forward[0];
-
-    // 检查是否有这个score
+    // Score not found
     if (!cur || cur->score != score) {
         return nullptr;
     }
+    // Score found
+    return cur;
+}
 
-    // 循环删除所有兄弟节点
-    SkipListSiblingNode* last = cur->nextSibling;
-    while (last) {
-        num++;
-        SkipListSiblingNode* nxt = last->nextSibling;
-        delete last;
-        last = nxt;
-    }
-
-    // 前驱节点的更新
-    int curLevel = cur->forward.size();
-    for (int i = 0; i < curLevel; i++) {
-        update[i]->forward[i] = cur->forward[i];
-        // 前驱节点的span更新
-        update[i]->span[i] = update[i]->span[i] + cur->span[i] - num;
-    }
-
-    // “从cur顶上跨过的forward”的span更新
-    for (int i = curLevel; i < level; i++) {
-        update[i]->span[i] -= num;
+void SkipList::unlinkNode(SkipListNode* cur, SkipListNode** update) {
+    for (int i = 0; i < level; i++) {
+        if (update[i]->level[i].forward == cur) {
+            // 前驱节点的更新
+            update[i]->level[i].span += cur->level[i].span - 1;
+            update[i]->level[i].forward = cur->level[i].forward;
+        } else {
+            // “从cur顶上跨过的forward”的span更新
+            update[i]->level[i].span--;
+        }
     }
 
-    delete cur;
-
     // 更新backward和tail指针
     // 如果删除的不是最后一个节点，则更新其的backward指针
-    if (update[0]->forward[0]) {
-        update[0]->forward[0]->backward = update[1];
+    if (cur->level[0].forward) {
+        cur->level[0].forward->backward = cur->backward;
     } else { // 如果对第一层而言，删除节点为最后一个节点，则更新tail
-        tail = update[0];
+        tail = cur->backward;
     }
 
     // 更新跳表层数
-    while (level > 1 && header->forward[level] == nullptr) {
+    while (level > 0 && header->level[level - 1].forward == nullptr) {
         level--;
     }
 
     length--;
-
-    return cur;
 }
 
-pair<int, SkipListNode*> SkipList::searchRankNode(int rank) {
+SkipListNode* SkipList::searchRankNode(ZSetSizeType rank) {
     SkipListNode* cur = header;
-    int curRank = 0;
+    ZSetSizeType traversed = 0;
     for (int i = level - 1; i >= 0; i--) {
-        while (cur->forward[i] && curRank + cur->span[i] < rank) {
-            // cout << "level:" << i << endl;
-            // cout << "curRank=" << curRank << "+" << cur->span[i] << endl;
-            curRank += cur->span[i];
-            cur = cur->forward[i];
+        while (cur->level[i].forward &&
+               traversed + cur->level[i].span <= rank) {
+            traversed += cur->level[i].span;
+            cur = cur->level[i].forward;
+        }
+        if (traversed == rank) {
+            return cur == header ? nullptr : cur;
         }
     }
-    // 此时得到的是curRank小于rank的最后一个节点
-    // 再进一个等于或大于(大于的情况是cur的重复score节点并列排名包括了要查找的rank)
-    // 等于则返回下一个，大于则返回当前
-    if (curRank + cur->span[0] == rank) {
-        cur = cur->forward[0];
-        curRank = rank;
-    }
-
-    return {curRank, cur};
+    return nullptr;
 }
 
 vector<ZSetType> SkipList::search(double score) {
     vector<ZSetType> result;
-    SkipListNode* cur = searchNode(score);
-    if (!cur) { // not found
-        return result;
-    }
-
-    // 遍历
-    result.push_back(cur->value);
-    SkipListSiblingNode* last = cur->nextSibling;
-    while (last) {
-        result.push_back(last->value);
-        last = last->nextSibling;
+    // 同score的节点连续排列
+    for (SkipListNode* cur = searchNode(score); cur && cur->score == score;
+         cur = cur->level[0].forward) {
+        result.push_back(cur->value);
     }
     return result;
 }
 
 vector<pair<double, ZSetType>> SkipList::searchRange(double lscore,
-                                                     double rscore) {
-    vector<pair<double, ZSetType>> result;
+                                                     double rscore,
+                                                     bool reverse) {
+    return drain(rangeByScore({lscore, rscore, false, false}, 0, -1, reverse));
+}
 
-    if (lscore > length || rscore <= 0 || lscore > rscore) {
-        return result;
-    }
+vector<ZSetType> SkipList::remove(double score) {
+    return removeRange({score, score, false, false});
+}
 
-    vector<SkipListNode*> r = searchRangeNode(lscore, rscore);
-    if (r.empty()) { // not found
+vector<ZSetType> SkipList::removeRange(const SkipListRange& range) {
+    vector<ZSetType> result;
+    if (range.empty()) {
         return result;
     }
 
-    // 对每一个节点遍历
-    for (SkipListNode* cur : r) {
-        result.push_back({cur->score, cur->value});
-        SkipListSiblingNode* last = cur->nextSibling;
-        while (last) {
-            result.push_back({cur->score, last->value});
-            last = last->nextSibling;
+    SkipListNode* update[SKIP_LIST_MAX_LEVEL];
+    SkipListNode* cur = header;
+
+    // 寻找所有层上区间之前的最后一个节点
+    for (int i = level - 1; i >= 0; i--) {
+        while (cur->level[i].forward &&
+               !range.gteMin(cur->level[i].forward->score)) {
+            cur = cur->level[i].forward;
         }
+        update[i] = cur;
+    }
+
+    // 区间内的节点连续排列，update对它们都适用，依次摘除即可
+    cur = cur->level[0].forward;
+    while (cur && range.lteMax(cur->score)) {
+        SkipListNode* next = cur->level[0].forward;
+        unlinkNode(cur, update);
+        result.push_back(cur->value);
+        SkipListNode::destroy(cur);
+        cur = next;
     }
     return result;
 }
 
-vector<ZSetType> SkipList::remove(double score) {
+vector<ZSetType> SkipList::removeRankRange(int lrank, int rrank) {
     vector<ZSetType> result;
-    SkipListNode* cur = removeNode(score);
-    if (!cur) { // not found
+    if (!normalizeRankRange(lrank, rrank)) {
         return result;
     }
+    result.reserve(rrank - lrank + 1);
 
-    // 遍历
-    result.push_back(cur->value);
-    SkipListSiblingNode* last = cur->nextSibling;
-    while (last) {
-        result.push_back(last->value);
-        last = last->nextSibling;
+    SkipListNode* update[SKIP_LIST_MAX_LEVEL];
+    SkipListNode* cur = header;
+    ZSetSizeType traversed = 0;
+
+    // 寻找所有层上排名lrank之前的最后一个节点
+    for (int i = level - 1; i >= 0; i--) {
+        while (cur->level[i].forward &&
+               traversed + cur->level[i].span < (ZSetSizeType)lrank) {
+            traversed += cur->level[i].span;
+            cur = cur->level[i].forward;
+        }
+        update[i] = cur;
+    }
+
+    cur = cur->level[0].forward;
+    for (int rank = lrank; cur && rank <= rrank; rank++) {
+        SkipListNode* next = cur->level[0].forward;
+        unlinkNode(cur, update);
+        result.push_back(cur->value);
+        SkipListNode::destroy(cur);
+        cur = next;
     }
     return result;
 }
 
-bool SkipList::remove(double score, ZSetType value) {
-    vector<SkipListNode*> update(level, nullptr);
+bool SkipList::remove(double score, string_view member) {
+    SkipListNode* update[SKIP_LIST_MAX_LEVEL];
     SkipListNode* cur = header;
 
-    // 寻找所有层的前驱节点，应该从1开始，而不是0
-    for (int i = level; i >= 0; i--) {
-        while (cur->forward[i] && cur->forward[i]->score < score) {
-            cur = cur->forward[i];
+    // 寻找所有层的前驱节点
+    for (int i = level - 1; i >= 0; i--) {
+        while (cur->level[i].forward &&
+               cur->level[i].forward->lessThan(score, member)) {
+            cur = cur->level[i].forward;
         }
         update[i] = cur;
     }
 
-    // 寻找同score的链表的起始节点
-    cur = cur->forward[0];
-
-    // 检查是否有这个score
-    if (!cur || cur->score != score) {
+    // 理论不会出现找不到的情况，因为查询的存在性由哈希表验证
+    cur = cur->level[0].forward;
+    if (!cur || cur->score != score || cur->getMember() != member) {
         return false;
     }
 
-    // 如果首节点就是对应value，则需要判断其是否有兄弟节点
-    //      如果有兄弟节点，则仅需将firstSibling晋升为Node(对cur节点的value、nextSibling进行赋值并删除firstSibling)
-    //      如果无，则直接删除并连接
-    // 如果首节点非对应value，则遍历Sibling后进行简单的链表删除(理论上在上层判断，此处不会有找不到的情况，不过还是处理了)
+    unlinkNode(cur, update);
+    SkipListNode::destroy(cur);
+    return true;
+}
 
-    // 如果首节点就是对应value
-    int curLevel = cur->forward.size();
-    if (cur->value == value) {
-        SkipListSiblingNode* firstSibling = cur->nextSibling;
-        if (firstSibling) { // 有兄弟节点
-            SkipListNode* result = cur;
-            cur->value = value;
-            cur->nextSibling = firstSibling->nextSibling;
+pair<double, ZSetType> SkipList::searchRank(int rank) {
+    if (rank < 0) { // 倒数转为正数
+        rank = length + rank + 1;
+    }
+    if (rank <= 0 || rank > length) { // 不合法rank
+        return {SkipListNotFound, 0};
+    }
 
-            // 所有的span--
-            for (int i = 0; i < curLevel; i++) {
-                cur->span[i]--;
-            }
+    SkipListNode* cur = searchRankNode(rank);
+    return {cur->score, cur->value};
+}
 
-            delete firstSibling;
-        } else {
-            // 无兄弟节点，则与只传入score的重载的操作一致
+vector<pair<double, ZSetType>> SkipList::searchRankRange(int lrank, int rrank) {
+    return drain(rangeByRank(lrank, rrank));
+}
 
-            for (int i = 0; i < curLevel; i++) {
-                update[i]->forward[i] = cur->forward[i];
-                // 前驱节点的span更新
-                update[i]->span[i] = update[i]->span[i] + cur->span[i] - 1;
-            }
+SkipListNode* SkipList::firstInRange(const SkipListRange& range,
+                                     ZSetSizeType& rank) {
+    if (range.empty()) {
+        return nullptr;
+    }
 
-            // “从cur顶上跨过的forward”的span更新
-            for (int i = curLevel; i < level; i++) {
-                update[i]->span[i]--;
-            }
-
-            delete cur;
-
-            // 同上，更新tail和bk
-            if (update[0]->forward[0]) {
-                update[0]->forward[0]->backward = update[1];
-            } else {
-                tail = update[0];
-            }
-
-            while (level > 0 && header->forward[level] == nullptr) {
-                level--;
-            }
+    SkipListNode* cur = header;
+    ZSetSizeType traversed = 0;
+    for (int i = level - 1; i >= 0; i--) {
+        while (cur->level[i].forward &&
+               !range.gteMin(cur->level[i].forward->score)) {
+            traversed += cur->level[i].span;
+            cur = cur->level[i].forward;
         }
-        length--;
-        return true;
     }
-    // 首节点非对应value
+    // cur抵达小于min的最后一个节点，其后继若不大于max即为所求
+    cur = cur->level[0].forward;
+    if (!cur || !range.lteMax(cur->score)) {
+        return nullptr;
+    }
+    rank = traversed + 1;
+    return cur;
+}
 
-    // 遍历所有兄弟节点
-    SkipListSiblingNode* sibling = cur->nextSibling;
+SkipListNode* SkipList::lastInRange(const SkipListRange& range,
+                                    ZSetSizeType& rank) {
+    if (range.empty()) {
+        return nullptr;
+    }
 
-    // 如果第一个兄弟节点就是对应value
-    if (sibling->value == value) {
-        cur->nextSibling = sibling->nextSibling;
-        delete sibling;
-        length--;
-        return true;
-    } else {
-        // 如果不是，则遍历
-        SkipListSiblingNode* next = sibling->nextSibling;
-        while (next) {
-            if (next->value == value) {
-                sibling->nextSibling = next->nextSibling;
-                delete next;
-                length--;
-                return true;
-            }
+    SkipListNode* cur = header;
+    ZSetSizeType traversed = 0;
+    for (int i = level - 1; i >= 0; i--) {
+        while (cur->level[i].forward &&
+               range.lteMax(cur->level[i].forward->score)) {
+            traversed += cur->level[i].span;
+            cur = cur->level[i].forward;
         }
     }
-
-    // 理论不会出现return false的情况，因为查询的存在性由哈希表验证
-    return false;
+    // cur抵达不大于max的最后一个节点，其若不小于min即为所求
+    if (cur == header || !range.gteMin(cur->score)) {
+        return nullptr;
+    }
+    rank = traversed;
+    return cur;
 }
 
-pair<double, ZSetType> SkipList::searchRank(int rank) {
-    if (rank < 0) { // 倒数转为正数
-        rank = length + rank;
-    }
-    if (rank <= 0 || rank > length) { // 不合法rank
-        return {SkipListNotFound, 0};
+ZSetSizeType SkipList::count(const SkipListRange& range) {
+    if (range.empty()) {
+        return 0;
     }
 
-    auto res = searchRankNode(rank);
-    int startRank = res.first;
-    SkipListNode* cur = res.second;
-    // cout << "startRank=" << startRank << " cur->value=" << cur->value <<
-    // endl;
+    // 分别累加小于min、不大于max的节点数，两者之差即为区间内的节点数
+    ZSetSizeType before = 0, upto = 0;
+    SkipListNode* cur = header;
+    for (int i = level - 1; i >= 0; i--) {
+        while (cur->level[i].forward &&
+               !range.gteMin(cur->level[i].forward->score)) {
+            before += cur->level[i].span;
+            cur = cur->level[i].forward;
+        }
+    }
+    cur = header;
+    for (int i = level - 1; i >= 0; i--) {
+        while (cur->level[i].forward &&
+               range.lteMax(cur->level[i].forward->score)) {
+            upto += cur->level[i].span;
+            cur = cur->level[i].forward;
+        }
+    }
+    return upto > before ? upto - before : 0;
+}
 
-    // 头结点就是对应的rank
-    if (startRank == rank) {
-        // cout << "searchRank1" << endl;
-        return {cur->score, cur->value};
+SkipListNode* SkipList::firstInLexRange(const SkipListLexRange& range,
+                                        ZSetSizeType& rank) {
+    if (range.empty()) {
+        return nullptr;
     }
 
-    SkipListSiblingNode* sibling = cur->nextSibling;
-    for (int i = 0; i < rank - startRank - 1; i++) {
-        // 理论上这里循环次数不会出错
-        // cout << "searchRank2" << endl;
-        sibling = sibling->nextSibling;
+    SkipListNode* cur = header;
+    ZSetSizeType traversed = 0;
+    for (int i = level - 1; i >= 0; i--) {
+        while (cur->level[i].forward &&
+               !range.gteMin(cur->level[i].forward->getMember())) {
+            traversed += cur->level[i].span;
+            cur = cur->level[i].forward;
+        }
+    }
+    // cur抵达小于min的最后一个节点，其后继若不大于max即为所求
+    cur = cur->level[0].forward;
+    if (!cur || !range.lteMax(cur->getMember())) {
+        return nullptr;
     }
+    rank = traversed + 1;
+    return cur;
+}
 
-    return {cur->score, sibling->value};
+vector<pair<double, ZSetType>>
+SkipList::searchLexRange(const SkipListLexRange& range) {
+    return drain(rangeByLex(range, 0, -1));
 }
 
-vector<pair<double, ZSetType>> SkipList::searchRankRange(int lrank, int rrank) {
-    vector<pair<double, ZSetType>> result;
-    if (lrank < 0) { // 倒数转为正数
-        lrank = length + lrank;
+ZSetSizeType SkipList::lexCount(const SkipListLexRange& range) {
+    if (range.empty()) {
+        return 0;
     }
-    if (rrank < 0) {
-        rrank = length + rrank;
+
+    // 分别累加小于min、不大于max的节点数，两者之差即为区间内的节点数
+    ZSetSizeType before = 0, upto = 0;
+    SkipListNode* cur = header;
+    for (int i = level - 1; i >= 0; i--) {
+        while (cur->level[i].forward &&
+               !range.gteMin(cur->level[i].forward->getMember())) {
+            before += cur->level[i].span;
+            cur = cur->level[i].forward;
+        }
     }
-    if (lrank > length || rrank <= 0) { // 不合法rank
+    cur = header;
+    for (int i = level - 1; i >= 0; i--) {
+        while (cur->level[i].forward &&
+               range.lteMax(cur->level[i].forward->getMember())) {
+            upto += cur->level[i].span;
+            cur = cur->level[i].forward;
+        }
+    }
+    return upto > before ? upto - before : 0;
+}
+
+vector<ZSetType> SkipList::removeLexRange(const SkipListLexRange& range) {
+    vector<ZSetType> result;
+    if (range.empty()) {
         return result;
     }
 
-    pair<int, SkipListNode*> res;
-    // 如果左界小于等于0，则从头开始
-    if (lrank <= 0) {
-        res = {1, header->forward[0]};
-    } else { // 否则则找到左界
-        res = searchRankNode(lrank);
+    SkipListNode* update[SKIP_LIST_MAX_LEVEL];
+    SkipListNode* cur = header;
+    for (int i = level - 1; i >= 0; i--) {
+        while (cur->level[i].forward &&
+               !range.gteMin(cur->level[i].forward->getMember())) {
+            cur = cur->level[i].forward;
+        }
+        update[i] = cur;
     }
 
-    int curRank = res.first;
-    SkipListNode* cur = res.second;
-    SkipListSiblingNode* sibling;
+    // 区间内的节点连续排列，依次摘除
+    cur = cur->level[0].forward;
+    while (cur && range.lteMax(cur->getMember())) {
+        SkipListNode* next = cur->level[0].forward;
+        unlinkNode(cur, update);
+        result.push_back(cur->value);
+        SkipListNode::destroy(cur);
+        cur = next;
+    }
+    return result;
+}
 
-    // 如果起始rank小于lrank，说明lrank包含在重复score的一个sibling中
-    if (curRank < lrank) {
-        // 从第一个sibling开找
-        sibling = cur->nextSibling;
-        curRank++;
+bool SkipListRangeIter::inRange(const SkipListNode* node) const {
+    switch (kind) {
+    case ByScore:
+        return reverse ? score.gteMin(node->score) : score.lteMax(node->score);
+    case ByLex:
+        return SkipListLexRange{{}, {lexMax, lexMaxInf, lexMaxEx}}.lteMax(
+            node->getMember());
+    default:
+        return true;
+    }
+}
 
-        // 理论不会出现sibling先达到null的情况
-        while (curRank < lrank) {
-            sibling = sibling->nextSibling;
-            curRank++;
+int SkipListRangeIter::next(ZSetType* values, double* scores, int n) {
+    int filled = 0;
+    while (filled < n && cur && remaining > 0 && inRange(cur)) {
+        values[filled] = cur->value;
+        if (scores) {
+            scores[filled] = cur->score;
         }
+        filled++;
+        remaining--;
+        cur = reverse ? cur->backward : cur->level[0].forward;
+    }
+    // 遍历结束后不再访问节点
+    if (filled < n) {
+        cur = nullptr;
+    }
+    return filled;
+}
 
-        // 到了lrank后，小于rrank的全部推入
-        while (sibling && curRank <= rrank) {
-            result.push_back({cur->score, sibling->value});
-            sibling = sibling->nextSibling;
-            curRank++;
-        }
-        // 移动到直接后继
-        cur = cur->forward[0];
-        curRank++;
-    }
-    // 否则当前首节点就对应开始的lrank，可以直接开始遍历
-
-    // 开始遍历
-    while (cur && curRank <= rrank) {
-        result.push_back({cur->score, cur->value});
-        curRank++;
-        sibling = cur->nextSibling;
-        while (sibling && curRank <= rrank) {
-            result.push_back({cur->score, sibling->value});
-            sibling = sibling->nextSibling;
-            curRank++;
+void SkipList::seek(SkipListRangeIter& it, SkipListNode* first,
+                    ZSetSizeType rank, long offset, long count) {
+    it.cur = first;
+    it.remaining = count < 0 ? UINT64_MAX : count;
+    if (first && offset > 0 && it.reverse) {
+        // 反向时向表头方向移动，超出表头则为空
+        it.cur = (uint64_t)rank > (uint64_t)offset ? searchRankNode(rank - offset)
+                                                   : nullptr;
+    } else if (first && offset > 0) {
+        // 直接按排名定位，超出表尾则为空
+        it.cur = (uint64_t)rank + offset <= length ? searchRankNode(rank + offset)
+                                                   : nullptr;
+    } else if (offset < 0) {
+        it.cur = nullptr;
+    }
+}
+
+SkipListRangeIter SkipList::rangeByScore(const SkipListRange& range,
+                                         long offset, long count,
+                                         bool reverse) {
+    SkipListRangeIter it;
+    it.kind = SkipListRangeIter::ByScore;
+    it.score = range;
+    it.reverse = reverse;
+    ZSetSizeType rank = 0;
+    SkipListNode* first =
+        reverse ? lastInRange(range, rank) : firstInRange(range, rank);
+    seek(it, first, rank, offset, count);
+    return it;
+}
+
+SkipListRangeIter SkipList::rangeByLex(const SkipListLexRange& range,
+                                       long offset, long count) {
+    SkipListRangeIter it;
+    it.kind = SkipListRangeIter::ByLex;
+    it.lexMax = string(range.max.member);
+    it.lexMaxInf = range.max.inf;
+    it.lexMaxEx = range.max.ex;
+    ZSetSizeType rank = 0;
+    SkipListNode* first = firstInLexRange(range, rank);
+    seek(it, first, rank, offset, count);
+    return it;
+}
+
+bool SkipList::normalizeRankRange(int& lrank, int& rrank) const {
+    if (lrank < 0) { // 倒数转为正数
+        lrank = length + lrank + 1;
+    }
+    if (rrank < 0) {
+        rrank = length + rrank + 1;
+    }
+    // 超出范围的部分截断
+    if (lrank <= 0) {
+        lrank = 1;
+    }
+    if (rrank > (int)length) {
+        rrank = length;
+    }
+    return lrank <= rrank;
+}
+
+SkipListRangeIter SkipList::rangeByRank(int lrank, int rrank, bool reverse) {
+    SkipListRangeIter it;
+    it.reverse = reverse;
+    if (!normalizeRankRange(lrank, rrank)) { // 不合法rank
+        return it;
+    }
+
+    // 找到左界后沿第一层遍历，反向时左界为倒数第lrank个，从表尾数起的前几名直接从tail开始
+    if (!reverse) {
+        it.cur = searchRankNode(lrank);
+    } else if (lrank == 1) {
+        it.cur = tail;
+    } else {
+        it.cur = searchRankNode(length - lrank + 1);
+    }
+    it.remaining = rrank - lrank + 1;
+    return it;
+}
+
+vector<pair<double, ZSetType>> SkipList::drain(SkipListRangeIter it) {
+    vector<pair<double, ZSetType>> result;
+    const int batch = 64;
+    ZSetType values[batch];
+    double scores[batch];
+    for (int n; (n = it.next(values, scores, batch)) > 0;) {
+        for (int i = 0; i < n; i++) {
+            result.push_back({scores[i], values[i]});
         }
-        cur = cur->forward[0];
     }
     return result;
 }
@@ -544,17 +680,11 @@ void SkipList::print() const {
 
 void SkipList::printLevel(ZSetSizeType lvl) const {
     cout << "[Skip List] level: " << lvl + 1 << endl;
-    SkipListNode* cur = header->forward[lvl];
+    SkipListNode* cur = header->level[lvl].forward;
 
     while (cur) {
-        cout << "(" << cur->score << " " << cur->value;
-        SkipListSiblingNode* sibling = cur->nextSibling;
-        while (sibling) {
-            cout << ", " << sibling->value;
-            sibling = sibling->nextSibling;
-        }
-        cout << ")->";
-        cur = cur->forward[lvl];
+        cout << "(" << cur->score << " " << cur->getMember() << ")->";
+        cur = cur->level[lvl].forward;
     }
     cout << "null" << endl;
 }
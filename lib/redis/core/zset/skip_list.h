@@ -1,19 +1,28 @@
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <limits>
+#include <new>
+#include <string>
+#include <string_view>
 #include <vector>
 
 using namespace std;
 
 #define SKIP_LIST_MAX_LEVEL 32 // 最大层数
+// 每层以1/2^SKIP_LIST_P_BITS的概率加层，即p=1/4(与redis一致)
+#define SKIP_LIST_P_BITS 2
 const double SkipListNotFound = numeric_limits<double>::min();
 
 // 前向声明
 class SkipListNode;
-class SkipListSiblingNode;
 class SkipList;
+class SkipListBuilder;
 
 // ZSet(SkipList)存储Value数据类型(其实可以做成泛型)
 typedef uint32_t ZSetType;
@@ -24,115 +33,199 @@ typedef uint32_t ZSetSizeType;
 
 /*
 旧设计方式：
-设计方式：重复score的不同值使用newnode方式实现，而非将value换成vector形式
-适用场景：适用于重复score的值较少的场景
+重复score的不同值挂在首节点的SkipListSiblingNode链表上，按插入顺序排列。
+放弃原因：追加第k个同score元素需要遍历整条链表(O(k))，大量元素score相同时插入退化为平方级；
+且同score元素的顺序与redis不一致，也无法支持按字典序的范围查询。
 
-不使用vector的原因：
-vector对[每个节点]都会有额外24B占用(动态数组指针、大小、容量)，但可以减少一个forward指针开销，即额外开销len*16B；
-而newnode方式，除了与vector同样的val占的8B以外，额外对[重复score的节点]需要(16)(+scr+*bwd)+(24+8*2)(vector(*fwd)的大小期望)=60B；
-extra*60=len*16->除非重复score元素总数占总元素26.7%以上，否则newnode内存开销总比vector方式少；
-此处仅从内存方面讨论，未考虑性能开销，如vector动态分配内存/newnode维护开销。
-
-放弃原因：插入删除节点时，所需的操作过于繁琐，效率底下且不直观
+现设计方式(与redis一致)：
+每个元素都是一个普通节点，节点按(score, member)排序，score相同时按member的字节序排序。
+member的字节随节点一起保存，插入、删除、按字典序查找都是O(logn)。
 */
 
-// 跳表节点
+// 跳表节点的一层
+struct SkipListLevel {
+    SkipListNode* forward; // 该层的后继节点
+    // 跨度: 与forward中间相差多少个节点
+    // forward为空时，头结点的span为到表尾的节点数
+    ZSetSizeType span;
+};
 
-// 重复的节点不使用SkipListNode而是一个SkipListSiblingNode
-// 重复的部分相当于就是一个单纯的双向链表
-// redis的设计: 将重复节点当做普通节点，同score间按照字典序排序
+// 跳表节点
+// 节点与各层的{forward, span}以及member的字节一次分配在同一块内存中：
+// 层数组按randomLevel()的结果定长内联在节点尾部(柔性数组)，member紧随其后
 class SkipListNode {
     friend class SkipList;
+    friend class SkipListRangeIter;
+    friend class SkipListBuilder;
 
 public:
     ZSetType getValue() const { return value; }
     double getScore() const { return score; }
-
-    inline void AddSibling(ZSetType value);
+    string_view getMember() const {
+        return string_view(reinterpret_cast<const char*>(level + height),
+                           len);
+    }
 
     // 调试用
     void print() const;
 
 private:
-    ZSetType value; // 值(代表go对象的实际元素索引)
-    double score;   // 分数
+    double score; // 分数
 
-    // 前向指针: forward[0]对应level 1的后继节点，以此类推
-    vector<SkipListNode*> forward;
+    // 后向指针: 指向直接前驱节点，第一个节点为nullptr，用于反向遍历
+    SkipListNode* backward;
 
-    // 跨度: 与forward[i]中间相差多少个节点，长度与forward一致
-    // 重复score节点也算在内(每多一个重复节点都需要更新首节点forward++且更新“头顶经过forward”的span)
-    // cur->span[0]的大小代表当前score一共有几个兄弟节点(即不同value)
-    vector<uint32_t> span;
+    ZSetType value;      // 值(代表go对象的实际元素索引)
+    ZSetSizeType height; // 节点层数，即level数组长度
+    ZSetSizeType len;    // member的长度
 
-    // 后向指针: 指向直接前驱节点，但目前只是维护了其更新，还没用到
-    // 可能的用途: 查询与某个val相同score的所有节点;用于优化范围查询等
-    SkipListNode* backward;
-    SkipListSiblingNode* nextSibling;
+    // 各层: level[0]对应level 1，以此类推
+    SkipListLevel level[];
+
+    /* 创建层数为height的节点，forward置空、span置0，并复制member
+       返回值：新节点，分配失败抛出bad_alloc */
+    static SkipListNode* create(double scr, ZSetType val, string_view member,
+                                ZSetSizeType height);
+    // 释放节点
+    static void destroy(SkipListNode* node) { free(node); }
+
+    // 节点是否排在(scr, member)之前
+    inline bool lessThan(double scr, string_view member) const {
+        return score < scr || (score == scr && getMember() < member);
+    }
 
-    SkipListNode(double scr, ZSetType val, ZSetSizeType level)
-        : score(scr), value(val), forward(level, nullptr), span(level, 0),
-          backward(nullptr), nextSibling(nullptr) {}
+    SkipListNode() = delete;
+    ~SkipListNode() = delete;
+};
+
+// score区间，对应ZRANGEBYSCORE中的"min"、"(min"、"-inf"、"+inf"
+struct SkipListRange {
+    double min, max;
+    bool minex, maxex; // 是否为开区间
 
-    ~SkipListNode() {}
+    // 区间本身是否为空
+    bool empty() const {
+        return min > max || (min == max && (minex || maxex));
+    }
+    // score是否不小于min
+    bool gteMin(double score) const {
+        return minex ? score > min : score >= min;
+    }
+    // score是否不大于max
+    bool lteMax(double score) const {
+        return maxex ? score < max : score <= max;
+    }
 };
 
-// 重复score节点的实现
-// extra*16=len*24->只要重复score不超过length的1.5倍，使用链表就是赚的
-class SkipListSiblingNode {
-    friend class SkipListNode;
+// 字典序区间的一端，对应ZRANGEBYLEX中的"[member"、"(member"、"-"、"+"
+struct SkipListLexBound {
+    string_view member;
+    int inf; // -1表示"-"(负无穷)，1表示"+"(正无穷)，0表示member
+    bool ex; // 是否为开区间
+};
+
+// 字典序区间[min, max]
+// 与redis一致，只比较member，只有在所有元素score相同时结果才有意义
+struct SkipListLexRange {
+    SkipListLexBound min;
+    SkipListLexBound max;
+
+    // 区间本身是否为空(min大于max，或二者相等且有一端为开区间)
+    bool empty() const;
+    // member是否不小于min
+    bool gteMin(string_view member) const;
+    // member是否不大于max
+    bool lteMax(string_view member) const;
+};
+
+// 范围查询游标
+// 沿第一层顺序遍历(反向时沿backward指针)，按批次把值写入调用方提供的缓冲区，
+// 不产生中间数组；游标存续期间不能修改跳表
+class SkipListRangeIter {
     friend class SkipList;
 
+public:
+    SkipListRangeIter()
+        : cur(nullptr), remaining(0), kind(ByRank), reverse(false) {}
+
+    /* 写入至多n个元素的值(scores不为空时一并写入score)
+       返回值：实际写入的数量，为0表示遍历结束 */
+    int next(ZSetType* values, double* scores, int n);
+
 private:
-    ZSetType value; // 值(代表go对象的实际元素索引)
-    SkipListSiblingNode* nextSibling;
+    enum Kind { ByRank, ByScore, ByLex };
+
+    SkipListNode* cur;   // 下一个要返回的节点
+    uint64_t remaining;  // 最多还能返回的元素数(LIMIT count)
+    Kind kind;           // 区间类型，决定终止条件
+    bool reverse;        // 是否从大到小遍历
+    SkipListRange score; // ByScore时的区间
+    // ByLex时的上界，复制一份，不引用调用方的内存
+    string lexMax;
+    int lexMaxInf;
+    bool lexMaxEx;
+
+    // 节点是否仍在区间内
+    bool inRange(const SkipListNode* node) const;
+};
 
-    SkipListSiblingNode(ZSetType val) : value(val), nextSibling(nullptr) {}
+// 跳表专用的随机数发生器(xorshift64*)
+// 每个跳表各持有一个，不加锁、不依赖全局的rand()；种子相同则生成的序列相同
+class SkipListRandom {
+public:
+    // seed为0时由时钟与对象地址生成种子
+    explicit SkipListRandom(uint64_t seed);
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    }
 
-    ~SkipListSiblingNode() {}
+private:
+    uint64_t state; // 不能为0
 };
 
 // 跳表
 class SkipList {
+    friend class SkipListBuilder;
+
 public:
-    // 头结点，不会实际使用所以value设置为0也没关系
-    SkipList()
-        : level(0), header(new SkipListNode(-INFINITY, 0, SKIP_LIST_MAX_LEVEL)),
-          tail(nullptr) {
-        if (!header) {
-            throw runtime_error("Memory allocation for header failed.");
-            delete header;
-        }
-    }
+    /* maxLevel: 最大层数，截断到[1, SKIP_LIST_MAX_LEVEL]
+       pBits: 每层以1/2^pBits的概率加层
+       seed: 层数随机数的种子，为0时随机选取，测试与基准测试中固定种子以便复现
+       头结点，不会实际使用所以value设置为0也没关系 */
+    explicit SkipList(ZSetSizeType maxLevel = SKIP_LIST_MAX_LEVEL,
+                      ZSetSizeType pBits = SKIP_LIST_P_BITS, uint64_t seed = 0)
+        : maxLevel(min<ZSetSizeType>(max<ZSetSizeType>(maxLevel, 1),
+                                     SKIP_LIST_MAX_LEVEL)),
+          pBits(max<ZSetSizeType>(pBits, 1)), rng(seed),
+          header(SkipListNode::create(-INFINITY, 0, string_view(),
+                                      this->maxLevel)),
+          tail(nullptr), level(0), length(0) {}
 
     // 循环释放
     ~SkipList() {
         SkipListNode* cur = header;
         while (cur) {
             // 直接后缀
-            SkipListNode* next = cur->forward[0];
-
-            // 删除重复score的所有元素
-            SkipListSiblingNode* cur2 = cur->nextSibling;
-            while (cur2) {
-                SkipListSiblingNode* next2 = cur2->nextSibling;
-                delete cur2;
-                cur2 = next2;
-            }
-
-            // 删除当前节点
-            delete cur;
+            SkipListNode* next = cur->level[0].forward;
+            SkipListNode::destroy(cur);
             cur = next;
         }
     }
 
+    SkipList(const SkipList&) = delete;
+    SkipList& operator=(const SkipList&) = delete;
+
     SkipListNode* Header() const { return this->header; }
     SkipListNode* Tail() const { return this->tail; }
     ZSetSizeType Level() const { return this->level; }
     ZSetSizeType Len() const { return this->length; }
 
-    // 重复score的节点以Sibling的形式链表插入
-    void insert(double score, ZSetType value);
+    // 插入(score, member)，由上层保证member不存在
+    void insert(double score, ZSetType value, string_view member);
 
     // 此处不做按值查找，而是在zset的哈希表中存其score，将value查找置换为score
     // SkipListNode* find(ZSetType value);
@@ -141,20 +234,47 @@ public:
 
     // 单点查询，寻找对应score的所有值
     vector<ZSetType> search(double score);
-    // 范围查询，在上层调用中检查l与r的大小与范围关系，此处不检查
-    vector<pair<double, ZSetType>> searchRange(double lscore, double rscore);
+    // 范围查询，两端均包含，l大于r时为空；reverse为true时从大到小输出
+    vector<pair<double, ZSetType>> searchRange(double lscore, double rscore,
+                                               bool reverse = false);
     //
     // 删除同一score的所有节点并返回删除的值
     vector<ZSetType> remove(double score);
-    // 删除指定val的节点并返回是否成功(score由hash表传入)
+    // 删除(score, member)对应的节点并返回是否成功(score由hash表传入)
     // 检查是否存在value，以及返回对应score应该在上层处理
-    bool remove(double score, ZSetType value);
+    bool remove(double score, string_view member);
     //
-    // 按排名查询，负数则转换为“倒数第n个”
-    // 同score则按照插入顺序正序排名
+    // 按排名查询(从1开始)，负数则转换为“倒数第n个”
+    // 同score则按照member的字典序排名
     pair<double, ZSetType> searchRank(int rank);
-    // 按排名范围查找。
+    // 按排名范围查找，两端均包含，负数含义同上，超出范围的部分被截断
     vector<pair<double, ZSetType>> searchRankRange(int lrank, int rrank);
+    //
+    // 按字典序范围查找
+    vector<pair<double, ZSetType>> searchLexRange(const SkipListLexRange& range);
+    //
+    // score区间内的元素个数，O(logn)
+    ZSetSizeType count(const SkipListRange& range);
+    // 字典序范围内的元素个数，O(logn)
+    ZSetSizeType lexCount(const SkipListLexRange& range);
+    // 删除字典序范围内的所有节点并返回删除的值
+    vector<ZSetType> removeLexRange(const SkipListLexRange& range);
+    // 删除score区间内的所有节点并返回删除的值，一次遍历完成
+    vector<ZSetType> removeRange(const SkipListRange& range);
+    // 删除排名区间[lrank, rrank]内的所有节点并返回删除的值，排名含义同searchRankRange
+    vector<ZSetType> removeRankRange(int lrank, int rrank);
+
+    // 范围查询游标：先跳过offset个元素，最多返回count个(count为负数表示不限)
+    // 起点通过span定位，offset的跳过为O(logn)
+    // reverse为true时从区间的最后一个元素开始沿backward指针遍历，
+    // 只访问返回的节点，不必遍历整个区间
+    SkipListRangeIter rangeByScore(const SkipListRange& range, long offset,
+                                   long count, bool reverse = false);
+    SkipListRangeIter rangeByLex(const SkipListLexRange& range, long offset,
+                                 long count);
+    // 排名区间[lrank, rrank]的游标，排名含义同searchRankRange
+    // reverse为true时排名从表尾数起(1为score最大的节点)，从大到小遍历
+    SkipListRangeIter rangeByRank(int lrank, int rrank, bool reverse = false);
 
     // 该部分函数为测试用
 
@@ -164,26 +284,65 @@ public:
     void printLevel(ZSetSizeType lvl) const;
 
 private:
-    // 随机生成层数(算法有待改善)
-    ZSetSizeType randomLevel() const;
+    // 随机生成层数: 第k层以p^(k-1)的概率出现，不超过maxLevel
+    ZSetSizeType randomLevel();
 
     // 该部分操作函数返回值为节点指针
 
     // 寻找对应score的首结点
     SkipListNode* searchNode(double score);
     //
-    // 在上面public的函数及更上层调用中检查l与r的大小与范围关系，此处不检查。
-    // 寻找对应范围的首节点
-    vector<SkipListNode*> searchRangeNode(double lscore, double rscore);
+    // 从跳表中摘除节点cur(不释放)，update[i]为第i层上cur之前的最后一个节点
+    void unlinkNode(SkipListNode* cur, SkipListNode** update);
     //
-    // 删除同一score的所有节点并返回删除的首节点
-    SkipListNode* removeNode(double score);
+    // 按排名查找(从1开始)，不存在则返回nullptr
+    SkipListNode* searchRankNode(ZSetSizeType rank);
     //
-    // 按排名查找，返回值为首节点及其rank(如果有重复score节点则小于要找的rank)
-    pair<int, SkipListNode*> searchRankNode(int rank);
+    // 将负数排名转换为正数并截断到[1, length]
+    // 返回值：区间是否非空
+    bool normalizeRankRange(int& lrank, int& rrank) const;
+    //
+    // 区间内的第一个节点及其排名(从1开始)，不存在则返回nullptr
+    SkipListNode* firstInRange(const SkipListRange& range, ZSetSizeType& rank);
+    // 区间内的最后一个节点及其排名，不存在则返回nullptr
+    SkipListNode* lastInRange(const SkipListRange& range, ZSetSizeType& rank);
+    SkipListNode* firstInLexRange(const SkipListLexRange& range,
+                                  ZSetSizeType& rank);
+    //
+    // 将游标的起点从排名为rank的first沿遍历方向移动offset个元素，并设置数量上限
+    void seek(SkipListRangeIter& it, SkipListNode* first, ZSetSizeType rank,
+              long offset, long count);
+    //
+    // 取出游标中剩余的全部元素
+    static vector<pair<double, ZSetType>> drain(SkipListRangeIter it);
+
+    ZSetSizeType maxLevel; // 最大层数，头结点的层数
+    ZSetSizeType pBits;    // 加层概率p=1/2^pBits
+    SkipListRandom rng;    // 层数的随机数发生器
 
     SkipListNode* header; // 头节点
     SkipListNode* tail;   // 尾节点
     ZSetSizeType level;   // 当前最高层数
     ZSetSizeType length;  // 跳表长度
-};
\ No newline at end of file
+};
+
+// 按序追加构建跳表
+// 每层记录当前最后一个节点及其排名，追加一个节点只需连接这些节点，无需自顶向下查找，
+// 构建n个元素为O(n)
+// 追加的(score, member)必须大于表尾；构建期间表尾节点的span未更新，
+// 追加完成后必须调用finish，之后才能对跳表进行其他操作
+class SkipListBuilder {
+public:
+    // 从list当前的表尾开始追加(list可以非空)
+    explicit SkipListBuilder(SkipList& list);
+
+    // 在表尾追加节点
+    void append(double score, ZSetType value, string_view member);
+    // 补齐各层最后一个节点的span
+    void finish();
+
+private:
+    SkipList& list;
+    SkipListNode* last[SKIP_LIST_MAX_LEVEL];     // 各层的最后一个节点
+    ZSetSizeType lastRank[SKIP_LIST_MAX_LEVEL]; // 对应节点的排名，header为0
+};
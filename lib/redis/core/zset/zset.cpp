@@ -1,7 +1,8 @@
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <exception>
 #include <limits>
-#include <unordered_map>
 #include <vector>
 
 #include "skip_list.h"
@@ -18,38 +19,40 @@ extern "C" {
 // 使用两个特殊的double值表示状态，避免额外状态位的设定
 const double ZSetNotFound = numeric_limits<double>::min();
 const double ZSetSuccess = numeric_limits<double>::max();
+// score索引中空位的标记，合法的score不会是NaN
+const double ZSetTombstone = numeric_limits<double>::quiet_NaN();
 
 // 有序集合
 class zset {
 
 public:
-    zset(){
-
-    };
+    // seed为跳表层数随机数的种子，为0时随机选取
+    explicit zset(uint64_t seed)
+        : list(SKIP_LIST_MAX_LEVEL, SKIP_LIST_P_BITS, seed) {}
     ~zset(){
 
     };
 
     // 获取对应元素的score
     double getScore(ZSetType value) const {
-        auto it = map.find(value);
-        if (it != map.end()) {
-            return it->second;
-        }
-        return ZSetNotFound;
+        return contains(value) ? scores[value] : ZSetNotFound;
     }
 
-    int len() const { return map.size(); }
+    int len() const { return list.Len(); }
 
     // 添加元素，若已存在则返回value对应score
-    double add(double score, ZSetType value);
+    double add(double score, ZSetType value, string_view member);
+    // 批量添加，已存在的value被跳过
+    // 输入按(score, member)有序且排在现有元素之后时按序追加构建，O(n)；否则逐个插入
+    void addMany(const double* scrs, const ZSetType* values,
+                 const char* members, const uint32_t* lens, int n);
     // 移除元素，返回对应value
     vector<ZSetType> remove(double score);
-    // 按值移除，若不存在则返回false
-    double remove(ZSetType value);
+    // 按值移除，返回对应score，若不存在则返回ZSetNotFound
+    double remove(ZSetType value, string_view member);
     // 查找元素
     vector<ZSetType> search(double score);
-    // 如果l大于r，则反向输出
+    // 如果l大于r，则从大到小输出
     vector<pair<double, ZSetType>> searchRange(double lscore, double rscore);
     // 按值查找(本质还是按score查找)
     vector<ZSetType> searchValue(ZSetType value);
@@ -60,68 +63,159 @@ public:
     // 按排名范围查找(允许l<=0或r>length)
     // 返回score，value对的vector
     vector<pair<double, ZSetType>> searchRankRange(int lrank, int rrank);
+    // 范围查询游标
+    SkipListRangeIter rangeByScore(const SkipListRange& range, long offset,
+                                   long count, bool reverse) {
+        return list.rangeByScore(range, offset, count, reverse);
+    }
+    SkipListRangeIter rangeByLex(const SkipListLexRange& range, long offset,
+                                 long count) {
+        return list.rangeByLex(range, offset, count);
+    }
+    SkipListRangeIter rangeByRank(int lrank, int rrank, bool reverse) {
+        return list.rangeByRank(lrank, rrank, reverse);
+    }
+    // score区间内的元素个数
+    ZSetSizeType count(const SkipListRange& range) { return list.count(range); }
+    // 字典序范围内的元素个数
+    ZSetSizeType lexCount(const SkipListLexRange& range) {
+        return list.lexCount(range);
+    }
+    // 删除字典序范围内的元素，返回删除的值
+    vector<ZSetType> removeLexRange(const SkipListLexRange& range);
+    // 删除score区间内的元素，返回删除的值
+    vector<ZSetType> removeRange(const SkipListRange& range);
+    // 删除排名区间内的元素，返回删除的值
+    vector<ZSetType> removeRankRange(int lrank, int rrank);
 
 private:
-    // value->score哈希表
-    unordered_map<ZSetType, double> map;
+    bool contains(ZSetType value) const {
+        return value < scores.size() && !isnan(scores[value]);
+    }
+    void eraseValues(const vector<ZSetType>& values);
+
+    // value->score索引
+    // value是go端objs中的下标，本身稠密且删除后会被复用，直接用数组按下标存score，
+    // 不存在的位置为ZSetTombstone；比哈希表少一次哈希与每个元素一个节点的分配
+    vector<double> scores;
 
     // 跳跃表
     SkipList list;
 };
 
-double zset::add(double score, ZSetType value) {
+double zset::add(double score, ZSetType value, string_view member) {
     // value已存在则返回其对应score
-    auto it = map.find(value);
-    if (it != map.end()) {
-        return it->second;
+    if (contains(value)) {
+        return scores[value];
     }
 
-    map[value] = score;
-    list.insert(score, value);
+    if (value >= scores.size()) {
+        // resize按倍数扩容，均摊O(1)
+        scores.resize(value + 1, ZSetTombstone);
+    }
+    list.insert(score, value, member);
+    scores[value] = score;
     return ZSetSuccess;
 }
 
-vector<ZSetType> zset::remove(double score) {
-    vector<ZSetType> result;
-    result = list.remove(score);
-    for (auto r : result) {
-        auto it = map.find(r);
-        // 理论上是都会找到的
-        if (it != map.end()) {
-            map.erase(it);
+void zset::addMany(const double* scrs, const ZSetType* values,
+                   const char* members, const uint32_t* lens, int n) {
+    ZSetType maxValue = 0;
+    bool sorted = true;
+    SkipListNode* tail = list.Tail();
+    const char* p = members;
+    for (int i = 0; i < n; i++) {
+        string_view member(p, lens[i]);
+        // 与前一个元素(第一个元素与表尾)比较
+        if (i == 0 && tail) {
+            sorted = tail->getScore() < scrs[0] ||
+                     (tail->getScore() == scrs[0] &&
+                      tail->getMember() < member);
+        } else if (i > 0) {
+            string_view prev(p - lens[i - 1], lens[i - 1]);
+            sorted = sorted && (scrs[i - 1] < scrs[i] ||
+                                (scrs[i - 1] == scrs[i] && prev < member));
+        }
+        maxValue = max(maxValue, values[i]);
+        p += lens[i];
+    }
+    if (n > 0 && maxValue >= scores.size()) {
+        scores.resize(maxValue + 1, ZSetTombstone);
+    }
+
+    if (!sorted) {
+        for (int i = 0; i < n; i++) {
+            add(scrs[i], values[i], string_view(members, lens[i]));
+            members += lens[i];
+        }
+        return;
+    }
+
+    SkipListBuilder builder(list);
+    for (int i = 0; i < n; i++) {
+        string_view member(members, lens[i]);
+        members += lens[i];
+        if (contains(values[i])) {
+            continue;
         }
+        builder.append(scrs[i], values[i], member);
+        scores[values[i]] = scrs[i];
     }
+    builder.finish();
+}
+
+vector<ZSetType> zset::remove(double score) {
+    vector<ZSetType> result = list.remove(score);
+    eraseValues(result);
     return result;
 }
 
-double zset::remove(ZSetType value) {
+double zset::remove(ZSetType value, string_view member) {
     // value不存在则返回ZSetNotFound
-    auto it = map.find(value);
-    if (it == map.end()) {
+    if (!contains(value)) {
         return ZSetNotFound;
     }
 
-    bool result = list.remove(it->second, value);
-    map.erase(it);
+    double score = scores[value];
+    list.remove(score, member);
+    scores[value] = ZSetTombstone;
     // 返回对应的score
-    return it->second;
+    return score;
 }
 
-vector<ZSetType> zset::search(double score) {
-    auto it = map.find(score);
-    if (it != map.end()) {
-        return list.search(score);
+// 从score索引中删除跳表已删除的值
+void zset::eraseValues(const vector<ZSetType>& values) {
+    for (auto v : values) {
+        scores[v] = ZSetTombstone;
     }
-    return vector<ZSetType>(0);
 }
 
+vector<ZSetType> zset::removeLexRange(const SkipListLexRange& range) {
+    vector<ZSetType> result = list.removeLexRange(range);
+    eraseValues(result);
+    return result;
+}
+
+vector<ZSetType> zset::removeRange(const SkipListRange& range) {
+    vector<ZSetType> result = list.removeRange(range);
+    eraseValues(result);
+    return result;
+}
+
+vector<ZSetType> zset::removeRankRange(int lrank, int rrank) {
+    vector<ZSetType> result = list.removeRankRange(lrank, rrank);
+    eraseValues(result);
+    return result;
+}
+
+vector<ZSetType> zset::search(double score) { return list.search(score); }
+
 vector<pair<double, ZSetType>> zset::searchRange(double lscore, double rscore) {
-    vector<pair<double, ZSetType>> result = list.searchRange(lscore, rscore);
-    // 如果l大于r，则反向输出
+    // 如果l大于r，则沿backward指针从大到小遍历
     if (lscore > rscore) {
-        reverse(result.begin(), result.end());
+        return list.searchRange(rscore, lscore, true);
     }
-    return result;
+    return list.searchRange(lscore, rscore);
 }
 
 vector<ZSetType> zset::searchValue(ZSetType value) {
@@ -152,8 +246,21 @@ vector<pair<double, ZSetType>> zset::searchRankRange(int lrank, int rrank) {
     return list.searchRankRange(lrank, rrank);
 }
 
-void* NewZSet() {
-    zset* zs = new zset();
+// 将值数组复制到malloc分配的内存中返回给go，由go端C.free释放
+// 不能直接返回vector的数据，函数返回后vector即被析构
+static void* valueArray(const vector<ZSetType>& v, int* length) {
+    *length = v.size();
+    // malloc(0)可能返回nullptr，至少分配一个元素，go端统一free
+    ZSetType* res =
+        (ZSetType*)malloc(max<size_t>(v.size(), 1) * sizeof(ZSetType));
+    if (!v.empty()) {
+        memcpy(res, v.data(), v.size() * sizeof(ZSetType));
+    }
+    return static_cast<void*>(res);
+}
+
+void* NewZSet(uint64_t seed) {
+    zset* zs = new zset(seed);
     return static_cast<zset*>(zs);
 }
 
@@ -169,69 +276,109 @@ double ZSetGetScore(void* zs, ZSetType value) {
     return static_cast<zset*>(zs)->getScore(value);
 }
 
-double ZSetAdd(void* zs, double score, ZSetType value) {
-    return static_cast<zset*>(zs)->add(score, value);
+double ZSetAdd(void* zs, double score, ZSetType value, const char* member,
+               size_t len) {
+    return static_cast<zset*>(zs)->add(score, value, string_view(member, len));
+}
+
+void ZSetAddMany(void* zs, const double* scores, const ZSetType* values,
+                 const char* members, const uint32_t* lens, int n) {
+    static_cast<zset*>(zs)->addMany(scores, values, members, lens, n);
 }
 
 void* ZSetRemoveScore(void* zs, double score, int* length) {
-    // 使用c风格
-    // 新分配了一块内存，用于存储返回给go的数组（否则返回局部变量被清理掉到那边就是空的）
-    // TODO: go那边用完需要调用C.free释放
-    vector<ZSetType> v = static_cast<zset*>(zs)->remove(score);
-    ZSetType* res = (ZSetType*)malloc(v.size() * sizeof(ZSetType));
-    res = &v[0];
-    *length = v.size();
-    return static_cast<void*>(res);
+    return valueArray(static_cast<zset*>(zs)->remove(score), length);
+}
+
+void* ZSetRemoveRange(void* zs, double min, int minex, double max, int maxex,
+                      int* length) {
+    SkipListRange range{min, max, minex != 0, maxex != 0};
+    return valueArray(static_cast<zset*>(zs)->removeRange(range), length);
+}
 
-    // 这里返回了临时变量数组的地址，内存管理可能会有问题
-    // return static_cast<void*>(static_cast<zset*>(zs)->remove(score));
+void* ZSetRemoveRankRange(void* zs, int lrank, int rrank, int* length) {
+    return valueArray(static_cast<zset*>(zs)->removeRankRange(lrank, rrank),
+                      length);
 }
 
-double ZSetRemoveValue(void* zs, ZSetType value) {
+double ZSetRemoveValue(void* zs, ZSetType value, const char* member,
+                       size_t len) {
     try {
-        return (static_cast<zset*>(zs)->remove(value));
-    } catch (exception err) {
+        return (static_cast<zset*>(zs)->remove(value, string_view(member, len)));
+    } catch (const exception& err) {
         cout << err.what() << endl;
         return 0;
     }
 }
 
 void* ZSetSearch(void* zs, double score, int* length) {
-    vector<ZSetType> v = static_cast<zset*>(zs)->search(score);
-    ZSetType* res = (ZSetType*)malloc(v.size() * sizeof(ZSetType));
-    res = &v[0];
-    *length = v.size();
-    return static_cast<void*>(res);
+    return valueArray(static_cast<zset*>(zs)->search(score), length);
 }
 
-void* ZSetSearchRange(void* zs, double lscore, double rscore, int* length) {
-    // 这里的pair对应go端的ZNode
-    vector<pair<double, ZSetType>> v =
-        static_cast<zset*>(zs)->searchRange(lscore, rscore);
-    *length = v.size();
-    ZSetType* res = (ZSetType*)malloc(*length * sizeof(ZSetType));
+ZSetType ZSetSearchRank(void* zs, int rank) {
+    return (static_cast<zset*>(zs)->searchRank(rank));
+}
 
-    for (int i = 0; i < *length; i++) {
-        res[i] = v[i].second;
+// 由C接口的(member, len, flag)构造字典序区间的一端
+static SkipListLexBound lexBound(const char* member, size_t len, int flag) {
+    switch (flag) {
+    case ZSetLexNegInf:
+        return {string_view(), -1, false};
+    case ZSetLexPosInf:
+        return {string_view(), 1, false};
+    default:
+        return {string_view(member, len), 0, flag == ZSetLexExclusive};
     }
+}
 
-    return static_cast<void*>(res);
+void* ZSetRangeOpen(void* zs, double min, int minex, double max, int maxex,
+                    long offset, long count, int reverse) {
+    SkipListRange range{min, max, minex != 0, maxex != 0};
+    return new SkipListRangeIter(static_cast<zset*>(zs)->rangeByScore(
+        range, offset, count, reverse != 0));
 }
 
-ZSetType ZSetSearchRank(void* zs, int rank) {
-    return (static_cast<zset*>(zs)->searchRank(rank));
+void* ZSetRangeOpenRank(void* zs, int lrank, int rrank, int reverse) {
+    return new SkipListRangeIter(
+        static_cast<zset*>(zs)->rangeByRank(lrank, rrank, reverse != 0));
 }
 
-void* ZSetSearchRankRange(void* zs, int lrank, int rrank, int* length) {
-    vector<pair<double, ZSetType>> v =
-        static_cast<zset*>(zs)->searchRankRange(lrank, rrank);
-    *length = v.size();
-    ZSetType* res = (ZSetType*)malloc(*length * sizeof(ZSetType));
-    for (int i = 0; i < *length; i++) {
-        res[i] = v[i].second;
-    }
+void* ZSetRangeOpenLex(void* zs, const char* min, size_t minlen, int minflag,
+                       const char* max, size_t maxlen, int maxflag,
+                       long offset, long count) {
+    // 游标复制了上界，返回后不再引用go的内存
+    SkipListLexRange range{lexBound(min, minlen, minflag),
+                           lexBound(max, maxlen, maxflag)};
+    return new SkipListRangeIter(
+        static_cast<zset*>(zs)->rangeByLex(range, offset, count));
+}
 
-    return static_cast<void*>(res);
+int ZSetRangeNext(void* it, ZSetType* values, int n) {
+    return static_cast<SkipListRangeIter*>(it)->next(values, nullptr, n);
+}
+
+void ZSetRangeClose(void* it) {
+    delete static_cast<SkipListRangeIter*>(it);
+}
+
+int ZSetCount(void* zs, double min, int minex, double max, int maxex) {
+    SkipListRange range{min, max, minex != 0, maxex != 0};
+    return static_cast<zset*>(zs)->count(range);
+}
+
+int ZSetLexCount(void* zs, const char* min, size_t minlen, int minflag,
+                 const char* max, size_t maxlen, int maxflag) {
+    SkipListLexRange range{lexBound(min, minlen, minflag),
+                           lexBound(max, maxlen, maxflag)};
+    return static_cast<zset*>(zs)->lexCount(range);
+}
+
+void* ZSetRemoveLexRange(void* zs, const char* min, size_t minlen, int minflag,
+                         const char* max, size_t maxlen, int maxflag,
+                         int* length) {
+    SkipListLexRange range{lexBound(min, minlen, minflag),
+                           lexBound(max, maxlen, maxflag)};
+    return valueArray(static_cast<zset*>(zs)->removeLexRange(range), length);
 }
 
 double ZSetNotFoundSign() {
@@ -9,7 +9,10 @@ import "C"
 
 import (
 	"errors"
+	"math"
 	"runtime"
+	"slices"
+	"strings"
 	"unsafe"
 )
 
@@ -24,6 +27,83 @@ var (
 	ZSetFound    = float64(C.ZSetSuccessSign())  // 1.797693e+308
 )
 
+// 直接指向Go字符串的字节，不复制也无需释放
+// 字符串不含Go指针，可以在cgo调用期间传给C；C++侧会复制需要保存的部分
+func memberPtr(member string) *C.char {
+	return (*C.char)(unsafe.Pointer(unsafe.StringData(member)))
+}
+
+// 字典序区间端点的类型
+const (
+	LexInclusive = C.ZSetLexInclusive // "[member"
+	LexExclusive = C.ZSetLexExclusive // "(member"
+	LexNegInf    = C.ZSetLexNegInf    // "-"
+	LexPosInf    = C.ZSetLexPosInf    // "+"
+)
+
+// LexBound 字典序区间的一端，对应ZRANGEBYLEX中的"[member"、"(member"、"-"、"+"
+type LexBound struct {
+	Member string
+	Flag   int
+}
+
+// member是否不小于下界b
+func (b LexBound) lteMember(member []byte) bool {
+	switch b.Flag {
+	case LexNegInf:
+		return true
+	case LexPosInf:
+		return false
+	case LexExclusive:
+		return string(member) > b.Member
+	default:
+		return string(member) >= b.Member
+	}
+}
+
+// member是否不大于上界b
+func (b LexBound) gteMember(member []byte) bool {
+	switch b.Flag {
+	case LexNegInf:
+		return false
+	case LexPosInf:
+		return true
+	case LexExclusive:
+		return string(member) < b.Member
+	default:
+		return string(member) <= b.Member
+	}
+}
+
+// ScoreRange score区间，对应ZRANGEBYSCORE中的"min"、"(min"，Ex为true表示开区间
+type ScoreRange struct {
+	Min, Max     float64
+	MinEx, MaxEx bool
+}
+
+// score是否不小于min
+func (r ScoreRange) gteMin(score float64) bool {
+	if r.MinEx {
+		return score > r.Min
+	}
+	return score >= r.Min
+}
+
+// score是否不大于max
+func (r ScoreRange) lteMax(score float64) bool {
+	if r.MaxEx {
+		return score < r.Max
+	}
+	return score <= r.Max
+}
+
+func cBool(b bool) C.int {
+	if b {
+		return 1
+	}
+	return 0
+}
+
 // 大写，因为要是导出字段
 
 type CZNode struct {
@@ -40,37 +120,226 @@ func NewZNode(score float64, value string) ZNode {
 	return ZNode{score, value}
 }
 
+const (
+	encListpack = iota // 底层类型：紧凑列表
+	encSkipList        // 底层类型：跳表+哈希表
+)
+
+// 与redis的zset-max-listpack-entries、zset-max-listpack-value含义相同：
+// 元素个数超过ZSetMaxListpackEntries或member长度超过ZSetMaxListpackValue时转换为跳表
+var (
+	ZSetMaxListpackEntries = 128
+	ZSetMaxListpackValue   = 64
+)
+
+// 跳表层数随机数的种子，为0时每个跳表各自随机选取；基准测试中固定以便复现
+var skipListSeed uint64
+
 // ZSet
-// 参考HashDict，将对象本体放在objs中，在c中只保存对象在objs中的索引。
+/**
+根据存储内容自动选择底层的数据结构；
+元素较少且member较短时，采用listpack，所有元素连续存放在Go的一块内存中；
+否则采用跳表+哈希表：参考HashDict，将对象本体放在objs中，在c中只保存对象在objs中的索引。
+*/
 type ZSet struct {
+	enc byte     // 底层编码
+	lp  listpack // enc为encListpack时使用
+
+	// 以下字段在enc为encSkipList时使用
 	ptr           unsafe.Pointer // 有序列表对象
 	objs          []ZNode        // Go对象
 	availablePose []int          // objs数组中的可用索引，为了复用删除对象的位置
 	v2i           map[string]int // value到index索引...
 }
 
+// 新建的有序集合为listpack编码，不分配C++对象
 func NewZSet() *ZSet {
-	ptr := C.NewZSet()
-	zset := &ZSet{
-		ptr:           ptr,
-		v2i:           make(map[string]int), // 初始化 map
-		availablePose: make([]int, 0),
+	return &ZSet{enc: encListpack}
+}
+
+// 转换底层格式为跳表+哈希表
+func (zs *ZSet) listpackToSkipList() {
+	if zs.enc != encListpack {
+		return
+	}
+
+	nodes := make([]ZNode, 0, zs.lp.n)
+	for off := 0; off < len(zs.lp.buf); {
+		score, member, next := zs.lp.entry(off)
+		nodes = append(nodes, ZNode{score, string(member)})
+		off = next
 	}
+	zs.lp = listpack{}
+	zs.initSkipList(nodes)
+}
+
+// 切换为跳表编码并以nodes初始化，nodes按(score, member)有序且member互不相同
+// nodes直接作为objs
+func (zs *ZSet) initSkipList(nodes []ZNode) {
+	zs.ptr = C.NewZSet(C.uint64_t(skipListSeed))
+	zs.enc = encSkipList
 
 	// 注册析构函数
-	runtime.SetFinalizer(zset, func(zs *ZSet) {
+	runtime.SetFinalizer(zs, func(zs *ZSet) {
 		C.ReleaseZSet(zs.ptr)
 	})
 
-	return zset
+	zs.objs = nodes
+	zs.v2i = make(map[string]int, len(nodes))
+	positions := make([]int, len(nodes))
+	for pos, node := range nodes {
+		zs.v2i[node.Value] = pos
+		positions[pos] = pos
+	}
+	zs.cAddMany(positions)
+}
+
+// 将objs中positions处的元素一次cgo调用加入C++跳表
+// 这些元素按(score, member)有序且都排在现有元素之后时，C++侧按序追加构建跳表，为O(n)
+func (zs *ZSet) cAddMany(positions []int) {
+	if len(positions) == 0 {
+		return
+	}
+	total := 0
+	for _, pos := range positions {
+		total += len(zs.objs[pos].Value)
+	}
+	scores := make([]C.double, len(positions))
+	values := make([]C.uint, len(positions))
+	lens := make([]C.uint32_t, len(positions))
+	members := make([]byte, 0, total+1)
+	for i, pos := range positions {
+		node := zs.objs[pos]
+		scores[i] = C.double(node.Score)
+		values[i] = C.uint(pos)
+		lens[i] = C.uint32_t(len(node.Value))
+		members = append(members, node.Value...)
+	}
+	C.ZSetAddMany(zs.ptr, &scores[0], &values[0],
+		(*C.char)(unsafe.Pointer(unsafe.SliceData(members))), &lens[0], C.int(len(positions)))
+}
+
+/*
+ZSetAddMany 添加多个元素(ZADD score member [score member ...])
+已存在的元素更新score；同一批中重复的member以最后一次为准；score为NaN的元素被忽略
+返回值：新增的元素个数
+*/
+func (zs *ZSet) ZSetAddMany(nodes []ZNode) int {
+	isNaN := func(node ZNode) bool { return math.IsNaN(node.Score) }
+	if slices.ContainsFunc(nodes, isNaN) {
+		nodes = slices.DeleteFunc(slices.Clone(nodes), isNaN)
+	}
+	if zs.enc == encListpack {
+		fits := zs.lp.n+len(nodes) <= ZSetMaxListpackEntries
+		for i := 0; fits && i < len(nodes); i++ {
+			fits = len(nodes[i].Value) <= ZSetMaxListpackValue
+		}
+		if fits {
+			added := 0
+			for _, node := range nodes {
+				if _, exist := zs.ZSetGetScore(node.Value); exist {
+					zs.ZSetUpdate(node.Score, node.Value)
+				} else {
+					zs.ZSetAdd(node.Score, node.Value)
+					added++
+				}
+			}
+			return added
+		}
+		zs.listpackToSkipList()
+	}
+	return zs.skipListAddMany(nodes)
+}
+
+// skipListAddMany中用于排序的键
+type sortKey struct {
+	score float64
+	pos   int
+}
+
+// 跳表编码下的ZSetAddMany
+// 新元素在遍历时直接追加到objs并登记到v2i(同时用于批内去重)，
+// 排序后一次cgo调用加入跳表，空集合上为O(nlogn)的排序加O(n)的构建
+func (zs *ZSet) skipListAddMany(nodes []ZNode) int {
+	if len(zs.v2i) == 0 {
+		zs.v2i = make(map[string]int, len(nodes))
+	}
+	zs.objs = slices.Grow(zs.objs, len(nodes))
+	start := len(zs.objs)
+
+	var updates []ZNode
+	for _, node := range nodes {
+		pos, exist := zs.v2i[node.Value]
+		switch {
+		case !exist:
+			zs.v2i[node.Value] = len(zs.objs)
+			zs.objs = append(zs.objs, node)
+		case pos >= start: // 同一批中重复
+			zs.objs[pos].Score = node.Score
+		default: // 已存在的元素，在新元素加入后再更新
+			updates = append(updates, node)
+		}
+	}
+
+	// 排序键中带上score，score不同时不必访问objs
+	added := len(zs.objs) - start
+	keys := make([]sortKey, added)
+	for i := range keys {
+		keys[i] = sortKey{zs.objs[start+i].Score, start + i}
+	}
+	slices.SortFunc(keys, func(a, b sortKey) int {
+		if a.score != b.score {
+			if a.score < b.score {
+				return -1
+			}
+			return 1
+		}
+		return strings.Compare(zs.objs[a.pos].Value, zs.objs[b.pos].Value)
+	})
+	positions := make([]int, added)
+	for i, key := range keys {
+		positions[i] = key.pos
+	}
+	zs.cAddMany(positions)
+
+	for _, node := range updates {
+		zs.ZSetUpdate(node.Score, node.Value)
+	}
+	return added
+}
+
+// 由按(score, member)有序且member互不相同的元素构建有序集合，编码的选择与逐个ZSetAdd相同
+func newZSetFromSorted(nodes []ZNode) *ZSet {
+	zs := NewZSet()
+	fits := len(nodes) <= ZSetMaxListpackEntries
+	for i := 0; fits && i < len(nodes); i++ {
+		fits = len(nodes[i].Value) <= ZSetMaxListpackValue
+	}
+	if !fits {
+		zs.initSkipList(nodes)
+		return zs
+	}
+	for _, node := range nodes {
+		zs.lp.append(node.Score, node.Value)
+	}
+	return zs
 }
 
 func (zs *ZSet) Len() int {
+	if zs.enc == encListpack {
+		return zs.lp.n
+	}
 	return int(C.ZSetLen(zs.ptr))
 }
 
 // 查找value对应score
 func (zs *ZSet) ZSetGetScore(value string) (float64, bool) {
+	if zs.enc == encListpack {
+		if _, score, ok := zs.lp.find(value); ok {
+			return score, true
+		}
+		return ZSetNotFound, false
+	}
 	index, ok := zs.v2i[value]
 	if !ok {
 		return ZSetNotFound, false
@@ -79,7 +348,11 @@ func (zs *ZSet) ZSetGetScore(value string) (float64, bool) {
 }
 
 // bool返回true表示已存在
+// C++侧以NaN标记空位，score为NaN时不添加，返回(ZSetNotFound, false)；命令层应先拒绝NaN
 func (zs *ZSet) ZSetAdd(score float64, value string) (float64, bool) {
+	if math.IsNaN(score) {
+		return ZSetNotFound, false
+	}
 	s, exist := zs.ZSetGetScore(value)
 	// fmt.Println(s)
 	// 已存在
@@ -90,6 +363,15 @@ func (zs *ZSet) ZSetAdd(score float64, value string) (float64, bool) {
 
 	// 不存在
 
+	// 检查是否需要转换为跳表
+	if zs.enc == encListpack && (zs.lp.n >= ZSetMaxListpackEntries || len(value) > ZSetMaxListpackValue) {
+		zs.listpackToSkipList()
+	}
+	if zs.enc == encListpack {
+		zs.lp.insert(score, value)
+		return score, false
+	}
+
 	length := len(zs.availablePose)
 	if length > 0 {
 		pos := zs.availablePose[length-1]
@@ -106,12 +388,21 @@ func (zs *ZSet) ZSetAdd(score float64, value string) (float64, bool) {
 		// fmt.Println("zs.v2i[", value, "]", "={", pos, "}")
 		zs.objs = append(zs.objs, ZNode{score, value})
 	}
-	C.ZSetAdd(zs.ptr, C.double(score), C.uint(zs.v2i[value]))
+	C.ZSetAdd(zs.ptr, C.double(score), C.uint(zs.v2i[value]), memberPtr(value), C.size_t(len(value)))
 
 	return score, false
 }
 
 func (zs *ZSet) ZSetRemoveValue(value string) int {
+	if zs.enc == encListpack {
+		off, _, ok := zs.lp.find(value)
+		if !ok {
+			return ZSetErr
+		}
+		_, _, next := zs.lp.entry(off)
+		zs.lp.deleteRange(off, next, 1)
+		return ZSetOk
+	}
 
 	// value不存在
 	if _, ok := zs.v2i[value]; !ok {
@@ -119,7 +410,7 @@ func (zs *ZSet) ZSetRemoveValue(value string) int {
 	}
 
 	pos := zs.v2i[value]
-	C.ZSetRemoveValue(zs.ptr, C.uint(zs.v2i[value]))
+	C.ZSetRemoveValue(zs.ptr, C.uint(pos), memberPtr(value), C.size_t(len(value)))
 
 	if pos >= 0 {
 		zs.objs[pos].Score = ZSetNotFound
@@ -132,60 +423,82 @@ func (zs *ZSet) ZSetRemoveValue(value string) int {
 	}
 }
 
+// C侧返回的值数组(malloc分配)，元素为C.uint
+func cIndexes(arrPtr unsafe.Pointer, length int) []C.uint {
+	return (*[1 << 30]C.uint)(arrPtr)[:length:length]
+}
+
+// 回收C侧已删除元素在objs中的位置并释放数组，返回删除的个数
+func (zs *ZSet) releaseRemoved(arrPtr unsafe.Pointer, cLen C.int) int {
+	defer C.free(arrPtr)
+
+	length := int(cLen)
+	for _, cindex := range cIndexes(arrPtr, length) {
+		pos := int(cindex)
+		// 先按Value删除索引再清空
+		delete(zs.v2i, zs.objs[pos].Value)
+		zs.objs[pos].Score = ZSetNotFound
+		zs.objs[pos].Value = ""
+		zs.availablePose = append(zs.availablePose, pos)
+	}
+	return length
+}
+
+// 删除同一score的所有元素
 func (zs *ZSet) ZSetRemoveScore(score float64) int {
+	if zs.enc == encListpack {
+		zs.ZSetRemoveRange(ScoreRange{Min: score, Max: score})
+		return ZSetOk
+	}
 	var cLen C.int
 	// 指针传长度，函数返回值数组
 	arrPtr := C.ZSetRemoveScore(zs.ptr, C.double(score), &cLen)
-	length := int(cLen)
-	slice := (*[1 << 30]int)(unsafe.Pointer(arrPtr))[:length:length]
-	// C.free(arrPtr)
-
-	for pos := range slice {
-		if pos >= 0 {
-			zs.objs[pos].Score = ZSetNotFound
-			zs.objs[pos].Value = ""
-			zs.availablePose = append(zs.availablePose, pos)
-			delete(zs.v2i, zs.objs[pos].Value)
-		} else {
-			// 虽然这样写不能保证原子性
-			return ZSetErr
-		}
-	}
+	zs.releaseRemoved(arrPtr, cLen)
 	return ZSetOk
 }
 
-// 只返回value索引不返回score
-func (zs *ZSet) ZSetSearch(score float64) []int {
+// 删除score区间内的元素(ZREMRANGEBYSCORE)，一次遍历完成，返回删除的个数
+func (zs *ZSet) ZSetRemoveRange(r ScoreRange) int {
+	if zs.enc == encListpack {
+		start, end, n := zs.lp.scoreSpan(r, 0, -1)
+		zs.lp.deleteRange(start, end, n)
+		return n
+	}
 	var cLen C.int
-	// 指针传长度，函数返回值数组
-	arrPtr := C.ZSetSearch(zs.ptr, C.double(score), &cLen)
-	length := int(cLen)
-	slice := (*[1 << 30]int)(unsafe.Pointer(arrPtr))[:length:length]
-	// C.free(arrPtr)
-	return slice
+	arrPtr := C.ZSetRemoveRange(zs.ptr, C.double(r.Min), cBool(r.MinEx),
+		C.double(r.Max), cBool(r.MaxEx), &cLen)
+	return zs.releaseRemoved(arrPtr, cLen)
 }
 
-func (zs *ZSet) ZSetSearchRange(lscore, rscore float64) []ZNode {
-	if lscore > rscore {
-		return []ZNode{}
+// 删除排名区间[lrank, rrank]内的元素(ZREMRANGEBYRANK)，排名从1开始，负数表示倒数第n个
+func (zs *ZSet) ZSetRemoveRankRange(lrank, rrank int) int {
+	if zs.enc == encListpack {
+		start, end, n := zs.lp.rankSpan(lrank, rrank)
+		zs.lp.deleteRange(start, end, n)
+		return n
 	}
-
 	var cLen C.int
-	// 指针传长度，函数返回值数组
-	arrPtr := C.ZSetSearchRange(zs.ptr, C.double(lscore), C.double(rscore), &cLen)
-	defer C.free(arrPtr)
+	arrPtr := C.ZSetRemoveRankRange(zs.ptr, C.int(lrank), C.int(rrank), &cLen)
+	return zs.releaseRemoved(arrPtr, cLen)
+}
 
-	length := int(cLen)
-	Cslice := (*[1 << 30]C.uint)(unsafe.Pointer(arrPtr))[:length:length]
-	var slice []ZNode
-	for _, cindex := range Cslice {
-		index := uint(cindex)
-		slice = append(slice, zs.objs[index])
+// 查找score对应的所有元素
+func (zs *ZSet) ZSetSearch(score float64) []ZNode {
+	return zs.ZSetRangeOpen(ScoreRange{Min: score, Max: score}, 0, -1).Collect()
+}
+
+// 按score区间查找，两端均包含，lscore大于rscore时从大到小返回[rscore, lscore]内的元素
+func (zs *ZSet) ZSetSearchRange(lscore, rscore float64) []ZNode {
+	if lscore > rscore {
+		return zs.ZSetRevRangeOpen(ScoreRange{Min: rscore, Max: lscore}, 0, -1).Collect()
 	}
-	return slice
+	return zs.ZSetRangeOpen(ScoreRange{Min: lscore, Max: rscore}, 0, -1).Collect()
 }
 
 func (zs *ZSet) ZSetUpdate(newscore float64, value string) (float64, error) {
+	if math.IsNaN(newscore) {
+		return ZSetNotFound, errors.New("[zs.ZSetUpdate] score is NaN")
+	}
 	score, exist := zs.ZSetGetScore(value)
 	if !exist {
 		return ZSetNotFound, errors.New("[zs.ZSetUpdate] can't get score, value not found")
@@ -203,25 +516,210 @@ func (zs *ZSet) ZSetUpdate(newscore float64, value string) (float64, error) {
 }
 
 func (zs *ZSet) ZSetSearchRank(rank int) (value string, score float64, err error) {
+	if zs.enc == encListpack {
+		nodes := zs.ZSetRangeOpenRank(rank, rank).Collect()
+		if len(nodes) == 0 {
+			return "", ZSetNotFound, errors.New("[zs.ZSetSearchRank] not found")
+		}
+		return nodes[0].Value, nodes[0].Score, nil
+	}
 	index := int(C.ZSetSearchRank(zs.ptr, C.int(rank)))
 	if index == -1 {
 		return "", ZSetNotFound, errors.New("[zs.ZSetSearchRank] not found")
 	}
-	return value, zs.objs[index].Score, nil
+	return zs.objs[index].Value, zs.objs[index].Score, nil
 }
 
 func (zs *ZSet) ZSetSearchRankRange(lrank, rrank int) []ZNode {
+	return zs.ZSetRangeOpenRank(lrank, rrank).Collect()
+}
+
+// 按字典序范围查找，只有在所有元素score相同时结果才有意义
+func (zs *ZSet) ZSetSearchLexRange(min, max LexBound) []ZNode {
+	return zs.ZSetRangeOpenLex(min, max, 0, -1).Collect()
+}
+
+// score区间内的元素个数，O(logn)
+func (zs *ZSet) ZSetCount(r ScoreRange) int {
+	if zs.enc == encListpack {
+		_, _, n := zs.lp.scoreSpan(r, 0, -1)
+		return n
+	}
+	return int(C.ZSetCount(zs.ptr, C.double(r.Min), cBool(r.MinEx), C.double(r.Max), cBool(r.MaxEx)))
+}
+
+// 字典序范围内的元素个数
+func (zs *ZSet) ZSetLexCount(min, max LexBound) int {
+	if zs.enc == encListpack {
+		_, _, n := zs.lp.lexSpan(min, max, 0, -1)
+		return n
+	}
+	return int(C.ZSetLexCount(zs.ptr,
+		memberPtr(min.Member), C.size_t(len(min.Member)), C.int(min.Flag),
+		memberPtr(max.Member), C.size_t(len(max.Member)), C.int(max.Flag)))
+}
+
+// 删除字典序范围内的元素，返回删除的个数
+func (zs *ZSet) ZSetRemoveLexRange(min, max LexBound) int {
+	if zs.enc == encListpack {
+		start, end, n := zs.lp.lexSpan(min, max, 0, -1)
+		zs.lp.deleteRange(start, end, n)
+		return n
+	}
 	var cLen C.int
-	// 指针传长度，函数返回值数组
-	arrPtr := C.ZSetSearchRankRange(zs.ptr, C.int(lrank), C.int(rrank), &cLen)
-	defer C.free(arrPtr)
+	arrPtr := C.ZSetRemoveLexRange(zs.ptr,
+		memberPtr(min.Member), C.size_t(len(min.Member)), C.int(min.Flag),
+		memberPtr(max.Member), C.size_t(len(max.Member)), C.int(max.Flag), &cLen)
+	return zs.releaseRemoved(arrPtr, cLen)
+}
 
-	length := int(cLen)
-	Cslice := (*[1 << 30]C.uint)(unsafe.Pointer(arrPtr))[:length:length]
-	var slice []ZNode
-	for _, cindex := range Cslice {
-		index := uint(cindex)
-		slice = append(slice, zs.objs[index])
+// ZSetRangeIter 范围查询游标
+// 沿跳表第一层(反向时沿backward指针)按批读取，结果直接写入调用方提供的缓冲区，
+// LIMIT在C++侧完成；游标关闭前不能修改zset
+type ZSetRangeIter struct {
+	zs  *ZSet
+	ptr unsafe.Pointer
+	idx []C.uint // 每批的值，按调用方缓冲区大小复用
+
+	// listpack编码时为剩余区间的起止偏移
+	lp       *listpack
+	off, end int
+	// listpack编码反向遍历时为剩余元素的偏移(已按从大到小排列)，元素不多，直接展开
+	revOffs []int
+}
+
+func (zs *ZSet) newRangeIter(ptr unsafe.Pointer) *ZSetRangeIter {
+	return &ZSetRangeIter{zs: zs, ptr: ptr}
+}
+
+func (zs *ZSet) newListpackIter(start, end int) *ZSetRangeIter {
+	return &ZSetRangeIter{zs: zs, lp: &zs.lp, off: start, end: end}
+}
+
+// listpack上[start, end)内的元素从大到小遍历，先跳过offset个，最多返回count个
+func (zs *ZSet) newListpackRevIter(start, end, offset, count int) *ZSetRangeIter {
+	var offs []int
+	for off := start; off < end; {
+		offs = append(offs, off)
+		_, _, off = zs.lp.entry(off)
+	}
+	slices.Reverse(offs)
+	if offset < 0 || offset > len(offs) {
+		offset = len(offs)
+	}
+	offs = offs[offset:]
+	if count >= 0 && count < len(offs) {
+		offs = offs[:count]
+	}
+	return &ZSetRangeIter{zs: zs, lp: &zs.lp, revOffs: offs}
+}
+
+// 按score区间遍历，跳过offset个元素后最多返回count个(count为负数表示不限)
+func (zs *ZSet) ZSetRangeOpen(r ScoreRange, offset, count int) *ZSetRangeIter {
+	if zs.enc == encListpack {
+		start, end, _ := zs.lp.scoreSpan(r, offset, count)
+		return zs.newListpackIter(start, end)
+	}
+	return zs.newRangeIter(C.ZSetRangeOpen(zs.ptr, C.double(r.Min), cBool(r.MinEx),
+		C.double(r.Max), cBool(r.MaxEx), C.long(offset), C.long(count), 0))
+}
+
+// 按score区间从大到小遍历(ZREVRANGEBYSCORE)，offset从区间的最大端算起，count含义同ZSetRangeOpen
+// 跳表从区间的最后一个元素沿backward指针遍历，只访问返回的元素
+func (zs *ZSet) ZSetRevRangeOpen(r ScoreRange, offset, count int) *ZSetRangeIter {
+	if zs.enc == encListpack {
+		start, end, _ := zs.lp.scoreSpan(r, 0, -1)
+		return zs.newListpackRevIter(start, end, offset, count)
+	}
+	return zs.newRangeIter(C.ZSetRangeOpen(zs.ptr, C.double(r.Min), cBool(r.MinEx),
+		C.double(r.Max), cBool(r.MaxEx), C.long(offset), C.long(count), 1))
+}
+
+// 按排名区间[lrank, rrank]遍历，排名从1开始，负数表示倒数第n个
+func (zs *ZSet) ZSetRangeOpenRank(lrank, rrank int) *ZSetRangeIter {
+	if zs.enc == encListpack {
+		start, end, _ := zs.lp.rankSpan(lrank, rrank)
+		return zs.newListpackIter(start, end)
+	}
+	return zs.newRangeIter(C.ZSetRangeOpenRank(zs.ptr, C.int(lrank), C.int(rrank), 0))
+}
+
+// 按倒数排名区间[lrank, rrank]从大到小遍历(ZREVRANGE)，排名1为score最大的元素，
+// 负数表示正数第n个；取前N名只访问N个元素
+func (zs *ZSet) ZSetRevRangeOpenRank(lrank, rrank int) *ZSetRangeIter {
+	if zs.enc == encListpack {
+		lrank, rrank, ok := normalizeRankRange(lrank, rrank, zs.lp.n)
+		if !ok {
+			return zs.newListpackIter(0, 0)
+		}
+		start, end, _ := zs.lp.rankSpan(zs.lp.n-rrank+1, zs.lp.n-lrank+1)
+		return zs.newListpackRevIter(start, end, 0, -1)
+	}
+	return zs.newRangeIter(C.ZSetRangeOpenRank(zs.ptr, C.int(lrank), C.int(rrank), 1))
+}
+
+// 按字典序区间遍历，offset/count含义同ZSetRangeOpen
+func (zs *ZSet) ZSetRangeOpenLex(min, max LexBound, offset, count int) *ZSetRangeIter {
+	if zs.enc == encListpack {
+		start, end, _ := zs.lp.lexSpan(min, max, offset, count)
+		return zs.newListpackIter(start, end)
+	}
+	return zs.newRangeIter(C.ZSetRangeOpenLex(zs.ptr,
+		memberPtr(min.Member), C.size_t(len(min.Member)), C.int(min.Flag),
+		memberPtr(max.Member), C.size_t(len(max.Member)), C.int(max.Flag),
+		C.long(offset), C.long(count)))
+}
+
+// 读取下一批元素写入buf，返回写入的数量，为0表示遍历结束
+func (it *ZSetRangeIter) Next(buf []ZNode) int {
+	if it.lp != nil && it.revOffs != nil {
+		n := 0
+		for ; n < len(buf) && len(it.revOffs) > 0; n++ {
+			score, member, _ := it.lp.entry(it.revOffs[0])
+			buf[n] = ZNode{score, string(member)}
+			it.revOffs = it.revOffs[1:]
+		}
+		return n
+	}
+	if it.lp != nil {
+		n := 0
+		for ; n < len(buf) && it.off < it.end; n++ {
+			score, member, next := it.lp.entry(it.off)
+			buf[n] = ZNode{score, string(member)}
+			it.off = next
+		}
+		return n
+	}
+	if it.ptr == nil || len(buf) == 0 {
+		return 0
+	}
+	if cap(it.idx) < len(buf) {
+		it.idx = make([]C.uint, len(buf))
+	}
+	n := int(C.ZSetRangeNext(it.ptr, &it.idx[0], C.int(len(buf))))
+	for i := 0; i < n; i++ {
+		buf[i] = it.zs.objs[it.idx[i]]
+	}
+	return n
+}
+
+// 释放游标，可重复调用
+func (it *ZSetRangeIter) Close() {
+	it.lp = nil
+	it.revOffs = nil
+	if it.ptr != nil {
+		C.ZSetRangeClose(it.ptr)
+		it.ptr = nil
+	}
+}
+
+// 读取剩余的全部元素并关闭游标
+func (it *ZSetRangeIter) Collect() []ZNode {
+	defer it.Close()
+	var buf [64]ZNode
+	var result []ZNode
+	for n := it.Next(buf[:]); n > 0; n = it.Next(buf[:]) {
+		result = append(result, buf[:n]...)
 	}
-	return slice
+	return result
 }
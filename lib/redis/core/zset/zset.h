@@ -1,3 +1,4 @@
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 typedef uint32_t ZSetType;
@@ -9,7 +10,16 @@ struct ZNode {
     double score;
 };
 
-void* NewZSet();
+// 字典序区间端点的类型，对应"[member"、"(member"、"-"、"+"
+enum ZSetLexFlag {
+    ZSetLexInclusive = 0,
+    ZSetLexExclusive = 1,
+    ZSetLexNegInf = 2,
+    ZSetLexPosInf = 3,
+};
+
+// seed为跳表层数随机数的种子，为0时随机选取
+void* NewZSet(uint64_t seed);
 
 int ReleaseZSet(void* zs);
 
@@ -17,19 +27,60 @@ int ZSetLen(void* zs);
 
 double ZSetGetScore(void* zs, ZSetType value);
 
-double ZSetAdd(void* zs, double score, ZSetType value);
+// member为元素的字节，跳表按(score, member)排序
+double ZSetAdd(void* zs, double score, ZSetType value, const char* member,
+               size_t len);
 
+// 一次添加n个元素，members为所有member首尾相接的字节，lens[i]为第i个member的长度
+// 由调用方保证各元素不存在；输入按(score, member)有序时效率最高
+void ZSetAddMany(void* zs, const double* scores, const ZSetType* values,
+                 const char* members, const uint32_t* lens, int n);
+
+// 以下删除/查找函数返回被删除(查找到)元素的值，数组由malloc分配，需由调用方free
 void* ZSetRemoveScore(void* zs, double score, int* length);
 
-double ZSetRemoveValue(void* zs, ZSetType value);
+// 删除score区间内的元素，minex/maxex表示开区间
+void* ZSetRemoveRange(void* zs, double min, int minex, double max, int maxex,
+                      int* length);
+
+// 删除排名区间[lrank, rrank]内的元素，排名从1开始，负数表示倒数第n个
+void* ZSetRemoveRankRange(void* zs, int lrank, int rrank, int* length);
+
+double ZSetRemoveValue(void* zs, ZSetType value, const char* member,
+                       size_t len);
 
 void* ZSetSearch(void* zs, double score, int* length);
 
-void* ZSetSearchRange(void* zs, double lscore, double rscore, int* length);
 
 ZSetType ZSetSearchRank(void* zs, int rank);
 
-void* ZSetSearchRankRange(void* zs, int lrank, int rrank, int* length);
+// 范围查询游标，用ZSetRangeNext按批读取，用完后ZSetRangeClose
+// 游标存续期间不能修改zset
+// offset/count对应LIMIT，count为负数表示不限
+// reverse非0时从大到小遍历(ZREVRANGE/ZREVRANGEBYSCORE)，offset从区间的最大端算起
+// score区间，minex/maxex表示开区间
+void* ZSetRangeOpen(void* zs, double min, int minex, double max, int maxex,
+                    long offset, long count, int reverse);
+// 排名区间[lrank, rrank]，从1开始，负数表示倒数第n个；reverse非0时排名从score最大端数起
+void* ZSetRangeOpenRank(void* zs, int lrank, int rrank, int reverse);
+// 字典序区间
+void* ZSetRangeOpenLex(void* zs, const char* min, size_t minlen, int minflag,
+                       const char* max, size_t maxlen, int maxflag,
+                       long offset, long count);
+// 向values写入至多n个值，返回实际数量，为0表示结束
+int ZSetRangeNext(void* it, ZSetType* values, int n);
+void ZSetRangeClose(void* it);
+
+// score区间内的元素个数
+int ZSetCount(void* zs, double min, int minex, double max, int maxex);
+
+int ZSetLexCount(void* zs, const char* min, size_t minlen, int minflag,
+                 const char* max, size_t maxlen, int maxflag);
+
+// 删除字典序区间内的元素，返回被删除元素的值，需由调用方free
+void* ZSetRemoveLexRange(void* zs, const char* min, size_t minlen, int minflag,
+                         const char* max, size_t maxlen, int maxflag,
+                         int* length);
 
 double ZSetNotFoundSign();
 double ZSetSuccessSign();
\ No newline at end of file
@@ -3,6 +3,11 @@ package zset
 import (
 	"fmt"
 	"math"
+	"math/rand"
+	"redis-go/lib/redis/core/internal/memstat"
+	"runtime"
+	"slices"
+	"sort"
 	"testing"
 	"time"
 )
@@ -57,7 +62,7 @@ func TestZSet(t *testing.T) {
 
 	// 再次获取分数确认元素已被删除
 	gotScore, exist = z.ZSetGetScore("element1")
-	if !exist || !floatEquals(gotScore, ZSetNotFound) {
+	if exist || !floatEquals(gotScore, ZSetNotFound) {
 		t.Errorf("Expected score to be not found, got %f", gotScore)
 	} else {
 		t.Logf("ZSetGetScore Successfully")
@@ -83,6 +88,28 @@ func TestZSet_RemoveNonExistent(t *testing.T) {
 	}
 }
 
+// C++侧以NaN标记空位，NaN的score不能被存入，否则元素看起来不存在且节点无法删除
+func TestZSet_RejectNaN(t *testing.T) {
+	forEachEncoding(t, func(t *testing.T) {
+		z := NewZSet()
+		z.ZSetAdd(math.NaN(), "x")
+		z.ZSetAddMany([]ZNode{{math.NaN(), "z"}, {5, "w"}})
+		if z.Len() != 1 {
+			t.Fatalf("Len() = %d after adding NaN scores, want 1", z.Len())
+		}
+		if _, err := z.ZSetUpdate(math.NaN(), "w"); err == nil {
+			t.Fatalf("ZSetUpdate(NaN) succeeded")
+		}
+
+		z.ZSetAdd(10, "y")
+		got := z.ZSetRangeOpen(ScoreRange{Min: math.Inf(-1), Max: math.Inf(1)}, 0, -1).Collect()
+		want := []ZNode{{5, "w"}, {10, "y"}}
+		if !slices.Equal(got, want) {
+			t.Fatalf("range = %v, want %v", got, want)
+		}
+	})
+}
+
 // func TestZSet_ConcurrentAccess(t *testing.T) {
 // 	z := NewZSet()
 // 	wg := sync.WaitGroup{}
@@ -108,6 +135,579 @@ func TestZSet_RemoveNonExistent(t *testing.T) {
 // 	wg.Wait()
 // }
 
+// 分别以listpack和跳表编码运行f，listpack编码下不限制元素个数
+func forEachEncoding(t *testing.T, f func(t *testing.T)) {
+	run := func(name string, maxEntries int) {
+		t.Run(name, func(t *testing.T) {
+			old := ZSetMaxListpackEntries
+			ZSetMaxListpackEntries = maxEntries
+			defer func() { ZSetMaxListpackEntries = old }()
+			f(t)
+		})
+	}
+	run("listpack", math.MaxInt)
+	run("skiplist", 0)
+}
+
+// 同score的元素按member的字节序排列，排名与redis一致
+func TestZSet_TiedScoreOrder(t *testing.T) {
+	forEachEncoding(t, func(t *testing.T) {
+		z := NewZSet()
+		members := []string{"d", "b", "a", "c", "ab", ""}
+		for _, m := range members {
+			z.ZSetAdd(0, m)
+		}
+		z.ZSetAdd(-1, "z")
+		z.ZSetAdd(1, "0")
+
+		expected := []string{"z", "", "a", "ab", "b", "c", "d", "0"}
+		got := z.ZSetSearchRankRange(1, -1)
+		if len(got) != len(expected) {
+			t.Fatalf("Expected %d members, got %d", len(expected), len(got))
+		}
+		for i, node := range got {
+			if node.Value != expected[i] {
+				t.Errorf("Rank %d: expected %q, got %q", i+1, expected[i], node.Value)
+			}
+		}
+
+		// 删除中间的元素后顺序与排名保持正确
+		z.ZSetRemoveValue("ab")
+		z.ZSetUpdate(0, "0")
+		expected = []string{"z", "", "0", "a", "b", "c", "d"}
+		got = z.ZSetSearchRankRange(-100, 100)
+		for i, node := range got {
+			if node.Value != expected[i] {
+				t.Errorf("Rank %d: expected %q, got %q", i+1, expected[i], node.Value)
+			}
+		}
+		if sub := z.ZSetSearchRankRange(2, 3); len(sub) != 2 || sub[0].Value != "" || sub[1].Value != "0" {
+			t.Errorf("Unexpected rank range 2..3: %v", sub)
+		}
+	})
+}
+
+func TestZSet_LexRange(t *testing.T) {
+	forEachEncoding(t, func(t *testing.T) {
+		z := NewZSet()
+		for _, m := range []string{"a", "b", "c", "d", "e", "f", "g"} {
+			z.ZSetAdd(0, m)
+		}
+
+		cases := []struct {
+			min, max LexBound
+			expected string
+		}{
+			{LexBound{"", LexNegInf}, LexBound{"", LexPosInf}, "abcdefg"},
+			{LexBound{"", LexNegInf}, LexBound{"c", LexInclusive}, "abc"},
+			{LexBound{"", LexNegInf}, LexBound{"c", LexExclusive}, "ab"},
+			{LexBound{"aaa", LexInclusive}, LexBound{"g", LexExclusive}, "bcdef"},
+			{LexBound{"c", LexExclusive}, LexBound{"", LexPosInf}, "defg"},
+			{LexBound{"c", LexInclusive}, LexBound{"c", LexInclusive}, "c"},
+			{LexBound{"c", LexExclusive}, LexBound{"c", LexInclusive}, ""},
+			{LexBound{"e", LexInclusive}, LexBound{"b", LexInclusive}, ""},
+			{LexBound{"", LexPosInf}, LexBound{"", LexNegInf}, ""},
+			{LexBound{"x", LexInclusive}, LexBound{"", LexPosInf}, ""},
+		}
+		for _, c := range cases {
+			got := ""
+			for _, node := range z.ZSetSearchLexRange(c.min, c.max) {
+				got += node.Value
+			}
+			if got != c.expected {
+				t.Errorf("ZSetSearchLexRange(%v, %v): expected %q, got %q", c.min, c.max, c.expected, got)
+			}
+			if n := z.ZSetLexCount(c.min, c.max); n != len(c.expected) {
+				t.Errorf("ZSetLexCount(%v, %v): expected %d, got %d", c.min, c.max, len(c.expected), n)
+			}
+		}
+
+		// 删除区间内的元素
+		removed := z.ZSetRemoveLexRange(LexBound{"b", LexInclusive}, LexBound{"d", LexExclusive})
+		if removed != 2 || z.Len() != 5 {
+			t.Fatalf("Expected to remove 2 members leaving 5, removed %d, len %d", removed, z.Len())
+		}
+		for _, m := range []string{"b", "c"} {
+			if _, exist := z.ZSetGetScore(m); exist {
+				t.Errorf("Expected %q to be removed", m)
+			}
+		}
+		// 被删除元素的位置可以复用
+		z.ZSetAdd(0, "bb")
+		got := ""
+		for _, node := range z.ZSetSearchRankRange(1, -1) {
+			got += node.Value
+		}
+		if got != "abbdefg" {
+			t.Errorf("Expected abbdefg after re-adding, got %q", got)
+		}
+	})
+}
+
+// 随机增删后与排序的参照结果比较，检查顺序与span
+func TestZSet_RandomOrder(t *testing.T) {
+	forEachEncoding(t, func(t *testing.T) {
+		z := NewZSet()
+		rnd := rand.New(rand.NewSource(1))
+		ref := map[string]float64{}
+		for i := 0; i < 20000; i++ {
+			m := fmt.Sprintf("m%d", rnd.Intn(3000))
+			if _, ok := ref[m]; ok && rnd.Intn(2) == 0 {
+				z.ZSetRemoveValue(m)
+				delete(ref, m)
+			} else if !ok {
+				score := float64(rnd.Intn(20))
+				z.ZSetAdd(score, m)
+				ref[m] = score
+			}
+		}
+
+		expected := make([]ZNode, 0, len(ref))
+		for m, score := range ref {
+			expected = append(expected, ZNode{score, m})
+		}
+		sort.Slice(expected, func(i, j int) bool {
+			if expected[i].Score != expected[j].Score {
+				return expected[i].Score < expected[j].Score
+			}
+			return expected[i].Value < expected[j].Value
+		})
+
+		if z.Len() != len(expected) {
+			t.Fatalf("Expected len %d, got %d", len(expected), z.Len())
+		}
+		for i := 0; i < 200; i++ {
+			l := rnd.Intn(len(expected)) + 1
+			r := l + rnd.Intn(50)
+			got := z.ZSetSearchRankRange(l, r)
+			if r > len(expected) {
+				r = len(expected)
+			}
+			want := expected[l-1 : r]
+			if len(got) != len(want) {
+				t.Fatalf("Rank range %d..%d: expected %d members, got %d", l, r, len(want), len(got))
+			}
+			for j := range want {
+				if got[j] != want[j] {
+					t.Fatalf("Rank %d: expected %v, got %v", l+j, want[j], got[j])
+				}
+			}
+		}
+	})
+}
+
+func TestZSet_RangeIter(t *testing.T) {
+	forEachEncoding(t, func(t *testing.T) {
+		z := NewZSet()
+		for i := 0; i < 100; i++ {
+			z.ZSetAdd(float64(i), fmt.Sprintf("m%02d", i))
+		}
+
+		values := func(nodes []ZNode) string {
+			s := ""
+			for _, n := range nodes {
+				s += n.Value[1:] + ","
+			}
+			return s
+		}
+
+		cases := []struct {
+			r             ScoreRange
+			offset, count int
+			expected      string
+		}{
+			{ScoreRange{Min: 10, Max: 13}, 0, -1, "10,11,12,13,"},
+			{ScoreRange{Min: 10, Max: 13, MinEx: true}, 0, -1, "11,12,13,"},
+			{ScoreRange{Min: 10, Max: 13, MaxEx: true}, 0, -1, "10,11,12,"},
+			{ScoreRange{Min: 10, Max: 10, MaxEx: true}, 0, -1, ""},
+			{ScoreRange{Min: 13, Max: 10}, 0, -1, ""},
+			{ScoreRange{Min: math.Inf(-1), Max: 2}, 0, -1, "00,01,02,"},
+			{ScoreRange{Min: 97.5, Max: math.Inf(1)}, 0, -1, "98,99,"},
+			{ScoreRange{Min: 10, Max: 20}, 3, 2, "13,14,"},
+			{ScoreRange{Min: 10, Max: 20}, 9, 5, "19,20,"},
+			{ScoreRange{Min: 10, Max: 20}, 11, 5, ""},
+			{ScoreRange{Min: 10, Max: 20}, 0, 0, ""},
+			{ScoreRange{Min: 95, Max: 200}, 10, -1, ""},
+			{ScoreRange{Min: 10, Max: 20}, -1, 5, ""},
+		}
+		for _, c := range cases {
+			got := values(z.ZSetRangeOpen(c.r, c.offset, c.count).Collect())
+			if got != c.expected {
+				t.Errorf("ZSetRangeOpen(%v, %d, %d): expected %q, got %q", c.r, c.offset, c.count, c.expected, got)
+			}
+			if c.offset == 0 && c.count < 0 && z.ZSetCount(c.r) != len(got)/3 {
+				t.Errorf("ZSetCount(%v): expected %d, got %d", c.r, len(got)/3, z.ZSetCount(c.r))
+			}
+		}
+
+		// 小缓冲区分批读取
+		it := z.ZSetRangeOpen(ScoreRange{Min: 0, Max: 99}, 5, 50)
+		buf := make([]ZNode, 7)
+		total := 0
+		for n := it.Next(buf); n > 0; n = it.Next(buf) {
+			for i := 0; i < n; i++ {
+				if buf[i].Score != float64(5+total+i) {
+					t.Fatalf("Batch element %d: expected score %d, got %f", total+i, 5+total+i, buf[i].Score)
+				}
+			}
+			total += n
+		}
+		it.Close()
+		it.Close()
+		if total != 50 {
+			t.Errorf("Expected 50 members in batches, got %d", total)
+		}
+
+		// 字典序区间的LIMIT
+		lex := z.ZSetRangeOpenLex(LexBound{"m50", LexInclusive}, LexBound{"", LexPosInf}, 10, 3).Collect()
+		if got := values(lex); got != "60,61,62," {
+			t.Errorf("Expected lex range 60,61,62, got %q", got)
+		}
+	})
+}
+
+func TestZSet_RevRange(t *testing.T) {
+	forEachEncoding(t, func(t *testing.T) {
+		z := NewZSet()
+		rnd := rand.New(rand.NewSource(6))
+		for i := 0; i < 100; i++ {
+			// score有重复，同score按member倒序
+			z.ZSetAdd(float64(rnd.Intn(30)), fmt.Sprintf("m%02d", i))
+		}
+
+		reversed := func(nodes []ZNode) []ZNode {
+			nodes = slices.Clone(nodes)
+			slices.Reverse(nodes)
+			return nodes
+		}
+		window := func(nodes []ZNode, offset, count int) []ZNode {
+			if offset < 0 || offset > len(nodes) {
+				return nil
+			}
+			nodes = nodes[offset:]
+			if count >= 0 && count < len(nodes) {
+				nodes = nodes[:count]
+			}
+			return nodes
+		}
+
+		for i := 0; i < 200; i++ {
+			r := ScoreRange{Min: float64(rnd.Intn(35) - 2), Max: float64(rnd.Intn(35) - 2),
+				MinEx: rnd.Intn(2) == 0, MaxEx: rnd.Intn(2) == 0}
+			offset, count := rnd.Intn(30)-1, rnd.Intn(30)-1
+			expected := window(reversed(z.ZSetRangeOpen(r, 0, -1).Collect()), offset, count)
+			got := z.ZSetRevRangeOpen(r, offset, count).Collect()
+			if len(got) != len(expected) || (len(got) > 0 && !slices.Equal(got, expected)) {
+				t.Fatalf("ZSetRevRangeOpen(%v, %d, %d): expected %v, got %v", r, offset, count, expected, got)
+			}
+
+			// 倒数排名k对应正向排名-k
+			lrank, rrank := rnd.Intn(220)-110, rnd.Intn(220)-110
+			if lrank == 0 || rrank == 0 {
+				continue
+			}
+			expected = reversed(z.ZSetRangeOpenRank(-rrank, -lrank).Collect())
+			got = z.ZSetRevRangeOpenRank(lrank, rrank).Collect()
+			if len(got) != len(expected) || (len(got) > 0 && !slices.Equal(got, expected)) {
+				t.Fatalf("ZSetRevRangeOpenRank(%d, %d): expected %v, got %v", lrank, rrank, expected, got)
+			}
+		}
+
+		// 前N名，分批读取
+		all := reversed(z.ZSetRangeOpenRank(1, -1).Collect())
+		it := z.ZSetRevRangeOpenRank(1, 10)
+		buf := make([]ZNode, 3)
+		var top []ZNode
+		for n := it.Next(buf); n > 0; n = it.Next(buf) {
+			top = append(top, buf[:n]...)
+		}
+		it.Close()
+		if !slices.Equal(top, all[:10]) {
+			t.Errorf("Top 10: expected %v, got %v", all[:10], top)
+		}
+
+		// l大于r时从大到小返回
+		if got, expected := z.ZSetSearchRange(20, 10), reversed(z.ZSetSearchRange(10, 20)); !slices.Equal(got, expected) {
+			t.Errorf("ZSetSearchRange(20, 10): expected %v, got %v", expected, got)
+		}
+	})
+}
+
+func TestZSet_RemoveRange(t *testing.T) {
+	forEachEncoding(t, func(t *testing.T) {
+		newSet := func() *ZSet {
+			z := NewZSet()
+			for i := 0; i < 20; i++ {
+				z.ZSetAdd(float64(i/2), fmt.Sprintf("m%02d", i))
+			}
+			return z
+		}
+		// 剩余成员应与哈希表一致，且被删除的位置可以复用
+		check := func(z *ZSet, removed map[string]bool) {
+			t.Helper()
+			if z.Len() != 20-len(removed) {
+				t.Fatalf("Expected len %d, got %d", 20-len(removed), z.Len())
+			}
+			if z.enc == encListpack {
+				return
+			}
+			if z.Len() != len(z.v2i) {
+				t.Fatalf("Expected map len %d, got %d", z.Len(), len(z.v2i))
+			}
+			for i := 0; i < 20; i++ {
+				m := fmt.Sprintf("m%02d", i)
+				_, ok := z.ZSetGetScore(m)
+				if ok == removed[m] {
+					t.Fatalf("Member %s: expected removed=%v", m, removed[m])
+				}
+			}
+			if len(z.availablePose) != len(removed) {
+				t.Fatalf("Expected %d reusable slots, got %d", len(removed), len(z.availablePose))
+			}
+		}
+		members := func(from, to int) map[string]bool {
+			res := map[string]bool{}
+			for i := from; i <= to; i++ {
+				res[fmt.Sprintf("m%02d", i)] = true
+			}
+			return res
+		}
+
+		z := newSet()
+		if n := z.ZSetRemoveRange(ScoreRange{Min: 2, Max: 4, MaxEx: true}); n != 4 {
+			t.Errorf("ZSetRemoveRange: expected 4 removed, got %d", n)
+		}
+		check(z, members(4, 7))
+		if n := z.ZSetRemoveRange(ScoreRange{Min: 5, Max: 3}); n != 0 {
+			t.Errorf("ZSetRemoveRange on empty range: expected 0, got %d", n)
+		}
+
+		z = newSet()
+		if n := z.ZSetRemoveRankRange(-3, -1); n != 3 {
+			t.Errorf("ZSetRemoveRankRange(-3, -1): expected 3 removed, got %d", n)
+		}
+		check(z, members(17, 19))
+		if n := z.ZSetRemoveRankRange(1, 2); n != 2 {
+			t.Errorf("ZSetRemoveRankRange(1, 2): expected 2 removed, got %d", n)
+		}
+		removed := members(17, 19)
+		removed["m00"], removed["m01"] = true, true
+		check(z, removed)
+		if n := z.ZSetRemoveRankRange(20, 30); n != 0 {
+			t.Errorf("ZSetRemoveRankRange out of range: expected 0, got %d", n)
+		}
+		// 删除后排名连续
+		if got := z.ZSetSearchRankRange(1, 1); len(got) != 1 || got[0].Value != "m02" {
+			t.Errorf("Expected m02 ranked first, got %v", got)
+		}
+
+		z = newSet()
+		if got := z.ZSetSearch(3); len(got) != 2 {
+			t.Errorf("ZSetSearch(3): expected 2 values, got %v", got)
+		}
+		z.ZSetRemoveScore(3)
+		check(z, members(6, 7))
+		if got := z.ZSetSearch(3); len(got) != 0 {
+			t.Errorf("ZSetSearch(3) after remove: expected none, got %v", got)
+		}
+		z.ZSetAdd(100, "new")
+		if z.enc == encSkipList && z.v2i["new"] != 7 && z.v2i["new"] != 6 {
+			t.Errorf("Expected new member to reuse a removed slot, got %d", z.v2i["new"])
+		}
+	})
+}
+
+// 超过元素个数或member长度的阈值时自动转换为跳表，转换前后内容一致
+func TestZSet_Encoding(t *testing.T) {
+	z := NewZSet()
+	for i := 0; i < ZSetMaxListpackEntries; i++ {
+		z.ZSetAdd(float64(i%10), fmt.Sprintf("m%03d", i))
+	}
+	if z.enc != encListpack || z.ptr != nil {
+		t.Fatalf("Expected listpack encoding with %d members", z.Len())
+	}
+	before := z.ZSetSearchRankRange(1, -1)
+
+	z.ZSetAdd(-1, "first")
+	if z.enc != encSkipList {
+		t.Fatalf("Expected skiplist encoding after %d members", z.Len())
+	}
+	after := z.ZSetSearchRankRange(1, -1)
+	if len(after) != len(before)+1 || after[0].Value != "first" {
+		t.Fatalf("Unexpected members after conversion: %d, first %v", len(after), after[0])
+	}
+	for i := range before {
+		if after[i+1] != before[i] {
+			t.Fatalf("Rank %d: expected %v, got %v", i+2, before[i], after[i+1])
+		}
+	}
+	if score, ok := z.ZSetGetScore("m005"); !ok || score != 5 {
+		t.Errorf("Expected m005 with score 5, got %f %v", score, ok)
+	}
+
+	// 过长的member
+	z = NewZSet()
+	z.ZSetAdd(1, "short")
+	z.ZSetAdd(2, string(make([]byte, ZSetMaxListpackValue+1)))
+	if z.enc != encSkipList || z.Len() != 2 {
+		t.Errorf("Expected skiplist encoding for long member, len %d", z.Len())
+	}
+}
+
+// 并集、交集、差集与按map计算的参照结果比较
+func TestZSet_Aggregate(t *testing.T) {
+	rnd := rand.New(rand.NewSource(5))
+	// 三个集合，大小跨越listpack阈值；member有重叠，score含inf
+	sizes := []int{50, 300, 2000}
+	sets := make([]*ZSet, len(sizes))
+	refs := make([]map[string]float64, len(sizes))
+	for i, n := range sizes {
+		sets[i], refs[i] = NewZSet(), map[string]float64{}
+		for len(refs[i]) < n {
+			m := fmt.Sprintf("m%d", rnd.Intn(3000))
+			score := float64(rnd.Intn(100) - 50)
+			if rnd.Intn(100) == 0 {
+				score = math.Inf(1)
+			}
+			if _, ok := refs[i][m]; !ok {
+				sets[i].ZSetAdd(score, m)
+				refs[i][m] = score
+			}
+		}
+	}
+	weights := []float64{2, -1, 0.5}
+
+	check := func(name string, got *ZSet, want map[string]float64) {
+		t.Helper()
+		expected := make([]ZNode, 0, len(want))
+		for m, score := range want {
+			expected = append(expected, ZNode{score, m})
+		}
+		sort.Slice(expected, func(i, j int) bool {
+			if expected[i].Score != expected[j].Score {
+				return expected[i].Score < expected[j].Score
+			}
+			return expected[i].Value < expected[j].Value
+		})
+		nodes := got.ZSetSearchRankRange(1, -1)
+		if got.Len() != len(expected) || len(nodes) != len(expected) {
+			t.Fatalf("%s: expected %d members, got %d", name, len(expected), got.Len())
+		}
+		for i := range expected {
+			if nodes[i] != expected[i] {
+				t.Fatalf("%s: rank %d expected %v, got %v", name, i+1, expected[i], nodes[i])
+			}
+		}
+		if wantEnc := len(expected) > ZSetMaxListpackEntries; (got.enc == encSkipList) != wantEnc {
+			t.Errorf("%s: unexpected encoding %d for %d members", name, got.enc, len(expected))
+		}
+	}
+
+	for _, agg := range []int{AggregateSum, AggregateMin, AggregateMax} {
+		union, inter := map[string]float64{}, map[string]float64{}
+		for i, ref := range refs {
+			for m, score := range ref {
+				score = weightedScore(score, weights[i])
+				if old, ok := union[m]; ok {
+					score = aggregateScore(agg, old, score)
+				}
+				union[m] = score
+			}
+		}
+		for m := range union {
+			_, ok1 := refs[1][m]
+			_, ok2 := refs[2][m]
+			if _, ok0 := refs[0][m]; ok0 && ok1 && ok2 {
+				inter[m] = union[m]
+			}
+		}
+		check(fmt.Sprintf("union/%d", agg), ZSetUnion(sets, weights, agg), union)
+		check(fmt.Sprintf("inter/%d", agg), ZSetInter(sets, weights, agg), inter)
+	}
+
+	diff := map[string]float64{}
+	for m, score := range refs[2] {
+		if _, ok := refs[0][m]; !ok {
+			diff[m] = score
+		}
+	}
+	check("diff", ZSetDiff([]*ZSet{sets[2], nil, sets[0]}), diff)
+
+	// 不存在的key按空集处理
+	check("union with nil", ZSetUnion([]*ZSet{nil, sets[0]}, nil, AggregateSum), refs[0])
+	check("inter with nil", ZSetInter([]*ZSet{sets[0], nil}, nil, AggregateSum), map[string]float64{})
+	check("diff of nil", ZSetDiff([]*ZSet{nil, sets[0]}), map[string]float64{})
+}
+
+// 批量添加：空集合上按序构建、非空集合上按序追加或逐个插入，结果与参照一致
+func TestZSet_AddMany(t *testing.T) {
+	forEachEncoding(t, func(t *testing.T) {
+		z := NewZSet()
+		rnd := rand.New(rand.NewSource(7))
+		ref := map[string]float64{}
+		addMany := func(nodes []ZNode) {
+			t.Helper()
+			fresh := map[string]bool{}
+			for _, node := range nodes {
+				if _, ok := ref[node.Value]; !ok {
+					fresh[node.Value] = true
+				}
+			}
+			for _, node := range nodes {
+				ref[node.Value] = node.Score
+			}
+			if n := z.ZSetAddMany(nodes); n != len(fresh) {
+				t.Fatalf("ZSetAddMany: expected %d added, got %d", len(fresh), n)
+			}
+			for m, score := range ref {
+				if got, ok := z.ZSetGetScore(m); !ok || got != score {
+					t.Fatalf("Member %s: expected score %f, got %f", m, score, got)
+				}
+			}
+		}
+		randomNodes := func(n, ids int, base float64) []ZNode {
+			nodes := make([]ZNode, n)
+			for i := range nodes {
+				nodes[i] = ZNode{base + float64(rnd.Intn(50)), fmt.Sprintf("m%d", rnd.Intn(ids))}
+			}
+			return nodes
+		}
+
+		addMany(randomNodes(3000, 2500, 0))   // 空集合，含重复member
+		addMany(randomNodes(500, 4000, 0))    // 与现有元素交错，含更新
+		addMany(randomNodes(500, 1000, 1000)) // score均大于现有元素
+		z.ZSetRemoveRankRange(100, 199)
+		z.ZSetAdd(25.5, "extra")
+
+		expected := z.ZSetSearchRankRange(1, -1)
+		if len(expected) != z.Len() {
+			t.Fatalf("Expected %d members, got %d", z.Len(), len(expected))
+		}
+		for i := 1; i < len(expected); i++ {
+			a, b := expected[i-1], expected[i]
+			if a.Score > b.Score || (a.Score == b.Score && a.Value >= b.Value) {
+				t.Fatalf("Rank %d out of order: %v %v", i+1, a, b)
+			}
+		}
+		for _, node := range expected {
+			if score, ok := z.ZSetGetScore(node.Value); !ok || score != node.Score {
+				t.Fatalf("Member %s: expected score %f, got %f", node.Value, node.Score, score)
+			}
+		}
+		// 按排名取单个元素，检查span
+		for i := 0; i < 200; i++ {
+			rank := rnd.Intn(len(expected)) + 1
+			got := z.ZSetSearchRankRange(rank, rank)
+			if len(got) != 1 || got[0] != expected[rank-1] {
+				t.Fatalf("Rank %d: expected %v, got %v", rank, expected[rank-1], got)
+			}
+		}
+		if n := z.ZSetCount(ScoreRange{Min: 1000, Max: math.Inf(1)}); n == 0 {
+			t.Errorf("Expected members appended after the tail")
+		}
+	})
+}
+
 func TestZSet_Performance(t *testing.T) {
 	z := NewZSet()
 	start := time.Now()
@@ -117,3 +717,296 @@ func TestZSet_Performance(t *testing.T) {
 	duration := time.Since(start)
 	t.Logf("Inserted 10000 items in %v", duration)
 }
+
+// 基准测试用的有序集合，score在[0, n)内均匀分布
+type benchSet struct {
+	zs        *ZSet
+	n         int
+	perMember float64 // 构建前后RSS之差按成员数平均
+	addNs     float64 // 构建时平均每次ZADD耗时
+}
+
+var benchSets = map[int]*benchSet{}
+
+func getBenchSet(b *testing.B, n int) *benchSet {
+	if bs, ok := benchSets[n]; ok {
+		return bs
+	}
+	if testing.Short() && n > 1<<20 {
+		b.Skip("skipping large zset in short mode")
+	}
+
+	rnd := rand.New(rand.NewSource(int64(n)))
+	skipListSeed = uint64(n)
+	defer func() { skipListSeed = 0 }()
+	runtime.GC()
+	before := memstat.RSS()
+	zs := NewZSet()
+	start := time.Now()
+	for i := 0; i < n; i++ {
+		zs.ZSetAdd(rnd.Float64()*float64(n), fmt.Sprintf("member:%d", i))
+	}
+	elapsed := time.Since(start)
+	runtime.GC()
+
+	bs := &benchSet{
+		zs:        zs,
+		n:         n,
+		perMember: float64(memstat.RSS()-before) / float64(n),
+		addNs:     float64(elapsed.Nanoseconds()) / float64(n),
+	}
+	benchSets[n] = bs
+	return bs
+}
+
+var benchSizes = []struct {
+	name string
+	n    int
+}{
+	{"1M", 1_000_000},
+	{"10M", 10_000_000},
+}
+
+// 往n个成员的有序集合中继续ZADD，同时报告构建该集合时每个成员占用的内存
+// 例: go test -run ^$ -bench ZSetAdd -benchtime=1000000x
+func BenchmarkZSetAdd(b *testing.B) {
+	for _, size := range benchSizes {
+		b.Run(size.name, func(b *testing.B) {
+			bs := getBenchSet(b, size.n)
+			rnd := rand.New(rand.NewSource(1))
+			members := make([]string, b.N)
+			for i := range members {
+				members[i] = fmt.Sprintf("extra:%d:%d", size.n, bs.zs.Len()+i)
+			}
+
+			b.ResetTimer()
+			for i := 0; i < b.N; i++ {
+				bs.zs.ZSetAdd(rnd.Float64()*float64(size.n), members[i])
+			}
+			b.StopTimer()
+
+			for i := 0; i < b.N; i++ {
+				bs.zs.ZSetRemoveValue(members[i])
+			}
+			b.ReportMetric(bs.addNs, "build-ns/add")
+			b.ReportMetric(bs.perMember, "rss-B/member")
+		})
+	}
+}
+
+// ZADD更新已有成员的score(ZINCRBY同理)：C++侧按value删除再插入
+func BenchmarkZSetUpdate(b *testing.B) {
+	bs := getBenchSet(b, 1_000_000)
+	rnd := rand.New(rand.NewSource(4))
+	members := make([]string, 1<<16)
+	for i := range members {
+		members[i] = fmt.Sprintf("member:%d", rnd.Intn(bs.n))
+	}
+
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		bs.zs.ZSetUpdate(rnd.Float64()*float64(bs.n), members[i&(len(members)-1)])
+	}
+}
+
+// ZRANGEBYSCORE：每次查询宽度为100的score区间(约100个成员)
+func BenchmarkZSetRangeByScore(b *testing.B) {
+	const width = 100
+	for _, size := range benchSizes {
+		b.Run(size.name, func(b *testing.B) {
+			bs := getBenchSet(b, size.n)
+			rnd := rand.New(rand.NewSource(2))
+			total := 0
+
+			b.ResetTimer()
+			for i := 0; i < b.N; i++ {
+				l := rnd.Float64() * float64(size.n-width)
+				total += len(bs.zs.ZSetSearchRange(l, l+width))
+			}
+			b.StopTimer()
+			b.ReportMetric(float64(total)/float64(b.N), "members/op")
+		})
+	}
+}
+
+// 所有成员score相同(如排行榜初始状态)，插入应为O(logn)而非O(k)
+func BenchmarkZSetAddTiedScore(b *testing.B) {
+	members := make([]string, b.N)
+	for i := range members {
+		members[i] = fmt.Sprintf("user:%d", i)
+	}
+	z := NewZSet()
+
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		z.ZSetAdd(0, members[i])
+	}
+}
+
+// ZRANGEBYSCORE ... LIMIT offset 10：offset通过span定位，不随offset线性增长
+func BenchmarkZSetRangeByScoreLimit(b *testing.B) {
+	bs := getBenchSet(b, 1_000_000)
+	r := ScoreRange{Min: math.Inf(-1), Max: math.Inf(1)}
+	rnd := rand.New(rand.NewSource(3))
+	buf := make([]ZNode, 10)
+
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		it := bs.zs.ZSetRangeOpen(r, rnd.Intn(bs.n), 10)
+		it.Next(buf)
+		it.Close()
+	}
+}
+
+// ZREVRANGE 0 9：取排行榜前10名
+// rev从表尾沿backward指针遍历，只访问10个节点；reverse为正向取出整个区间后再反转
+func BenchmarkZSetRevRangeTop(b *testing.B) {
+	bs := getBenchSet(b, 1_000_000)
+	buf := make([]ZNode, 10)
+
+	b.Run("rev", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			it := bs.zs.ZSetRevRangeOpenRank(1, 10)
+			it.Next(buf)
+			it.Close()
+		}
+	})
+	b.Run("reverse", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			nodes := bs.zs.ZSetRangeOpenRank(1, -1).Collect()
+			slices.Reverse(nodes)
+			copy(buf, nodes)
+		}
+	})
+}
+
+// ZREMRANGEBYRANK 0 999：从10万个成员的集合头部裁剪1000个
+// bulk为一次遍历批量删除，single为逐个ZREM
+func BenchmarkZSetTrim(b *testing.B) {
+	const n, trim = 100_000, 1000
+	z := NewZSet()
+	next := 0
+	// 在尾部补充成员，使集合大小保持为n
+	refill := func() {
+		for z.Len() < n {
+			z.ZSetAdd(float64(next), fmt.Sprintf("member:%d", next))
+			next++
+		}
+	}
+	refill()
+
+	b.Run("bulk", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			z.ZSetRemoveRankRange(1, trim)
+			b.StopTimer()
+			refill()
+			b.StartTimer()
+		}
+	})
+	b.Run("single", func(b *testing.B) {
+		buf := make([]ZNode, trim)
+		for i := 0; i < b.N; i++ {
+			it := z.ZSetRangeOpenRank(1, trim)
+			cnt := it.Next(buf)
+			it.Close()
+			for _, node := range buf[:cnt] {
+				z.ZSetRemoveValue(node.Value)
+			}
+			b.StopTimer()
+			refill()
+			b.StartTimer()
+		}
+	})
+}
+
+// 大量只有几个成员的小有序集合(如每个用户的最近浏览)，报告每个集合占用的内存
+// RSS不会随GC回落，需单独运行每个子测试，例: go test -run ^$ -bench ZSetSmall/listpack -benchtime=1x
+func BenchmarkZSetSmall(b *testing.B) {
+	const sets, members = 100_000, 5
+	run := func(name string, maxEntries int) {
+		b.Run(name, func(b *testing.B) {
+			old := ZSetMaxListpackEntries
+			ZSetMaxListpackEntries = maxEntries
+			defer func() { ZSetMaxListpackEntries = old }()
+
+			var perSet float64
+			for i := 0; i < b.N; i++ {
+				runtime.GC()
+				before := memstat.RSS()
+				zss := make([]*ZSet, sets)
+				for j := range zss {
+					zss[j] = NewZSet()
+					for k := 0; k < members; k++ {
+						zss[j].ZSetAdd(float64(k), fmt.Sprintf("item:%d", k))
+					}
+				}
+				runtime.GC()
+				perSet = (float64(memstat.RSS()) - float64(before)) / sets
+				runtime.KeepAlive(zss)
+			}
+			b.ReportMetric(perSet, "rss-B/set")
+		})
+	}
+	run("listpack", 128)
+	run("skiplist", 0)
+}
+
+// ZUNIONSTORE/ZINTERSTORE：合并12个10万成员的集合，成员有一半重叠
+func BenchmarkZSetAggregate(b *testing.B) {
+	const sets, n = 12, 100_000
+	rnd := rand.New(rand.NewSource(6))
+	inputs := make([]*ZSet, sets)
+	for i := range inputs {
+		inputs[i] = NewZSet()
+		for j := 0; j < n; j++ {
+			// 前一半成员在所有集合中共享
+			id := j
+			if j >= n/2 {
+				id = (i+1)*n + j
+			}
+			inputs[i].ZSetAdd(rnd.Float64()*n, fmt.Sprintf("member:%d", id))
+		}
+	}
+
+	b.Run("union", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			ZSetUnion(inputs, nil, AggregateSum)
+		}
+	})
+	b.Run("inter", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			ZSetInter(inputs, nil, AggregateMax)
+		}
+	})
+}
+
+// 从空集合加载n个成员(如AOF重放)：ZSetAddMany排序后按序构建，对比逐个ZSetAdd
+// 例: go test -run ^$ -bench ZSetLoad -benchtime=1x
+func BenchmarkZSetLoad(b *testing.B) {
+	for _, size := range benchSizes {
+		rnd := rand.New(rand.NewSource(8))
+		nodes := make([]ZNode, size.n)
+		for i := range nodes {
+			nodes[i] = ZNode{rnd.Float64() * float64(size.n), fmt.Sprintf("member:%d", i)}
+		}
+		b.Run(size.name+"/bulk", func(b *testing.B) {
+			for i := 0; i < b.N; i++ {
+				b.StopTimer()
+				input := append([]ZNode(nil), nodes...)
+				b.StartTimer()
+				NewZSet().ZSetAddMany(input)
+			}
+		})
+		b.Run(size.name+"/single", func(b *testing.B) {
+			if testing.Short() && size.n > 1<<20 {
+				b.Skip("skipping large zset in short mode")
+			}
+			for i := 0; i < b.N; i++ {
+				z := NewZSet()
+				for _, node := range nodes {
+					z.ZSetAdd(node.Score, node.Value)
+				}
+			}
+		})
+	}
+}
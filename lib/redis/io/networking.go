@@ -86,7 +86,7 @@ func DataHandler(c gnet.Conn) (action gnet.Action) {
 	}()
 
 	// 处理数据
-	err = processInputBuffer(client)
+	err = processInputBufferLocked(client)
 	if err != nil {
 		AddReplyError(client, err)
 	}
@@ -94,6 +94,13 @@ func DataHandler(c gnet.Conn) (action gnet.Action) {
 	return action
 }
 
+// 持有DbLock处理数据，与serverCron互斥；命令panic时同样释放锁
+func processInputBufferLocked(client *core.RedisClient) error {
+	shared.Server.DbLock.Lock()
+	defer shared.Server.DbLock.Unlock()
+	return processInputBuffer(client)
+}
+
 // 处理客户端收到的数据
 func processInputBuffer(client *core.RedisClient) error {
 	req := client.ReqValue
@@ -13,6 +13,7 @@ import (
 	"redis-go/lib/redis/system"
 	"redis-go/lib/redis/zset"
 	"strconv"
+	"time"
 
 	"github.com/panjf2000/gnet/v2"
 	"github.com/rs/zerolog"
@@ -35,6 +36,7 @@ const (
 func initServerConfig() {
 	shared.Server.Port = shared.RedisServerPort
 	shared.Server.TcpBacklog = shared.RedisTcpBacklog
+	shared.Server.Hz = shared.RedisServerHz
 	shared.Server.Events = &core.EventLoop{}
 
 	io.RedisCommandTable = append(io.RedisCommandTable, system.CommandTable...)
@@ -61,9 +63,9 @@ func initServer() {
 	// 初始化事件处理器
 	shared.Server.Events.Traffic = io.DataHandler
 	shared.Server.Events.Open = io.AcceptHandler
-	//server.events.tick = func() (delay time.Duration, action gnet.Action) {
-	//	return serverCron(), action
-	//}
+	shared.Server.Events.Tick = func() (delay time.Duration, action gnet.Action) {
+		return serverCron(), action
+	}
 
 	// 初始化插件系统
 	InitPlugins()
@@ -116,12 +118,22 @@ func initCommandDict() *core.Dict {
 //func ustime() int64 {
 //	return time.Now().UnixNano() / 1000
 //}
-//
-//func serverCron() time.Duration {
-//	server.lruclock = getLruClock()
-//	databasesCron()
-//	return time.Millisecond * time.Duration(1000/server.hz)
-//}
+
+func serverCron() time.Duration {
+	//server.lruclock = getLruClock()
+	databasesCron()
+	return time.Millisecond * time.Duration(1000/shared.Server.Hz)
+}
+
+// 数据库的后台任务：推进字典的渐进式rehash
+// OnTick不在事件循环的goroutine中，需持有DbLock，避免与命令同时访问字典
+func databasesCron() {
+	shared.Server.DbLock.Lock()
+	defer shared.Server.DbLock.Unlock()
+	for _, db := range shared.Server.Db {
+		db.IncrementallyRehash(shared.RehashCronMilliseconds)
+	}
+}
 
 // Start 启动服务器
 func Start() {
@@ -163,5 +175,5 @@ func elMain() {
 	addr := "tcp://" + shared.Server.BindAddr + ":" + strconv.Itoa(shared.Server.Port)
 	log.Info().Str("addr", addr).Msg("server is now listening")
 	log.Fatal().Err(gnet.Run(shared.Server.Events, addr,
-		gnet.WithMulticore(false), gnet.WithNumEventLoop(1)))
+		gnet.WithMulticore(false), gnet.WithNumEventLoop(1), gnet.WithTicker(true)))
 }
@@ -44,14 +44,22 @@ var aofCommands = map[string]struct{}{
 	"rpop":  ept,
 
 	//set
-	"sadd": ept,
-	"srem": ept,
+	"sadd":        ept,
+	"srem":        ept,
+	"sinterstore": ept,
+	"sunionstore": ept,
+	"sdiffstore":  ept,
 
 	//zset
 	"zadd":             ept,
 	"zincrby":          ept,
 	"zrem":             ept,
 	"zremrangebyscore": ept,
+	"zremrangebylex":   ept,
+	"zremrangebyrank":  ept,
+	"zunionstore":      ept,
+	"zinterstore":      ept,
+	"zdiffstore":       ept,
 
 	// Add other write-related commands here
 }
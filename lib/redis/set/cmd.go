@@ -16,6 +16,12 @@ var SetCommandTable = []*core.RedisCommand{
 	{Name: "smembers", RedisClientFunc: SMembers},
 	{Name: "scard", RedisClientFunc: SCard},
 	{Name: "srem", RedisClientFunc: SRem},
+	{Name: "sinter", RedisClientFunc: SInter},
+	{Name: "sinterstore", RedisClientFunc: SInterStore},
+	{Name: "sunion", RedisClientFunc: SUnion},
+	{Name: "sunionstore", RedisClientFunc: SUnionStore},
+	{Name: "sdiff", RedisClientFunc: SDiff},
+	{Name: "sdiffstore", RedisClientFunc: SDiffStore},
 }
 
 var SetCommandInfoTable = []*core.RedisCommandInfo{
@@ -24,4 +30,10 @@ var SetCommandInfoTable = []*core.RedisCommandInfo{
 	core.NewRedisCommandInfo("smembers", 2, []string{"readonly"}, 1, 1, 1),
 	core.NewRedisCommandInfo("scard", 2, []string{"readonly"}, 1, 1, 1),
 	core.NewRedisCommandInfo("srem", 3, []string{"write"}, 1, 2, 1),
+	core.NewRedisCommandInfo("sinter", -2, []string{"readonly"}, 1, -1, 1),
+	core.NewRedisCommandInfo("sinterstore", -3, []string{"write", "denyoom"}, 1, -1, 1),
+	core.NewRedisCommandInfo("sunion", -2, []string{"readonly"}, 1, -1, 1),
+	core.NewRedisCommandInfo("sunionstore", -3, []string{"write", "denyoom"}, 1, -1, 1),
+	core.NewRedisCommandInfo("sdiff", -2, []string{"readonly"}, 1, -1, 1),
+	core.NewRedisCommandInfo("sdiffstore", -3, []string{"write", "denyoom"}, 1, -1, 1),
 }
@@ -36,20 +36,17 @@ func SAdd(client *core.RedisClient) (err error) {
 		set = setObj.Ptr.(*core.Set)
 	}
 
-	var countNew int64 = 0
-	for _, value := range values {
-		str := value.Str
-		obj := core.CreateString(str)
-		repeat, err := set.Add(obj)
-		if err != nil {
-			return err
-		}
-		if !repeat {
-			countNew++
-		}
+	// 一次批量添加，整数集合只需排序合并一次
+	objs := make([]*core.Object, len(values))
+	for i, value := range values {
+		objs[i] = core.CreateString(value.Str)
+	}
+	countNew, err := set.AddMany(objs)
+	if err != nil {
+		return err
 	}
 
-	io.AddReplyNumber(client, countNew)
+	io.AddReplyNumber(client, int64(countNew))
 	return
 }
 
@@ -100,15 +97,7 @@ func SMembers(client *core.RedisClient) (err error) {
 		if setObj.Type != core.RedisSet {
 			return errNotASet
 		}
-		set := setObj.Ptr.(*core.Set)
-
-		size := set.Size()
-		res := make([]*resp3.Value, 0, size)
-		set.ForEach(func(obj *core.Object) {
-			str, _ := obj.GetString()
-			res = append(res, resp3.NewSimpleStringValue(str))
-		})
-		io.AddReplyArray(client, res)
+		replySetMembers(client, setObj.Ptr.(*core.Set))
 	}
 	return
 }
@@ -177,3 +166,106 @@ func SRem(client *core.RedisClient) (err error) {
 	}
 	return
 }
+
+// 查找keys对应的集合，不存在的key为nil
+func lookupSets(db *core.RedisDb, keys []*resp3.Value) ([]*core.Set, error) {
+	sets := make([]*core.Set, len(keys))
+	for i, key := range keys {
+		setObj := db.LookupKey(key.Str)
+		if setObj == nil {
+			continue
+		}
+		if setObj.Type != core.RedisSet {
+			return nil, errNotASet
+		}
+		sets[i] = setObj.Ptr.(*core.Set)
+	}
+	return sets, nil
+}
+
+// 以数组回复集合的所有成员
+func replySetMembers(client *core.RedisClient, set *core.Set) {
+	res := make([]*resp3.Value, 0, set.Size())
+	set.ForEachString(func(str string) {
+		res = append(res, resp3.NewSimpleStringValue(str))
+	})
+	io.AddReplyArray(client, res)
+}
+
+// 计算key...的集合运算并回复结果的所有成员
+func setOperation(client *core.RedisClient, op func([]*core.Set) *core.Set) (err error) {
+	req := client.ReqValue.Elems[1:]
+
+	if len(req) < 1 {
+		return errNotEnoughArgs
+	}
+
+	sets, err := lookupSets(client.Db, req)
+	if err != nil {
+		return err
+	}
+	replySetMembers(client, op(sets))
+	return
+}
+
+// 计算key...的集合运算并存入destination，回复结果的元素个数；结果为空时删除destination
+func setOperationStore(client *core.RedisClient, op func([]*core.Set) *core.Set) (err error) {
+	req := client.ReqValue.Elems[1:]
+
+	if len(req) < 2 {
+		return errNotEnoughArgs
+	}
+
+	db := client.Db
+	dest := req[0].Str
+	sets, err := lookupSets(db, req[1:])
+	if err != nil {
+		return err
+	}
+
+	result := op(sets)
+	size := result.Size()
+	if size == 0 {
+		db.DbDelete(dest)
+	} else {
+		db.SetKey(dest, core.CreateSet(result))
+	}
+	io.AddReplyNumber(client, int64(size))
+	return
+}
+
+// SInter SINTER命令 返回所有给定集合的交集
+// https://redis.io/commands/sinter/
+func SInter(client *core.RedisClient) (err error) {
+	return setOperation(client, core.SetInter)
+}
+
+// SInterStore SINTERSTORE命令 将所有给定集合的交集存储在destination中
+// https://redis.io/commands/sinterstore/
+func SInterStore(client *core.RedisClient) (err error) {
+	return setOperationStore(client, core.SetInter)
+}
+
+// SUnion SUNION命令 返回所有给定集合的并集
+// https://redis.io/commands/sunion/
+func SUnion(client *core.RedisClient) (err error) {
+	return setOperation(client, core.SetUnion)
+}
+
+// SUnionStore SUNIONSTORE命令 将所有给定集合的并集存储在destination中
+// https://redis.io/commands/sunionstore/
+func SUnionStore(client *core.RedisClient) (err error) {
+	return setOperationStore(client, core.SetUnion)
+}
+
+// SDiff SDIFF命令 返回第一个集合与其余集合的差集
+// https://redis.io/commands/sdiff/
+func SDiff(client *core.RedisClient) (err error) {
+	return setOperation(client, core.SetDiff)
+}
+
+// SDiffStore SDIFFSTORE命令 将第一个集合与其余集合的差集存储在destination中
+// https://redis.io/commands/sdiffstore/
+func SDiffStore(client *core.RedisClient) (err error) {
+	return setOperationStore(client, core.SetDiff)
+}
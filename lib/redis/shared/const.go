@@ -11,6 +11,9 @@ const (
 
 	RedisServerPort = 6389
 	RedisTcpBacklog = 511
+	RedisServerHz   = 10 // serverCron每秒执行次数
+
+	RehashCronMilliseconds = 1 // 每次serverCron中每个字典用于rehash的时间
 
 	AOFInterval = 1 * time.Second // aof间隔时间
 	AOFBuffer   = 1000            //aof缓冲区刷新大小
@@ -47,14 +47,17 @@ func Set(client *core.RedisClient) (err error) {
 		}
 	}
 
-	found := db.LookupKey(key) != nil
-
-	// 不满足NX或者XX的条件
-	if (flags&objSetNX > 0 && found) || (flags&objSetXX > 0 && !found) {
-		if !(flags&objSetGet > 0) {
-			io.SendReplyToClient(client, shared.Shared.Nil)
+	// 只有NX/XX需要先查找，普通SET直接插入或覆盖
+	if flags&(objSetNX|objSetXX) > 0 {
+		found := db.LookupKey(key) != nil
+
+		// 不满足NX或者XX的条件
+		if (flags&objSetNX > 0 && found) || (flags&objSetXX > 0 && !found) {
+			if !(flags&objSetGet > 0) {
+				io.SendReplyToClient(client, shared.Shared.Nil)
+			}
+			return
 		}
-		return
 	}
 
 	db.SetKey(key, core.CreateString(req[1].Str))
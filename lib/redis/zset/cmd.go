@@ -15,6 +15,12 @@ var (
 	errValueNotFound = errors.New("value not found")
 	errValueExists   = errors.New("value already exists")
 	errInvalidRange  = errors.New("invalid range")
+
+	errInvalidLexRange   = errors.New("min or max not valid string range item")
+	errInvalidScoreRange = errors.New("min or max is not a float")
+	errNumKeys           = errors.New("at least 1 input key is needed for this command")
+	errWeightNotFloat    = errors.New("weight value is not a float")
+	errScoreNaN          = errors.New("resulting score is not a number (NaN)")
 )
 
 // ZSetCommandTable 有序集合相关命令
@@ -23,21 +29,22 @@ var ZSetCommandTable = []*core.RedisCommand{
 	{"zcard", ZCard},
 	{"zcount", ZCount},
 	{"zincrby", ZIncrBy},
-	// {"zinterstore", ZInterStore},
-	// {"zlexcount", ZLexCount},
+	{"zdiffstore", ZDiffStore},
+	{"zinterstore", ZInterStore},
+	{"zlexcount", ZLexCount},
 	{"zrange", ZRange},
-	// {"zrangebylex", ZRangeByLex},
+	{"zrangebylex", ZRangeByLex},
 	{"zrangebyscore", ZRangeByScore},
 	// {"zrank", ZRank},
 	{"zrem", ZRem},
-	// {"zremrangebylex", ZRemRangeByLex},
-	// {"zremrangebyrank", ZRemRangeByRank},
-	// {"zremrangebyscore", ZRemRangeByScore},
-	// {"zrevrange", ZRevRange},
-	// {"zrevrangebyscore", ZRevRangeByScore},
+	{"zremrangebylex", ZRemRangeByLex},
+	{"zremrangebyrank", ZRemRangeByRank},
+	{"zremrangebyscore", ZRemRangeByScore},
+	{"zrevrange", ZRevRange},
+	{"zrevrangebyscore", ZRevRangeByScore},
 	// {"zrevrank", ZRevRank},
 	{"zscore", ZScore},
-	// {"zunionstore", ZUnionStore},
+	{"zunionstore", ZUnionStore},
 	// {"zscan", ZScan},
 }
 
@@ -51,4 +58,14 @@ var ZSetCommandInfoTable = []*core.RedisCommandInfo{
 	core.NewRedisCommandInfo("zscore", 3, []string{"readonly"}, 1, 1, 1),
 	core.NewRedisCommandInfo("zrank", 3, []string{"readonly"}, 1, 1, 1),
 	core.NewRedisCommandInfo("zrange", -4, []string{"readonly"}, 1, 1, 1),
+	core.NewRedisCommandInfo("zrangebylex", -4, []string{"readonly"}, 1, 1, 1),
+	core.NewRedisCommandInfo("zlexcount", 4, []string{"readonly"}, 1, 1, 1),
+	core.NewRedisCommandInfo("zremrangebylex", 4, []string{"write"}, 1, 1, 1),
+	core.NewRedisCommandInfo("zremrangebyrank", 4, []string{"write"}, 1, 1, 1),
+	core.NewRedisCommandInfo("zremrangebyscore", 4, []string{"write"}, 1, 1, 1),
+	core.NewRedisCommandInfo("zrevrange", -4, []string{"readonly"}, 1, 1, 1),
+	core.NewRedisCommandInfo("zrevrangebyscore", -4, []string{"readonly"}, 1, 1, 1),
+	core.NewRedisCommandInfo("zunionstore", -4, []string{"write", "denyoom"}, 1, 1, 1),
+	core.NewRedisCommandInfo("zinterstore", -4, []string{"write", "denyoom"}, 1, 1, 1),
+	core.NewRedisCommandInfo("zdiffstore", -4, []string{"write", "denyoom"}, 1, 1, 1),
 }
@@ -1,6 +1,7 @@
 package zset
 
 import (
+	"math"
 	"redis-go/lib/redis/core"
 	"redis-go/lib/redis/core/zset"
 	"redis-go/lib/redis/io"
@@ -31,6 +32,16 @@ func ZAdd(client *core.RedisClient) (err error) {
 		return errInvalidArgs
 	}
 
+	// 先解析全部score，再一次性批量添加(AOF重放时的大ZADD可按序构建跳表)
+	nodes := make([]zset.ZNode, 0, len(req)/2)
+	for i := 1; i < len(req); i += 2 {
+		score, err := parseScore(req[i].Str)
+		if err != nil {
+			return err
+		}
+		nodes = append(nodes, zset.ZNode{Score: score, Value: req[i+1].Str})
+	}
+
 	zsetKey := req[0].Str
 
 	db := client.Db
@@ -45,28 +56,8 @@ func ZAdd(client *core.RedisClient) (err error) {
 		zs = zsetObj.Ptr.(*zset.ZSet)
 	}
 
-	num := 0
-	for i := 1; i < len(req); i += 2 {
-		num++
-		score, err := strconv.ParseFloat(req[i].Str, 64)
-		if err != nil {
-			return errInvalidArgs
-		}
-
-		value := req[i+1].Str
-
-		// fmt.Println(score, value)
-		_, exist := zs.ZSetGetScore(value)
-		if exist {
-			// fmt.Println("ZSetUpdate", value, score, s)
-			zs.ZSetUpdate(score, value)
-		} else {
-			// fmt.Println("ZSetAdd", value, score, s)
-			zs.ZSetAdd(score, value)
-		}
-
-	}
-	io.AddReplyNumber(client, int64(num))
+	zs.ZSetAddMany(nodes)
+	io.AddReplyNumber(client, int64(len(nodes)))
 
 	return
 }
@@ -105,15 +96,10 @@ func ZCount(client *core.RedisClient) (err error) {
 	db := client.Db
 	zsetKey := req[0].Str
 
-	minScore, err := strconv.ParseFloat(req[1].Str, 64)
-	if err != nil {
-		return errInvalidArgs
-	}
-	maxScore, err := strconv.ParseFloat(req[2].Str, 64)
+	r, err := parseScoreRange(req[1].Str, req[2].Str)
 	if err != nil {
-		return errInvalidArgs
+		return err
 	}
-	// fmt.Println(minScore, maxScore)
 
 	zsetObj := db.LookupKey(zsetKey)
 	if zsetObj == nil {
@@ -121,10 +107,9 @@ func ZCount(client *core.RedisClient) (err error) {
 		return errZSetNotFound
 	}
 
+	// 通过span计算，无需遍历区间
 	zs := zsetObj.Ptr.(*zset.ZSet)
-	res := zs.ZSetSearchRange(minScore, maxScore)
-	count := len(res)
-	io.AddReplyNumber(client, int64(count))
+	io.AddReplyNumber(client, int64(zs.ZSetCount(r)))
 	return
 }
 
@@ -135,9 +120,9 @@ func ZIncrBy(client *core.RedisClient) (err error) {
 	}
 
 	key := req[0].Str
-	increment, err := strconv.ParseFloat(req[1].Str, 64)
+	increment, err := parseScore(req[1].Str)
 	if err != nil {
-		return errInvalidArgs
+		return err
 	}
 	member := req[2].Str
 	db := client.Db
@@ -149,19 +134,22 @@ func ZIncrBy(client *core.RedisClient) (err error) {
 		db.DbAdd(key, core.CreateZSet(zset))
 		zset.ZSetAdd(increment, member)
 		io.AddReplyDouble(client, increment)
+		return
 	} else if zsetObj.Type != core.RedisZSet {
 		return errNotAZSet
 	}
 
 	zs := zsetObj.Ptr.(*ZSet)
-	oldScore, exists := zs.ZSetGetScore(member)
-	if exists {
-		newScore := oldScore + increment
-		zs.ZSetUpdate(newScore, member) // 更新分数
-		io.AddReplyDouble(client, newScore)
-	} else {
-		io.AddReplyDouble(client, increment)
+	newScore := increment
+	if oldScore, exists := zs.ZSetGetScore(member); exists {
+		newScore += oldScore
+	}
+	// inf与-inf相加得到NaN，与redis一致拒绝
+	if math.IsNaN(newScore) {
+		return errScoreNaN
 	}
+	zs.ZSetAddMany([]zset.ZNode{{Score: newScore, Value: member}})
+	io.AddReplyDouble(client, newScore)
 
 	return
 }
@@ -198,24 +186,16 @@ func ZRange(client *core.RedisClient) (err error) {
 		return
 	}
 
-	zs := zsetObj.Ptr.(*ZSet)
-	members := zs.ZSetSearchRankRange(start, stop)
-
-	if withscores {
-		results := make([]*resp3.Value, 2*len(members))
-		for i, member := range members {
-			results[2*i] = resp3.NewSimpleStringValue(member.Value)
-			score, _ := zs.ZSetGetScore(member.Value)
-			results[2*i+1] = resp3.NewDoubleValue(score)
-		}
-		io.AddReplyArray(client, results)
-	} else {
-		results := make([]*resp3.Value, len(members))
-		for i, member := range members {
-			results[i] = resp3.NewSimpleStringValue(member.Value)
-		}
-		io.AddReplyArray(client, results)
+	// ZRANGE的下标从0开始，跳表的排名从1开始，负数下标两者含义相同
+	if start >= 0 {
+		start++
 	}
+	if stop >= 0 {
+		stop++
+	}
+
+	zs := zsetObj.Ptr.(*ZSet)
+	replyRange(client, zs.ZSetRangeOpenRank(start, stop), withscores, 0)
 	return
 }
 
@@ -230,11 +210,48 @@ func ZRangeByScore(client *core.RedisClient) (err error) {
 	db := client.Db
 	zsetKey := req[0].Str
 
-	minScore, err := strconv.ParseFloat(req[1].Str, 64)
+	r, err := parseScoreRange(req[1].Str, req[2].Str)
 	if err != nil {
 		return err
 	}
-	maxScore, err := strconv.ParseFloat(req[2].Str, 64)
+	withscores, offset, count, err := parseRangeOptions(req[3:], true)
+	if err != nil {
+		return err
+	}
+
+	zsetObj := db.LookupKey(zsetKey)
+	if zsetObj == nil {
+		io.SendReplyToClient(client, shared.Shared.Nil)
+		return
+	}
+
+	// 区间内的成员数通过span计算，回复数组一次分配到位
+	zs := zsetObj.Ptr.(*ZSet)
+	hint, ok := limitRangeSize(zs.ZSetCount(r), offset, count)
+	if !ok {
+		io.AddReplyArray(client, []*resp3.Value{})
+		return
+	}
+	replyRange(client, zs.ZSetRangeOpen(r, offset, count), withscores, hint)
+	return
+}
+
+// ZRevRange - 按分数从高到低获取指定区间的成员
+func ZRevRange(client *core.RedisClient) (err error) {
+	req := client.ReqValue.Elems[1:]
+
+	if len(req) < 3 {
+		return errNotEnoughArgs
+	}
+
+	db := client.Db
+	zsetKey := req[0].Str
+
+	start, err := strconv.Atoi(req[1].Str)
+	if err != nil {
+		return err
+	}
+	stop, err := strconv.Atoi(req[2].Str)
 	if err != nil {
 		return err
 	}
@@ -249,30 +266,59 @@ func ZRangeByScore(client *core.RedisClient) (err error) {
 	if zsetObj == nil {
 		io.SendReplyToClient(client, shared.Shared.Nil)
 		return
+	} else if zsetObj.Type != core.RedisZSet {
+		return errNotAZSet
+	}
+
+	// 下标转换同ZRange，倒数的排名由跳表从表尾数起
+	if start >= 0 {
+		start++
+	}
+	if stop >= 0 {
+		stop++
 	}
 
 	zs := zsetObj.Ptr.(*ZSet)
-	members := zs.ZSetSearchRange(minScore, maxScore)
-	// for _, m := range members {
-	// 	io.AddReplyString(client, m.Value)
-	// 	io.AddReplyDouble(client, m.Score)
-	// }
+	replyRange(client, zs.ZSetRevRangeOpenRank(start, stop), withscores, 0)
+	return
+}
 
-	if withscores {
-		results := make([]*resp3.Value, 2*len(members))
-		for i, member := range members {
-			results[2*i] = resp3.NewSimpleStringValue(member.Value)
-			score, _ := zs.ZSetGetScore(member.Value)
-			results[2*i+1] = resp3.NewDoubleValue(score)
-		}
-		io.AddReplyArray(client, results)
-	} else {
-		results := make([]*resp3.Value, len(members))
-		for i, member := range members {
-			results[i] = resp3.NewSimpleStringValue(member.Value)
-		}
-		io.AddReplyArray(client, results)
+// ZRevRangeByScore - 通过分数区间按从高到低获取成员，参数为max min
+func ZRevRangeByScore(client *core.RedisClient) (err error) {
+	req := client.ReqValue.Elems[1:]
+
+	if len(req) < 3 {
+		return errNotEnoughArgs
+	}
+
+	db := client.Db
+	zsetKey := req[0].Str
+
+	r, err := parseScoreRange(req[2].Str, req[1].Str)
+	if err != nil {
+		return err
+	}
+	withscores, offset, count, err := parseRangeOptions(req[3:], true)
+	if err != nil {
+		return err
 	}
+
+	zsetObj := db.LookupKey(zsetKey)
+	if zsetObj == nil {
+		io.SendReplyToClient(client, shared.Shared.Nil)
+		return
+	} else if zsetObj.Type != core.RedisZSet {
+		return errNotAZSet
+	}
+
+	// LIMIT在遍历中完成，只访问返回的成员
+	zs := zsetObj.Ptr.(*ZSet)
+	hint, ok := limitRangeSize(zs.ZSetCount(r), offset, count)
+	if !ok {
+		io.AddReplyArray(client, []*resp3.Value{})
+		return
+	}
+	replyRange(client, zs.ZSetRevRangeOpen(r, offset, count), withscores, hint)
 	return
 }
 
@@ -340,3 +386,428 @@ func ZScore(client *core.RedisClient) (err error) {
 
 	return
 }
+
+// 解析字典序区间的一端: "[member"、"(member"、"-"、"+"
+func parseLexBound(s string) (zset.LexBound, error) {
+	switch {
+	case s == "-":
+		return zset.LexBound{Flag: zset.LexNegInf}, nil
+	case s == "+":
+		return zset.LexBound{Flag: zset.LexPosInf}, nil
+	case strings.HasPrefix(s, "["):
+		return zset.LexBound{Member: s[1:], Flag: zset.LexInclusive}, nil
+	case strings.HasPrefix(s, "("):
+		return zset.LexBound{Member: s[1:], Flag: zset.LexExclusive}, nil
+	default:
+		return zset.LexBound{}, errInvalidLexRange
+	}
+}
+
+func parseLexRange(min, max string) (minBound, maxBound zset.LexBound, err error) {
+	if minBound, err = parseLexBound(min); err != nil {
+		return
+	}
+	maxBound, err = parseLexBound(max)
+	return
+}
+
+// ZRangeByLex - 通过字典序区间获取成员(所有成员score相同时有意义)
+func ZRangeByLex(client *core.RedisClient) (err error) {
+	req := client.ReqValue.Elems[1:]
+
+	if len(req) < 3 {
+		return errNotEnoughArgs
+	}
+
+	db := client.Db
+	zsetKey := req[0].Str
+
+	min, max, err := parseLexRange(req[1].Str, req[2].Str)
+	if err != nil {
+		return err
+	}
+
+	_, offset, count, err := parseRangeOptions(req[3:], false)
+	if err != nil {
+		return err
+	}
+
+	zsetObj := db.LookupKey(zsetKey)
+	if zsetObj == nil {
+		io.SendReplyToClient(client, shared.Shared.Nil)
+		return
+	} else if zsetObj.Type != core.RedisZSet {
+		return errNotAZSet
+	}
+
+	zs := zsetObj.Ptr.(*ZSet)
+	replyRange(client, zs.ZSetRangeOpenLex(min, max, offset, count), false, 0)
+	return
+}
+
+// ZLexCount - 字典序区间内的成员数量
+func ZLexCount(client *core.RedisClient) (err error) {
+	req := client.ReqValue.Elems[1:]
+
+	if len(req) < 3 {
+		return errNotEnoughArgs
+	}
+
+	db := client.Db
+	zsetKey := req[0].Str
+
+	min, max, err := parseLexRange(req[1].Str, req[2].Str)
+	if err != nil {
+		return err
+	}
+
+	zsetObj := db.LookupKey(zsetKey)
+	if zsetObj == nil {
+		io.AddReplyNumber(client, 0)
+		return
+	} else if zsetObj.Type != core.RedisZSet {
+		return errNotAZSet
+	}
+
+	zs := zsetObj.Ptr.(*ZSet)
+	io.AddReplyNumber(client, int64(zs.ZSetLexCount(min, max)))
+	return
+}
+
+// ZRemRangeByLex - 删除字典序区间内的成员
+func ZRemRangeByLex(client *core.RedisClient) (err error) {
+	req := client.ReqValue.Elems[1:]
+
+	if len(req) < 3 {
+		return errNotEnoughArgs
+	}
+
+	db := client.Db
+	zsetKey := req[0].Str
+
+	min, max, err := parseLexRange(req[1].Str, req[2].Str)
+	if err != nil {
+		return err
+	}
+
+	zsetObj := db.LookupKey(zsetKey)
+	if zsetObj == nil {
+		io.AddReplyNumber(client, 0)
+		return
+	} else if zsetObj.Type != core.RedisZSet {
+		return errNotAZSet
+	}
+
+	zs := zsetObj.Ptr.(*ZSet)
+	io.AddReplyNumber(client, int64(zs.ZSetRemoveLexRange(min, max)))
+	return
+}
+
+// ZRemRangeByRank - 删除下标区间[start, stop]内的成员，一次遍历完成
+func ZRemRangeByRank(client *core.RedisClient) (err error) {
+	req := client.ReqValue.Elems[1:]
+
+	if len(req) < 3 {
+		return errNotEnoughArgs
+	}
+
+	db := client.Db
+	zsetKey := req[0].Str
+
+	start, err := strconv.Atoi(req[1].Str)
+	if err != nil {
+		return err
+	}
+	stop, err := strconv.Atoi(req[2].Str)
+	if err != nil {
+		return err
+	}
+
+	zsetObj := db.LookupKey(zsetKey)
+	if zsetObj == nil {
+		io.AddReplyNumber(client, 0)
+		return
+	} else if zsetObj.Type != core.RedisZSet {
+		return errNotAZSet
+	}
+
+	// 下标转换同ZRange
+	if start >= 0 {
+		start++
+	}
+	if stop >= 0 {
+		stop++
+	}
+
+	zs := zsetObj.Ptr.(*ZSet)
+	io.AddReplyNumber(client, int64(zs.ZSetRemoveRankRange(start, stop)))
+	return
+}
+
+// ZRemRangeByScore - 删除score区间内的成员，一次遍历完成
+func ZRemRangeByScore(client *core.RedisClient) (err error) {
+	req := client.ReqValue.Elems[1:]
+
+	if len(req) < 3 {
+		return errNotEnoughArgs
+	}
+
+	db := client.Db
+	zsetKey := req[0].Str
+
+	r, err := parseScoreRange(req[1].Str, req[2].Str)
+	if err != nil {
+		return err
+	}
+
+	zsetObj := db.LookupKey(zsetKey)
+	if zsetObj == nil {
+		io.AddReplyNumber(client, 0)
+		return
+	} else if zsetObj.Type != core.RedisZSet {
+		return errNotAZSet
+	}
+
+	zs := zsetObj.Ptr.(*ZSet)
+	io.AddReplyNumber(client, int64(zs.ZSetRemoveRange(r)))
+	return
+}
+
+// 解析ZADD、ZINCRBY的score，NaN不是合法的score
+func parseScore(s string) (float64, error) {
+	score, err := strconv.ParseFloat(s, 64)
+	if err != nil {
+		return 0, errInvalidArgs
+	}
+	if math.IsNaN(score) {
+		return 0, errScoreNaN
+	}
+	return score, nil
+}
+
+// 解析score区间的一端: "1.5"、"(1.5"、"-inf"、"+inf"
+func parseScoreBound(s string) (score float64, ex bool, err error) {
+	if strings.HasPrefix(s, "(") {
+		s, ex = s[1:], true
+	}
+	score, err = strconv.ParseFloat(s, 64)
+	if err != nil || math.IsNaN(score) {
+		return 0, false, errInvalidScoreRange
+	}
+	return
+}
+
+func parseScoreRange(min, max string) (r zset.ScoreRange, err error) {
+	if r.Min, r.MinEx, err = parseScoreBound(min); err != nil {
+		return
+	}
+	r.Max, r.MaxEx, err = parseScoreBound(max)
+	return
+}
+
+// 解析范围查询的可选参数: [WITHSCORES] [LIMIT offset count]
+// count为负数表示不限数量
+func parseRangeOptions(args []*resp3.Value, allowScores bool) (withscores bool, offset, count int, err error) {
+	count = -1
+	for i := 0; i < len(args); i++ {
+		switch strings.ToUpper(args[i].Str) {
+		case "WITHSCORES":
+			if !allowScores {
+				return false, 0, 0, errInvalidArgs
+			}
+			withscores = true
+		case "LIMIT":
+			if i+2 >= len(args) {
+				return false, 0, 0, errInvalidArgs
+			}
+			if offset, err = strconv.Atoi(args[i+1].Str); err != nil {
+				return false, 0, 0, errInvalidArgs
+			}
+			if count, err = strconv.Atoi(args[i+2].Str); err != nil {
+				return false, 0, 0, errInvalidArgs
+			}
+			i += 2
+		default:
+			return false, 0, 0, errInvalidArgs
+		}
+	}
+	return
+}
+
+/*
+区间内共total个成员时，LIMIT offset count将返回的成员数，用于预分配回复数组，结果在[0, total]内
+offset为负数时与redis一致返回空，ok为false
+*/
+func limitRangeSize(total, offset, count int) (size int, ok bool) {
+	if offset < 0 {
+		return 0, false
+	}
+	size = max(total-offset, 0)
+	if count >= 0 && count < size {
+		size = count
+	}
+	return size, true
+}
+
+// 从游标按批读取成员并写入回复，不经过中间数组
+// sizeHint为预计的成员数，用于预分配回复数组
+func replyRange(client *core.RedisClient, it *zset.ZSetRangeIter, withscores bool, sizeHint int) {
+	defer it.Close()
+
+	if sizeHint < 0 {
+		sizeHint = 0
+	}
+	if withscores {
+		sizeHint *= 2
+	}
+	results := make([]*resp3.Value, 0, sizeHint)
+
+	var buf [128]zset.ZNode
+	for n := it.Next(buf[:]); n > 0; n = it.Next(buf[:]) {
+		for _, member := range buf[:n] {
+			results = append(results, resp3.NewSimpleStringValue(member.Value))
+			if withscores {
+				results = append(results, resp3.NewDoubleValue(member.Score))
+			}
+		}
+	}
+	io.AddReplyArray(client, results)
+}
+
+// 解析ZUNIONSTORE/ZINTERSTORE/ZDIFFSTORE的参数:
+// destination numkeys key [key ...] [WEIGHTS weight [weight ...]] [AGGREGATE SUM|MIN|MAX]
+// allowOptions为false时(ZDIFFSTORE)不接受WEIGHTS与AGGREGATE
+func parseStoreArgs(req []*resp3.Value, allowOptions bool) (dest string, keys []string, weights []float64, aggregate int, err error) {
+	dest = req[0].Str
+	numkeys, err := strconv.Atoi(req[1].Str)
+	if err != nil {
+		return "", nil, nil, 0, errInvalidArgs
+	}
+	if numkeys < 1 {
+		return "", nil, nil, 0, errNumKeys
+	}
+	if numkeys > len(req)-2 {
+		return "", nil, nil, 0, errNotEnoughArgs
+	}
+	for _, key := range req[2 : 2+numkeys] {
+		keys = append(keys, key.Str)
+	}
+
+	aggregate = zset.AggregateSum
+	args := req[2+numkeys:]
+	for i := 0; i < len(args); i++ {
+		if !allowOptions {
+			return "", nil, nil, 0, errInvalidArgs
+		}
+		switch strings.ToUpper(args[i].Str) {
+		case "WEIGHTS":
+			if i+numkeys >= len(args) {
+				return "", nil, nil, 0, errInvalidArgs
+			}
+			weights = make([]float64, numkeys)
+			for j := range weights {
+				weights[j], err = strconv.ParseFloat(args[i+1+j].Str, 64)
+				if err != nil || math.IsNaN(weights[j]) {
+					return "", nil, nil, 0, errWeightNotFloat
+				}
+			}
+			i += numkeys
+		case "AGGREGATE":
+			if i+1 >= len(args) {
+				return "", nil, nil, 0, errInvalidArgs
+			}
+			switch strings.ToUpper(args[i+1].Str) {
+			case "SUM":
+				aggregate = zset.AggregateSum
+			case "MIN":
+				aggregate = zset.AggregateMin
+			case "MAX":
+				aggregate = zset.AggregateMax
+			default:
+				return "", nil, nil, 0, errInvalidArgs
+			}
+			i++
+		default:
+			return "", nil, nil, 0, errInvalidArgs
+		}
+	}
+	return
+}
+
+// 查找所有输入的有序集合，不存在的key对应nil
+func lookupZSets(db *core.RedisDb, keys []string) ([]*ZSet, error) {
+	sets := make([]*ZSet, len(keys))
+	for i, key := range keys {
+		obj := db.LookupKey(key)
+		if obj == nil {
+			continue
+		}
+		if obj.Type != core.RedisZSet {
+			return nil, errNotAZSet
+		}
+		sets[i] = obj.Ptr.(*ZSet)
+	}
+	return sets, nil
+}
+
+// 将结果写入destination(结果为空时删除destination)，回复结果的元素个数
+func storeZSet(client *core.RedisClient, dest string, result *ZSet) {
+	if result.Len() == 0 {
+		client.Db.DbDelete(dest)
+	} else {
+		client.Db.SetKey(dest, core.CreateZSet(result))
+	}
+	io.AddReplyNumber(client, int64(result.Len()))
+}
+
+// zunionInterStore ZUNIONSTORE与ZINTERSTORE的公共部分
+func zunionInterStore(client *core.RedisClient, op func([]*ZSet, []float64, int) *ZSet) (err error) {
+	req := client.ReqValue.Elems[1:]
+
+	if len(req) < 3 {
+		return errNotEnoughArgs
+	}
+
+	dest, keys, weights, aggregate, err := parseStoreArgs(req, true)
+	if err != nil {
+		return err
+	}
+	sets, err := lookupZSets(client.Db, keys)
+	if err != nil {
+		return err
+	}
+
+	storeZSet(client, dest, op(sets, weights, aggregate))
+	return
+}
+
+// ZUnionStore - 计算多个有序集合的并集并存入destination，支持WEIGHTS与AGGREGATE
+func ZUnionStore(client *core.RedisClient) (err error) {
+	return zunionInterStore(client, zset.ZSetUnion)
+}
+
+// ZInterStore - 计算多个有序集合的交集并存入destination，支持WEIGHTS与AGGREGATE
+func ZInterStore(client *core.RedisClient) (err error) {
+	return zunionInterStore(client, zset.ZSetInter)
+}
+
+// ZDiffStore - 计算第一个有序集合与其余集合的差集并存入destination
+func ZDiffStore(client *core.RedisClient) (err error) {
+	req := client.ReqValue.Elems[1:]
+
+	if len(req) < 3 {
+		return errNotEnoughArgs
+	}
+
+	dest, keys, _, _, err := parseStoreArgs(req, false)
+	if err != nil {
+		return err
+	}
+	sets, err := lookupZSets(client.Db, keys)
+	if err != nil {
+		return err
+	}
+
+	storeZSet(client, dest, zset.ZSetDiff(sets))
+	return
+}